@@ -19,6 +19,7 @@ uniform vec3  u_rotate_camera;    // Rotate camera
 uniform vec3  u_translate_obj;    // Translate object
 uniform vec3  u_translate_camera; // Translate camera
 uniform vec3  u_scale_obj;        // Scale object
+uniform float u_position_scale;   // Packed positions are in [-1, 1]
 
 const float front = 0.1f;
 const float back  = 30.f;
@@ -84,7 +85,7 @@ void main()
     mat4 model = scale_matrix(u_scale_obj) * translate_matrix(u_translate_obj) *
                  rotate_matrix(u_rotate_obj);
 
-    v_position = vec3(vec4(i_position, 1.) * model);
+    v_position = vec3(vec4(i_position * u_position_scale, 1.) * model);
 
     v_normal = normalize((vec4(i_normal, 0.f) * model).xyz);
 
@@ -14,8 +14,15 @@ const vec3  ambient          = ambient_strength * light_color;
 
 out vec4 o_color;
 
+// Permutations, see shader_feature in src/engine/shader.h:
+// LIGHTING    - ambient and diffuse, unlit texture without it
+// ATTENUATION - light fades with the distance
+// SPECULAR    - highlight from the light at the camera
 void main()
 {
+    vec4 color = texture(u_texture, v_tex_coord);
+
+#ifdef LIGHTING
     vec3 light_pos = camera_pos;
     vec3 v_normal_facing;
     if (gl_FrontFacing)
@@ -23,19 +30,27 @@ void main()
     else
         v_normal_facing = v_normal;
 
-    vec4 color = texture(u_texture, v_tex_coord);
-
     vec3  light_dir = normalize(light_pos - v_position);
     float diff      = max(dot(v_normal_facing, light_dir), 0.);
     vec3  diffuse   = diff * light_color;
 
+    vec3 light = ambient + diffuse;
+
+#ifdef SPECULAR
     float specular_strength = 0.9f;
     vec3  view_dir          = normalize(camera_pos - v_position);
     vec3  reflect_dir       = reflect(-light_dir, v_normal_facing);
+    float spec = pow(max(dot(view_dir, reflect_dir), 0.), 32.);
+    light += specular_strength * spec * light_color;
+#endif
 
+#ifdef ATTENUATION
     vec3 dist = v_position - light_pos;
+    light /= max(1., pow(length(dist), 0.25));
+#endif
 
-    vec3 result = (ambient + diffuse) / max(1., pow(length(dist), 0.25)) * color.xyz;
-
-    o_color = vec4(result, color.w);
+    o_color = vec4(light * color.xyz, color.w);
+#else
+    o_color = color;
+#endif
 }
\ No newline at end of file
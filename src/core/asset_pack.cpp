@@ -0,0 +1,353 @@
+#include "asset_pack.h"
+#include "trace.h"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif !defined(__ANDROID__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const asset_pack* asset_pack::current = nullptr;
+
+namespace
+{
+struct file_header
+{
+    uint32_t magic       = asset_pack_magic;
+    uint32_t version     = asset_pack_version;
+    uint32_t alignment   = asset_pack_alignment;
+    uint32_t entry_count = 0;
+};
+
+bool has_suffix(const std::string& name, const char* suffix)
+{
+    const size_t length = std::strlen(suffix);
+    return name.size() >= length &&
+           name.compare(name.size() - length, length, suffix) == 0;
+}
+} // namespace
+
+uint64_t hash_asset_name(const char* name)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const char* c = name; *c != '\0'; c++)
+    {
+        hash ^= static_cast<unsigned char>(*c == '\\' ? '/' : *c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+asset_format get_asset_format(const char* name)
+{
+    const std::string n(name);
+    if (has_suffix(n, ".png"))
+        return asset_format::png;
+    if (has_suffix(n, ".texc"))
+        return asset_format::texture_container;
+    if (has_suffix(n, ".mesh"))
+        return asset_format::mesh_blob;
+    if (has_suffix(n, ".obj"))
+        return asset_format::model;
+    if (has_suffix(n, ".vert") || has_suffix(n, ".frag"))
+        return asset_format::shader;
+    if (has_suffix(n, ".wav"))
+        return asset_format::wav;
+    if (has_suffix(n, ".ttf"))
+        return asset_format::font;
+    return asset_format::raw;
+}
+
+asset_pack::~asset_pack()
+{
+    close();
+}
+
+bool asset_pack::map(const char* path)
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path,
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+        return false;
+
+    data = static_cast<const std::byte*>(
+        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr)
+    {
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return false;
+    }
+    size = static_cast<size_t>(file_size.QuadPart);
+    return true;
+#elif defined(__ANDROID__)
+    (void)path;
+    return false;
+#else
+    const int file = ::open(path, O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        ::close(file);
+        return false;
+    }
+    void* view = mmap(nullptr,
+                      static_cast<size_t>(info.st_size),
+                      PROT_READ,
+                      MAP_PRIVATE,
+                      file,
+                      0);
+    ::close(file);
+    if (view == MAP_FAILED)
+        return false;
+
+    data = static_cast<const std::byte*>(view);
+    size = static_cast<size_t>(info.st_size);
+    return true;
+#endif
+}
+
+void asset_pack::unmap()
+{
+#if defined(_WIN32)
+    if (mapping != nullptr)
+    {
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+#elif !defined(__ANDROID__)
+    if (data != nullptr && storage.ptr == nullptr)
+        munmap(const_cast<std::byte*>(data), size);
+#endif
+}
+
+bool asset_pack::open(const char* path)
+{
+    TRACE_ZONE("asset_pack::open");
+
+    close();
+    if (!map(path))
+    {
+        SDL_RWops* file = SDL_RWFromFile(path, "rb");
+        if (file == nullptr)
+            return false;
+        file->close(file);
+
+        // Readable but not mappable, one copy of the whole pack
+        storage = load_file_to_memory(path);
+        data    = reinterpret_cast<const std::byte*>(storage.ptr.get());
+        size    = storage.size;
+    }
+
+    file_header header;
+    if (size < sizeof(header))
+    {
+        close();
+        throw std::runtime_error("truncated asset pack: " + std::string(path));
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    const size_t index_end =
+        sizeof(header) + size_t(header.entry_count) * sizeof(entry);
+    if (header.magic != asset_pack_magic ||
+        header.version != asset_pack_version ||
+        header.alignment != asset_pack_alignment || index_end > size)
+    {
+        close();
+        throw std::runtime_error("bad asset pack: " + std::string(path));
+    }
+
+    entries     = reinterpret_cast<const entry*>(data + sizeof(header));
+    entry_count = header.entry_count;
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        const entry& e = entries[i];
+        if (e.offset < index_end || e.offset > size ||
+            e.size > size - e.offset)
+        {
+            close();
+            throw std::runtime_error("bad asset pack entry: " +
+                                     std::string(path));
+        }
+    }
+
+    std::cout << "asset pack: " << path << ", " << entry_count << " assets, "
+              << size / 1024 << " KiB"
+              << (storage.ptr == nullptr ? " mapped" : " read") << std::endl;
+    return true;
+}
+
+void asset_pack::close()
+{
+    unmap();
+    storage     = membuff{};
+    data        = nullptr;
+    size        = 0;
+    entries     = nullptr;
+    entry_count = 0;
+}
+
+bool asset_pack::find(const char* name, asset_view& result) const
+{
+    const uint64_t hash  = hash_asset_name(name);
+    const entry*   first = entries;
+    const entry*   last  = entries + entry_count;
+    const entry*   it =
+        std::lower_bound(first,
+                         last,
+                         hash,
+                         [](const entry& e, uint64_t h)
+                         { return e.name_hash < h; });
+    if (it == last || it->name_hash != hash)
+        return false;
+
+    result.data   = data + it->offset;
+    result.size   = static_cast<size_t>(it->size);
+    result.format = static_cast<asset_format>(it->format);
+    return true;
+}
+
+asset_view load_asset(const char* path, membuff& storage)
+{
+    asset_view result;
+    if (asset_pack::get_current() != nullptr &&
+        asset_pack::get_current()->find(path, result))
+    {
+        return result;
+    }
+
+    storage       = load_file_to_memory(path);
+    result.data   = reinterpret_cast<const std::byte*>(storage.ptr.get());
+    result.size   = storage.size;
+    result.format = get_asset_format(path);
+    return result;
+}
+
+bool try_load_asset(const char* path, membuff& storage, asset_view& result)
+{
+    if (asset_pack::get_current() != nullptr &&
+        asset_pack::get_current()->find(path, result))
+    {
+        return true;
+    }
+
+    SDL_RWops* file = SDL_RWFromFile(path, "rb");
+    if (file == nullptr)
+        return false;
+    file->close(file);
+
+    result = load_asset(path, storage);
+    return true;
+}
+
+SDL_RWops* open_asset(const char* path)
+{
+    asset_view view;
+    if (asset_pack::get_current() != nullptr &&
+        asset_pack::get_current()->find(path, view))
+    {
+        return SDL_RWFromConstMem(view.data, view.size);
+    }
+    return SDL_RWFromFile(path, "rb");
+}
+
+void write_asset_pack(const char*                           path,
+                      const std::vector<std::string>&       names,
+                      const std::vector<std::vector<char>>& payloads)
+{
+    using entry = asset_pack::entry;
+
+    file_header header;
+    header.entry_count = static_cast<uint32_t>(names.size());
+
+    std::vector<size_t> order(names.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::vector<entry> index(names.size());
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        index[i].name_hash = hash_asset_name(names[i].c_str());
+        index[i].format =
+            static_cast<uint32_t>(get_asset_format(names[i].c_str()));
+        index[i].reserved = 0;
+    }
+    std::sort(order.begin(),
+              order.end(),
+              [&](size_t a, size_t b)
+              { return index[a].name_hash < index[b].name_hash; });
+    for (size_t i = 1; i < order.size(); i++)
+    {
+        if (index[order[i]].name_hash == index[order[i - 1]].name_hash)
+            throw std::runtime_error("asset name hash collision: " +
+                                     names[order[i]]);
+    }
+
+    auto align = [](uint64_t offset)
+    {
+        return (offset + asset_pack_alignment - 1) / asset_pack_alignment *
+               asset_pack_alignment;
+    };
+
+    uint64_t offset = sizeof(header) + names.size() * sizeof(entry);
+    for (size_t i : order)
+    {
+        offset          = align(offset);
+        index[i].offset = offset;
+        index[i].size   = payloads[i].size();
+        offset += payloads[i].size();
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (size_t i : order)
+        file.write(reinterpret_cast<const char*>(&index[i]), sizeof(entry));
+
+    uint64_t written = sizeof(header) + names.size() * sizeof(entry);
+    for (size_t i : order)
+    {
+        const std::vector<char> padding(index[i].offset - written, 0);
+        file.write(padding.data(),
+                   static_cast<std::streamsize>(padding.size()));
+        file.write(payloads[i].data(),
+                   static_cast<std::streamsize>(payloads[i].size()));
+        written = index[i].offset + payloads[i].size();
+    }
+
+    if (!file)
+        throw std::runtime_error("can't write asset pack: " +
+                                 std::string(path));
+}
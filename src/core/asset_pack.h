@@ -0,0 +1,105 @@
+#pragma once
+#include "types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SDL_RWops;
+
+// All of res/ in one file, written by tools/asset_packer. At runtime the
+// file is memory mapped and assets are views into the mapping, nothing is
+// copied per asset.
+//
+// layout: header, entries sorted by name_hash, payloads aligned to
+// asset_pack_alignment
+constexpr uint32_t asset_pack_magic     = 0x4B503354; // "T3PK"
+constexpr uint32_t asset_pack_version   = 1;
+constexpr uint32_t asset_pack_alignment = 64;
+
+enum class asset_format : uint32_t
+{
+    raw,
+    png,
+    texture_container, // .texc
+    mesh_blob,         // .mesh
+    model,             // .obj
+    shader,            // .vert, .frag
+    wav,
+    font, // .ttf
+};
+
+// Non-owning view, valid while the pack or membuff it points into lives
+struct asset_view
+{
+    const std::byte* data   = nullptr;
+    size_t           size   = 0;
+    asset_format     format = asset_format::raw;
+};
+
+// FNV-1a of the path as the game spells it, "res/models/cube.obj".
+// Backslashes hash as slashes.
+uint64_t     hash_asset_name(const char* name);
+asset_format get_asset_format(const char* name);
+
+class asset_pack
+{
+public:
+    // On disk index record
+    struct entry
+    {
+        uint64_t name_hash;
+        uint64_t offset;
+        uint64_t size;
+        uint32_t format;
+        uint32_t reserved;
+    };
+
+    asset_pack() = default;
+    ~asset_pack();
+    asset_pack(const asset_pack&) = delete;
+    asset_pack& operator=(const asset_pack&) = delete;
+
+    // False when the file is missing, throws when it is malformed
+    bool open(const char* path);
+    void close();
+
+    bool   find(const char* name, asset_view& result) const;
+    size_t get_asset_count() const { return entry_count; }
+
+    // Assets are looked up here first, nullptr reads loose files only
+    static const asset_pack* get_current() { return current; }
+    static void set_current(const asset_pack* p) { current = p; }
+
+private:
+    bool map(const char* path);
+    void unmap();
+
+    const std::byte* data        = nullptr;
+    size_t           size        = 0;
+    const entry*     entries     = nullptr;
+    size_t           entry_count = 0;
+
+    // Fallback where mapping is not possible (Android assets live in the apk)
+    membuff storage;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+
+    static const asset_pack* current;
+};
+
+// The asset from the current pack, else the loose file read into storage.
+// Throws when neither exists.
+asset_view load_asset(const char* path, membuff& storage);
+// Same, but false when neither exists
+bool try_load_asset(const char* path, membuff& storage, asset_view& result);
+
+// SDL_RWops over the packed asset, else over the loose file. nullptr when
+// neither exists.
+SDL_RWops* open_asset(const char* path);
+
+void write_asset_pack(const char*                           path,
+                      const std::vector<std::string>&       names,
+                      const std::vector<std::vector<char>>& payloads);
@@ -0,0 +1,177 @@
+#include "audio_mix.h"
+#include "simd.h"
+
+#include <algorithm>
+#include <cmath>
+
+void mix_add(float*       bus,
+             const float* src,
+             size_t       frames,
+             uint32_t     channels,
+             float        gain,
+             float        pan)
+{
+    const bool  is_stereo = channels == 2;
+    const float left  = is_stereo ? gain * std::min(1.f, 1.f - pan) : gain;
+    const float right = is_stereo ? gain * std::min(1.f, 1.f + pan) : gain;
+
+    // Vectors start on even samples, so a stereo pattern stays in place
+    const size_t samples = frames * channels;
+    const float4 gains(left, right, left, right);
+    size_t       i = 0;
+    for (; i + 4 <= samples; i += 4)
+    {
+        const float4 x = float4::load(src + i) * gains;
+        (float4::load(bus + i) + x).store(bus + i);
+    }
+    for (; i < samples; i++)
+        bus[i] += src[i] * (i % 2 == 0 ? left : right);
+}
+
+float mix_peak(const float* bus, size_t samples)
+{
+    const float4 zero(0.f);
+    float4       peak(0.f);
+    size_t       i = 0;
+    for (; i + 4 <= samples; i += 4)
+    {
+        const float4 x = float4::load(bus + i);
+        peak           = max(peak, max(x, zero - x));
+    }
+
+    float lanes[4];
+    peak.store(lanes);
+    float result = std::max(std::max(lanes[0], lanes[1]),
+                            std::max(lanes[2], lanes[3]));
+    for (; i < samples; i++)
+        result = std::max(result, std::fabs(bus[i]));
+    return result;
+}
+
+static void convert_s16(const float* bus, size_t samples, int16_t* out)
+{
+    const float4 lo(-1.f);
+    const float4 hi(1.f);
+    const float4 scale(32767.f);
+    size_t       i = 0;
+#if defined(USE_SIMD_SSE2) || defined(USE_SIMD_NEON)
+    for (; i + 8 <= samples; i += 8)
+    {
+        const float4 a = min(max(float4::load(bus + i), lo), hi) * scale;
+        const float4 b = min(max(float4::load(bus + i + 4), lo), hi) * scale;
+#if defined(USE_SIMD_SSE2)
+        // Round to nearest, like lrint() below
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(out + i),
+            _mm_packs_epi32(_mm_cvtps_epi32(a.v), _mm_cvtps_epi32(b.v)));
+#elif defined(__aarch64__)
+        vst1q_s16(out + i,
+                  vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a.v)),
+                               vqmovn_s32(vcvtnq_s32_f32(b.v))));
+#else
+        // ARMv7 has no rounding conversion, off by one at most
+        vst1q_s16(out + i,
+                  vcombine_s16(vqmovn_s32(vcvtq_s32_f32(a.v)),
+                               vqmovn_s32(vcvtq_s32_f32(b.v))));
+#endif
+    }
+#endif
+    for (; i < samples; i++)
+    {
+        const float x = std::clamp(bus[i], -1.f, 1.f);
+        out[i]        = static_cast<int16_t>(std::lrint(x * 32767.f));
+    }
+}
+
+void mix_convert(const float*  bus,
+                 size_t        samples,
+                 sample_format format,
+                 void*         out)
+{
+    switch (format)
+    {
+        case sample_format::s16:
+            convert_s16(bus, samples, static_cast<int16_t*>(out));
+            return;
+        case sample_format::f32:
+        {
+            auto*        dst = static_cast<float*>(out);
+            const float4 lo(-1.f);
+            const float4 hi(1.f);
+            size_t       i = 0;
+            for (; i + 4 <= samples; i += 4)
+                min(max(float4::load(bus + i), lo), hi).store(dst + i);
+            for (; i < samples; i++)
+                dst[i] = std::clamp(bus[i], -1.f, 1.f);
+            return;
+        }
+        case sample_format::s32:
+        {
+            // Through double, 2^31 - 1 is not a float
+            auto* dst = static_cast<int32_t*>(out);
+            for (size_t i = 0; i < samples; i++)
+            {
+                const double x = std::clamp(bus[i], -1.f, 1.f);
+                dst[i] = static_cast<int32_t>(std::lrint(x * 2147483647.0));
+            }
+            return;
+        }
+        case sample_format::u8:
+        {
+            auto* dst = static_cast<uint8_t*>(out);
+            for (size_t i = 0; i < samples; i++)
+            {
+                const float x = std::clamp(bus[i], -1.f, 1.f);
+                dst[i] = static_cast<uint8_t>(std::lrint(x * 127.f) + 128);
+            }
+            return;
+        }
+    }
+}
+
+audio_limiter::audio_limiter(uint32_t freq, float threshold, float release_ms)
+    : threshold(threshold)
+    , release_per_frame(1000.f / (std::max(release_ms, 1.f) * freq))
+{
+}
+
+void audio_limiter::process(float* bus, size_t frames, uint32_t channels)
+{
+    const size_t samples = frames * channels;
+    if (samples == 0)
+        return;
+    const float peak  = mix_peak(bus, samples);
+    const float limit = peak > threshold ? threshold / peak : 1.f;
+    if (limit == 1.f && gain == 1.f)
+        return; // Under the threshold and fully released
+
+    float4 gains;
+    float4 step;
+    if (limit <= gain)
+    {
+        // Attack at once, the whole block under the threshold
+        gain  = limit;
+        gains = float4(gain);
+        step  = float4(0.f);
+    }
+    else
+    {
+        // Release as a ramp, one step per sample
+        const float end = std::min(limit, gain + release_per_frame * frames);
+        const float s   = (end - gain) / static_cast<float>(samples);
+        gains           = float4(gain, gain + s, gain + 2 * s, gain + 3 * s);
+        step            = float4(4 * s);
+        gain            = end;
+    }
+
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4)
+    {
+        (float4::load(bus + i) * gains).store(bus + i);
+        gains = gains + step;
+    }
+    float rest[4];
+    gains.store(rest);
+    for (size_t lane = 0; i < samples; i++, lane++)
+        bus[i] *= rest[lane];
+}
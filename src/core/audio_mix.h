@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Float mixing bus kernels. Voices are added into an interleaved float bus,
+// the bus is limited and then converted to the output format once. SSE2 or
+// NEON through core/simd.h, plain C++ elsewhere. No SDL or engine here, so
+// tools and tests can call them directly.
+
+enum class sample_format : uint8_t
+{
+    u8,
+    s16,
+    s32,
+    f32
+};
+
+// Adds frames of src into bus, both interleaved with the same channel
+// count. pan from -1 (left) to 1 (right) lowers the opposite side of a
+// stereo bus only, the center plays at full gain. Other layouts ignore it.
+void mix_add(float*       bus,
+             const float* src,
+             size_t       frames,
+             uint32_t     channels,
+             float        gain,
+             float        pan);
+
+// Largest absolute sample
+float mix_peak(const float* bus, size_t samples);
+
+// Clamps to [-1, 1] and writes samples in format to out
+void mix_convert(const float*  bus,
+                 size_t        samples,
+                 sample_format format,
+                 void*         out);
+
+// Audio thread timing as shown by the profiler overlay. Maxima decay and
+// the fill recovers over a few seconds, so a spike stays readable.
+struct audio_stats
+{
+    const char* backend         = "null"; // device, offline or null
+    uint32_t    buffer_frames   = 0;      // Per callback
+    float       budget_ms       = 0.f;    // Duration of buffer_frames
+    float       callback_ms     = 0.f;    // Smoothed mix time
+    float       max_callback_ms = 0.f;
+    float       music_fill      = -1.f; // Lowest ring fill 0-1, -1 for none
+    uint64_t    callbacks       = 0;
+    uint32_t    underruns       = 0; // Music reads the decoder fell behind on
+    uint32_t    over_budget     = 0; // Callbacks longer than budget_ms
+};
+
+// Peak limiter for the bus before conversion. A block whose peak is over
+// the threshold is scaled down at once, the gain recovers over release_ms.
+// No look-ahead, whatever still overshoots is clipped by mix_convert().
+class audio_limiter
+{
+public:
+    audio_limiter(uint32_t freq,
+                  float    threshold  = 0.95f,
+                  float    release_ms = 200.f);
+
+    void process(float* bus, size_t frames, uint32_t channels);
+
+    float get_gain() const { return gain; }
+
+private:
+    float threshold;
+    float release_per_frame; // Gain recovered per frame
+    float gain = 1.f;
+};
@@ -1,4 +1,23 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Caps the scene shader features, lower levels are cheaper per fragment
+enum class shader_quality
+{
+    low,    // Unlit, texture only
+    medium, // Ambient and diffuse
+    high,   // Plus distance attenuation
+    ultra   // Plus specular
+};
+
+// Where the mixed audio goes
+enum class audio_backend
+{
+    device, // The system default output, null when it fails to open
+    null,   // Mixed at the device pace, the result is dropped
+    offline // Mixed at the device pace into config::audio_offline_path
+};
 
 struct config
 {
@@ -17,12 +36,50 @@ struct config
     const char* sound_collision        = "res/sounds/collision.wav";
     const char* model_board            = "res/models/board.obj";
     const char* model_cube             = "res/models/cube.obj";
+    const char* shader_cache_path      = "shader_cache"; // nullptr disables
+    const char* asset_pack_path        = "assets.pack";  // nullptr disables
 
     float width          = 1600 - 100;
     float height         = 900 - 100;
     bool  is_full_screen = true;
 
+    shader_quality quality = shader_quality::high;
+
+    bool compact_vertices = true; // 16 byte vertex3d_packed meshes
+
+    float upload_budget_ms  = 4.f;   // Per frame, while the game assets load
+    float startup_budget_ms = 200.f; // Start to menu, logged as over past it
+
+    audio_backend audio               = audio_backend::device;
+    const char*   audio_offline_path  = "audio_offline.wav";
+    uint32_t      audio_buffer_frames = 1024; // Per callback, power of 2
+
+    // Shaders, textures and models written on disk are reloaded in game.
+    // Reads loose files, the asset pack is not opened.
+    bool hot_reload = false;
+
+    // Per frame vertex data is written to a ring of frames_in_flight fenced
+    // regions, indexes get a quarter of stream_buffer_kib
+    uint32_t frames_in_flight  = 3;
+    size_t   stream_buffer_kib = 1024;
+
+    bool  dynamic_resolution   = true; // Scene scale follows the frame time
+    float target_frame_ms      = 1000.f / 60.f;
+    float min_resolution_scale = 0.5f;
+    float max_resolution_scale = 1.f;
+
     float camera_speed_rotate    = 1. / 100.;
     float camera_speed           = 0.05;
     float max_camera_speed_swipe = 10;
+
+    float simulation_rate = 60;    // Game ticks per second
+    bool  show_profiler   = false; // Frame profiler overlay, F1 toggles
+
+    unsigned software_render_threads = 0; // 0 - all hardware threads
+
+    bool        is_headless      = false;   // Offscreen FBO, no window or
+                                            // device audio
+    const char* replay_path      = nullptr; // Scripted input, see core/replay.h
+    const char* frame_times_path = nullptr; // Per-frame CPU times in CSV
+    const char* trace_path       = nullptr; // Chrome trace JSON, F2 toggles
 };
\ No newline at end of file
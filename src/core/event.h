@@ -46,6 +46,10 @@ struct event
         uint8_t up_released : 1;
         uint8_t down_clicked : 1;
         uint8_t down_released : 1;
+        uint8_t f1_clicked : 1;
+        uint8_t f1_released : 1;
+        uint8_t f2_clicked : 1;
+        uint8_t f2_released : 1;
     } keyboard;
 
     struct event_action
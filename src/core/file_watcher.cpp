@@ -0,0 +1,149 @@
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <iostream>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+file_watcher::file_watcher(const std::vector<std::string>& directories,
+                           clock::duration                 poll_interval)
+    : directories(directories)
+    , poll_interval(poll_interval)
+    , next_poll(clock::now() + poll_interval)
+{
+    if (start_inotify())
+        return;
+
+    // Times of what is there now, so only later writes are reported
+    scan(nullptr);
+    std::cout << "file watcher: polling every "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     poll_interval)
+                     .count()
+              << " ms" << std::endl;
+}
+
+file_watcher::~file_watcher()
+{
+#ifdef __linux__
+    if (inotify_fd >= 0)
+        close(inotify_fd);
+#endif
+}
+
+std::vector<std::string> file_watcher::get_changes()
+{
+    std::vector<std::string> changes;
+    if (!is_polling())
+    {
+        read_events(changes);
+    }
+    else if (clock::now() >= next_poll)
+    {
+        next_poll = clock::now() + poll_interval;
+        scan(&changes);
+    }
+
+    // An editor may write a file several times per save
+    std::sort(changes.begin(), changes.end());
+    changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+    return changes;
+}
+
+bool file_watcher::start_inotify()
+{
+#ifdef __linux__
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0)
+    {
+        std::cerr << "file watcher: no inotify, errno " << errno << std::endl;
+        return false;
+    }
+
+    // Close after write catches plain saves, moved to the editors that
+    // write a temporary file and rename it over the original
+    for (const std::string& directory : directories)
+    {
+        const int wd = inotify_add_watch(
+            inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0)
+        {
+            std::cerr << "file watcher: can't watch " << directory
+                      << ", errno " << errno << std::endl;
+            close(inotify_fd);
+            inotify_fd = -1;
+            watched.clear();
+            return false;
+        }
+        watched[wd] = directory;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void file_watcher::read_events(std::vector<std::string>& changes)
+{
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        const ssize_t size = read(inotify_fd, buffer, sizeof(buffer));
+        if (size <= 0)
+            return; // EAGAIN, nothing more queued
+
+        for (ssize_t offset = 0; offset < size;)
+        {
+            const auto* event =
+                reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                std::cerr << "file watcher: events lost" << std::endl;
+                continue;
+            }
+            auto it = watched.find(event->wd);
+            if (it == watched.end() || event->len == 0)
+                continue;
+            changes.push_back(it->second + '/' + event->name);
+        }
+    }
+#else
+    (void)changes;
+#endif
+}
+
+void file_watcher::scan(std::vector<std::string>* changes)
+{
+    for (const std::string& directory : directories)
+    {
+        std::error_code ec;
+        for (fs::directory_iterator it(directory, ec), end; !ec && it != end;
+             it.increment(ec))
+        {
+            std::error_code file_ec; // A file removed meanwhile is skipped
+            if (!it->is_regular_file(file_ec))
+                continue;
+            const fs::file_time_type time = it->last_write_time(file_ec);
+            if (file_ec)
+                continue;
+
+            const std::string path =
+                directory + '/' + it->path().filename().string();
+            auto [entry, is_new] = times.try_emplace(path, time);
+            if (!is_new && entry->second == time)
+                continue;
+            entry->second = time;
+            if (changes != nullptr)
+                changes->push_back(path);
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports files written in a set of directories, not recursively. inotify
+// on Linux, elsewhere or when it is unavailable the directories are scanned
+// for newer modification times every poll_interval.
+class file_watcher
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit file_watcher(const std::vector<std::string>& directories,
+                          clock::duration                 poll_interval =
+                              std::chrono::milliseconds(250));
+    ~file_watcher();
+
+    file_watcher(const file_watcher&)            = delete;
+    file_watcher& operator=(const file_watcher&) = delete;
+
+    // Paths ("directory/name") written since the last call, each once.
+    // Never blocks, cheap enough to call every frame.
+    std::vector<std::string> get_changes();
+
+    bool is_polling() const { return inotify_fd < 0; }
+
+private:
+    bool start_inotify();
+    void read_events(std::vector<std::string>& changes);
+    void scan(std::vector<std::string>* changes);
+
+    std::vector<std::string> directories;
+    clock::duration          poll_interval;
+    clock::time_point        next_poll;
+
+    // Polling: last seen modification time of each file
+    std::unordered_map<std::string, std::filesystem::file_time_type> times;
+
+    int                                  inotify_fd = -1;
+    std::unordered_map<int, std::string> watched; // Watch descriptor -> dir
+};
@@ -0,0 +1,54 @@
+#include "frame_profiler.h"
+
+#include <algorithm>
+#include <vector>
+
+void frame_profiler::set_enabled(bool state)
+{
+    if (state == enabled)
+        return;
+
+    enabled       = state;
+    frame_start   = clock::now();
+    history_next  = 0;
+    history_count = 0;
+    stage_ms.fill(0.f);
+}
+
+void frame_profiler::begin_frame()
+{
+    if (!enabled)
+        return;
+
+    const clock::time_point now = clock::now();
+
+    history[history_next] = milliseconds(now - frame_start);
+    history_next          = (history_next + 1) % history_size;
+    history_count         = std::min(history_count + 1, history_size);
+
+    frame_start = now;
+}
+
+const char* frame_profiler::get_stage_name(stage s)
+{
+    static const char* names[] = { "events", "update", "scene", "ui", "swap" };
+    return names[index(s)];
+}
+
+void frame_profiler::get_percentiles(float& p50, float& p95, float& p99) const
+{
+    p50 = p95 = p99 = 0.f;
+    if (history_count == 0)
+        return;
+
+    std::vector<float> sorted(history.begin(),
+                              history.begin() + history_count);
+    std::sort(sorted.begin(), sorted.end());
+
+    auto at = [&](float p)
+    { return sorted[static_cast<size_t>(p * (sorted.size() - 1) + 0.5f)]; };
+
+    p50 = at(0.50f);
+    p95 = at(0.95f);
+    p99 = at(0.99f);
+}
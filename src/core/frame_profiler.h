@@ -0,0 +1,78 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// CPU time per frame stage plus a rolling history of whole frame times.
+// Every call is a single branch while the profiler is disabled.
+class frame_profiler
+{
+public:
+    enum class stage : uint8_t
+    {
+        events,
+        update,
+        scene,
+        ui,
+        swap,
+        count
+    };
+
+    static constexpr size_t history_size = 240;
+
+    void set_enabled(bool state);
+    bool is_enabled() const { return enabled; }
+
+    // Call once per frame, the time since the previous call is the frame time
+    void begin_frame();
+
+    void begin(stage s)
+    {
+        if (enabled)
+            starts[index(s)] = clock::now();
+    }
+    void end(stage s)
+    {
+        if (enabled)
+            stage_ms[index(s)] = milliseconds(clock::now() - starts[index(s)]);
+    }
+    // For stages measured elsewhere, e.g. on the simulation thread
+    void set_stage_ms(stage s, float ms)
+    {
+        if (enabled)
+            stage_ms[index(s)] = ms;
+    }
+
+    float get_stage_ms(stage s) const { return stage_ms[index(s)]; }
+    static const char* get_stage_name(stage s);
+
+    // Ring of frame times in ms, the oldest is at get_history_offset()
+    const float* get_history() const { return history.data(); }
+    size_t       get_history_count() const { return history_count; }
+    size_t       get_history_offset() const
+    {
+        return history_count < history_size ? 0 : history_next;
+    }
+
+    void get_percentiles(float& p50, float& p95, float& p99) const;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    static size_t index(stage s) { return static_cast<size_t>(s); }
+    static float  milliseconds(clock::duration d)
+    {
+        return std::chrono::duration<float, std::milli>(d).count();
+    }
+
+    bool enabled = false;
+
+    clock::time_point frame_start;
+    std::array<clock::time_point, static_cast<size_t>(stage::count)> starts;
+    std::array<float, static_cast<size_t>(stage::count)> stage_ms{};
+
+    std::array<float, history_size> history{};
+    size_t                          history_next  = 0;
+    size_t                          history_count = 0;
+};
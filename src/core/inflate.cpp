@@ -0,0 +1,406 @@
+#include "inflate.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+constexpr int      fast_bits   = 10;
+constexpr uint32_t fast_size   = 1u << fast_bits;
+constexpr int      max_symbols = 288;
+
+// Canonical Huffman code. Codes up to fast_bits long are decoded with one
+// table lookup, longer ones by comparing against the last code per length.
+struct huffman
+{
+    uint16_t fast[fast_size]; // (length << 9) | symbol, 0 for the slow path
+    uint16_t first_code[16];
+    uint16_t first_symbol[16];
+    uint32_t max_code[17]; // One past the last code per length, 16 bit aligned
+    uint8_t  lengths[max_symbols]; // By canonical order
+    uint16_t symbols[max_symbols];
+};
+
+uint32_t reverse_bits(uint32_t v, int bits)
+{
+    v = ((v & 0xAAAA) >> 1) | ((v & 0x5555) << 1);
+    v = ((v & 0xCCCC) >> 2) | ((v & 0x3333) << 2);
+    v = ((v & 0xF0F0) >> 4) | ((v & 0x0F0F) << 4);
+    v = ((v & 0xFF00) >> 8) | ((v & 0x00FF) << 8);
+    return v >> (16 - bits);
+}
+
+void build_huffman(huffman& h, const uint8_t* code_lengths, int count)
+{
+    int sizes[16] = {};
+    for (int i = 0; i < count; i++)
+        sizes[code_lengths[i]]++;
+    sizes[0] = 0;
+
+    std::memset(h.fast, 0, sizeof(h.fast));
+    std::memset(h.lengths, 0, sizeof(h.lengths));
+
+    int next_code[16] = {};
+    int code          = 0;
+    int symbol        = 0;
+    for (int length = 1; length < 16; length++)
+    {
+        next_code[length]      = code;
+        h.first_code[length]   = static_cast<uint16_t>(code);
+        h.first_symbol[length] = static_cast<uint16_t>(symbol);
+        code += sizes[length];
+        if (sizes[length] && code - 1 >= (1 << length))
+            throw std::runtime_error("inflate: bad code lengths");
+        h.max_code[length] = static_cast<uint32_t>(code) << (16 - length);
+        code <<= 1;
+        symbol += sizes[length];
+    }
+    h.max_code[16] = 0x10000;
+
+    for (int i = 0; i < count; i++)
+    {
+        const int length = code_lengths[i];
+        if (length == 0)
+            continue;
+
+        const int pos = next_code[length] - h.first_code[length] +
+                        h.first_symbol[length];
+        h.lengths[pos] = static_cast<uint8_t>(length);
+        h.symbols[pos] = static_cast<uint16_t>(i);
+        if (length <= fast_bits)
+        {
+            // Every fast index whose low bits are this code
+            const auto entry = static_cast<uint16_t>((length << 9) | i);
+            for (uint32_t j = reverse_bits(next_code[length], length);
+                 j < fast_size;
+                 j += 1u << length)
+            {
+                h.fast[j] = entry;
+            }
+        }
+        next_code[length]++;
+    }
+}
+
+// LSB first bit buffer over the input spans. Bytes past the end read as
+// zeros and are counted, is_truncated() tells if any of them were used.
+class bit_reader
+{
+public:
+    explicit bit_reader(const std::vector<byte_span>& input)
+        : spans(input)
+    {
+        next_span();
+    }
+
+    uint32_t get(int n)
+    {
+        if (count < n)
+            refill();
+        const auto value = static_cast<uint32_t>(bits & ((1ull << n) - 1));
+        consume(n);
+        return value;
+    }
+
+    int decode(const huffman& h)
+    {
+        if (count < 16)
+            refill();
+        const uint16_t entry = h.fast[bits & (fast_size - 1)];
+        if (entry != 0)
+        {
+            consume(entry >> 9);
+            return entry & 511;
+        }
+
+        const uint32_t code   = reverse_bits(bits & 0xFFFF, 16);
+        int            length = fast_bits + 1;
+        while (code >= h.max_code[length])
+            length++;
+        if (length >= 16)
+            throw std::runtime_error("inflate: bad code");
+        const uint32_t pos = (code >> (16 - length)) - h.first_code[length] +
+                             h.first_symbol[length];
+        if (pos >= max_symbols || h.lengths[pos] != length)
+            throw std::runtime_error("inflate: bad code");
+        consume(length);
+        return h.symbols[pos];
+    }
+
+    void align_to_byte() { consume(count & 7); }
+
+    // After align_to_byte(), buffered bytes first
+    void read_bytes(uint8_t* out, size_t size)
+    {
+        for (; size > 0 && count >= 8; size--)
+        {
+            *out++ = static_cast<uint8_t>(bits);
+            consume(8);
+        }
+        if (size > 0)
+            bits = 0; // Drops the partial byte read ahead from pos
+        while (size > 0)
+        {
+            if (pos == end && !next_span())
+                throw std::runtime_error("inflate: truncated stream");
+            const size_t n = std::min(size, static_cast<size_t>(end - pos));
+            std::memcpy(out, pos, n);
+            out += n;
+            pos += n;
+            size -= n;
+        }
+    }
+
+    bool is_truncated() const { return padding * 8 > size_t(count); }
+
+private:
+    void consume(int n)
+    {
+        bits >>= n;
+        count -= n;
+    }
+
+    void refill()
+    {
+        if (end - pos >= 8)
+        {
+            // Whole bytes that fit, the partial top byte is read again next
+            // time with the same value. Little endian targets only.
+            uint64_t v;
+            std::memcpy(&v, pos, sizeof(v));
+            bits |= v << count;
+            pos += (63 - count) >> 3;
+            count |= 56;
+            return;
+        }
+        while (count <= 56)
+        {
+            if (pos == end && !next_span())
+            {
+                padding++;
+                count += 8;
+                continue;
+            }
+            bits |= uint64_t(*pos++) << count;
+            count += 8;
+        }
+    }
+
+    bool next_span()
+    {
+        while (span_index < spans.size())
+        {
+            const byte_span& span = spans[span_index++];
+            if (span.size > 0)
+            {
+                pos = span.data;
+                end = span.data + span.size;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const std::vector<byte_span>& spans;
+    size_t                        span_index = 0;
+    const uint8_t*                pos        = nullptr;
+    const uint8_t*                end        = nullptr;
+    uint64_t                      bits       = 0;
+    int                           count      = 0;
+    size_t                        padding    = 0;
+};
+
+const uint16_t length_base[29] = { 3,  4,  5,  6,   7,   8,   9,   10,
+                                   11, 13, 15, 17,  19,  23,  27,  31,
+                                   35, 43, 51, 59,  67,  83,  99,  115,
+                                   131, 163, 195, 227, 258 };
+const uint8_t  length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                    1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                    4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const uint16_t dist_base[30]    = { 1,    2,    3,    4,     5,     7,
+                                    9,    13,   17,   25,    33,    49,
+                                    65,   97,   129,  193,   257,   385,
+                                    513,  769,  1025, 1537,  2049,  3073,
+                                    4097, 6145, 8193, 12289, 16385, 24577 };
+const uint8_t  dist_extra[30]   = { 0, 0, 0, 0, 1, 1, 2,  2,  3,  3,
+                                    4, 4, 5, 5, 6, 6, 7,  7,  8,  8,
+                                    9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+struct fixed_codes
+{
+    huffman literals;
+    huffman distances;
+
+    fixed_codes()
+    {
+        uint8_t lengths[max_symbols];
+        std::memset(lengths, 8, 144);
+        std::memset(lengths + 144, 9, 112);
+        std::memset(lengths + 256, 7, 24);
+        std::memset(lengths + 280, 8, 8);
+        build_huffman(literals, lengths, max_symbols);
+
+        std::memset(lengths, 5, 30);
+        build_huffman(distances, lengths, 30);
+    }
+};
+
+void read_dynamic_codes(bit_reader& in, huffman& literals, huffman& distances)
+{
+    static const uint8_t order[19] = { 16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                       11, 4,  12, 3, 13, 2, 14, 1, 15 };
+
+    const int literal_count  = static_cast<int>(in.get(5)) + 257;
+    const int distance_count = static_cast<int>(in.get(5)) + 1;
+    const int length_count   = static_cast<int>(in.get(4)) + 4;
+    if (literal_count > 286 || distance_count > 30)
+        throw std::runtime_error("inflate: bad code counts");
+
+    uint8_t code_lengths[19] = {};
+    for (int i = 0; i < length_count; i++)
+        code_lengths[order[i]] = static_cast<uint8_t>(in.get(3));
+    huffman lengths_code;
+    build_huffman(lengths_code, code_lengths, 19);
+
+    uint8_t   lengths[286 + 30];
+    const int total = literal_count + distance_count;
+    for (int n = 0; n < total;)
+    {
+        const int code = in.decode(lengths_code);
+        if (code < 16)
+        {
+            lengths[n++] = static_cast<uint8_t>(code);
+            continue;
+        }
+
+        uint8_t  fill   = 0;
+        uint32_t repeat = 0;
+        if (code == 16)
+        {
+            if (n == 0)
+                throw std::runtime_error("inflate: bad code lengths");
+            fill   = lengths[n - 1];
+            repeat = 3 + in.get(2);
+        }
+        else if (code == 17)
+            repeat = 3 + in.get(3);
+        else
+            repeat = 11 + in.get(7);
+
+        if (n + repeat > uint32_t(total))
+            throw std::runtime_error("inflate: bad code lengths");
+        std::memset(lengths + n, fill, repeat);
+        n += repeat;
+    }
+    if (lengths[256] == 0)
+        throw std::runtime_error("inflate: no end of block code");
+
+    build_huffman(literals, lengths, literal_count);
+    build_huffman(distances, lengths + literal_count, distance_count);
+}
+
+size_t inflate_block(bit_reader&    in,
+                     const huffman& literals,
+                     const huffman& distances,
+                     uint8_t*       out,
+                     size_t         written,
+                     size_t         out_size)
+{
+    for (;;)
+    {
+        int symbol = in.decode(literals);
+        if (symbol < 256)
+        {
+            if (written == out_size)
+                throw std::runtime_error("inflate: output overflow");
+            out[written++] = static_cast<uint8_t>(symbol);
+            continue;
+        }
+        if (symbol == 256)
+            return written;
+
+        symbol -= 257;
+        if (symbol >= 29)
+            throw std::runtime_error("inflate: bad length code");
+        const size_t length =
+            length_base[symbol] + in.get(length_extra[symbol]);
+
+        symbol = in.decode(distances);
+        if (symbol >= 30)
+            throw std::runtime_error("inflate: bad distance code");
+        const size_t distance = dist_base[symbol] + in.get(dist_extra[symbol]);
+
+        if (distance > written || length > out_size - written)
+            throw std::runtime_error("inflate: bad back reference");
+
+        uint8_t*       dst = out + written;
+        const uint8_t* src = dst - distance;
+        if (distance == 1)
+            std::memset(dst, *src, length);
+        else if (distance >= length)
+            std::memcpy(dst, src, length);
+        else
+        {
+            for (size_t i = 0; i < length; i++)
+                dst[i] = src[i];
+        }
+        written += length;
+    }
+}
+} // namespace
+
+size_t inflate_zlib(const std::vector<byte_span>& input,
+                    uint8_t*                      out,
+                    size_t                        out_size)
+{
+    static const fixed_codes fixed;
+
+    bit_reader     in(input);
+    const uint32_t cmf = in.get(8);
+    const uint32_t flg = in.get(8);
+    if ((cmf & 15) != 8 || (cmf >> 4) > 7 || (cmf * 256 + flg) % 31 != 0 ||
+        (flg & 32) != 0)
+    {
+        throw std::runtime_error("inflate: bad zlib header");
+    }
+
+    huffman literals;
+    huffman distances;
+    size_t  written  = 0;
+    bool    is_final = false;
+    while (!is_final)
+    {
+        is_final            = in.get(1) != 0;
+        const uint32_t type = in.get(2);
+        if (type == 0)
+        {
+            in.align_to_byte();
+            const uint32_t length = in.get(16);
+            const uint32_t check  = in.get(16);
+            if ((length ^ 0xFFFF) != check)
+                throw std::runtime_error("inflate: bad stored block");
+            if (length > out_size - written)
+                throw std::runtime_error("inflate: output overflow");
+            in.read_bytes(out + written, length);
+            written += length;
+        }
+        else if (type == 1)
+        {
+            written = inflate_block(
+                in, fixed.literals, fixed.distances, out, written, out_size);
+        }
+        else if (type == 2)
+        {
+            read_dynamic_codes(in, literals, distances);
+            written =
+                inflate_block(in, literals, distances, out, written, out_size);
+        }
+        else
+            throw std::runtime_error("inflate: bad block type");
+
+        if (in.is_truncated())
+            throw std::runtime_error("inflate: truncated stream");
+    }
+    return written;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// zlib stream (RFC 1950, 1951) decoder with table driven Huffman decoding.
+// The output size must be known up front, as it is for png scanlines, so
+// nothing is ever reallocated.
+
+struct byte_span
+{
+    const uint8_t* data = nullptr;
+    size_t         size = 0;
+};
+
+// Inflates the stream split over input (e.g. png IDAT chunks, read in place)
+// into out. Returns the number of bytes written, throws when the stream is
+// malformed, truncated or larger than out_size. The Adler-32 is not checked.
+size_t inflate_zlib(const std::vector<byte_span>& input,
+                    uint8_t*                      out,
+                    size_t                        out_size);
@@ -0,0 +1,121 @@
+#include "mesh_blob.h"
+#include "asset_pack.h"
+#include "trace.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+struct file_header
+{
+    uint32_t magic          = mesh_blob_magic;
+    uint32_t version        = mesh_blob_version;
+    uint32_t vertex_format  = 0;
+    uint32_t vertex_size    = 0;
+    uint32_t vertex_count   = 0;
+    uint32_t index_count    = 0;
+    float    position_scale = 1.f;
+};
+
+uint32_t get_vertex_size(mesh_blob::vertex_format format)
+{
+    return format == mesh_blob::vertex_format::packed
+               ? sizeof(vertex3d_packed)
+               : sizeof(vertex3d_textured);
+}
+
+template <class T>
+void copy_array(const std::byte*& src, std::vector<T>& dst, size_t count)
+{
+    dst.resize(count);
+    std::memcpy(static_cast<void*>(dst.data()), src, count * sizeof(T));
+    src += count * sizeof(T);
+}
+} // namespace
+
+bool read_mesh_blob(const char* path, mesh_blob& result)
+{
+    TRACE_ZONE("read_mesh_blob");
+
+    membuff    storage;
+    asset_view file;
+    if (!try_load_asset(path, storage, file))
+        return false;
+
+    file_header header;
+    if (file.size < sizeof(header))
+        throw std::runtime_error("truncated mesh blob: " + std::string(path));
+    std::memcpy(&header, file.data, sizeof(header));
+
+    const auto format = static_cast<mesh_blob::vertex_format>(
+        header.vertex_format);
+    if (header.magic != mesh_blob_magic ||
+        header.version != mesh_blob_version ||
+        header.vertex_format > uint32_t(mesh_blob::vertex_format::packed) ||
+        header.vertex_size != get_vertex_size(format) ||
+        header.index_count % 3 != 0 || !(header.position_scale > 0.f))
+    {
+        throw std::runtime_error("bad mesh blob: " + std::string(path));
+    }
+
+    const size_t expected_size =
+        sizeof(header) + size_t(header.vertex_count) * header.vertex_size +
+        size_t(header.index_count) * sizeof(uint32_t);
+    if (file.size != expected_size)
+        throw std::runtime_error("truncated mesh blob: " + std::string(path));
+
+    result.format         = format;
+    result.position_scale = header.position_scale;
+    result.vertexes.clear();
+    result.packed_vertexes.clear();
+
+    const std::byte* src = file.data + sizeof(header);
+    if (format == mesh_blob::vertex_format::packed)
+        copy_array(src, result.packed_vertexes, header.vertex_count);
+    else
+        copy_array(src, result.vertexes, header.vertex_count);
+    copy_array(src, result.indexes, header.index_count);
+
+    for (uint32_t index : result.indexes)
+    {
+        if (index >= header.vertex_count)
+            throw std::runtime_error("bad mesh blob index: " +
+                                     std::string(path));
+    }
+    return true;
+}
+
+void write_mesh_blob(const char* path, const mesh_blob& blob)
+{
+    const bool is_packed = blob.format == mesh_blob::vertex_format::packed;
+
+    file_header header;
+    header.vertex_format  = static_cast<uint32_t>(blob.format);
+    header.vertex_size    = get_vertex_size(blob.format);
+    header.vertex_count   = static_cast<uint32_t>(
+        is_packed ? blob.packed_vertexes.size() : blob.vertexes.size());
+    header.index_count    = static_cast<uint32_t>(blob.indexes.size());
+    header.position_scale = is_packed ? blob.position_scale : 1.f;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (is_packed)
+        file.write(reinterpret_cast<const char*>(blob.packed_vertexes.data()),
+                   blob.packed_vertexes.size() * sizeof(vertex3d_packed));
+    else
+        file.write(reinterpret_cast<const char*>(blob.vertexes.data()),
+                   blob.vertexes.size() * sizeof(vertex3d_textured));
+    file.write(reinterpret_cast<const char*>(blob.indexes.data()),
+               blob.indexes.size() * sizeof(uint32_t));
+    if (!file)
+        throw std::runtime_error("can't write: " + std::string(path));
+}
+
+std::string get_mesh_blob_path(const char* model_path)
+{
+    const std::string path = model_path;
+    return path.substr(0, path.find_last_of('.')) + ".mesh";
+}
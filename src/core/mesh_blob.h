@@ -0,0 +1,38 @@
+#pragma once
+#include "types.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Offline optimized mesh, written by tools/mesh_baker next to the model it
+// was imported from. All meshes of the model are merged into one and the
+// vertexes are stored in the format they are uploaded in.
+//
+// layout: header, vertexes, indexes (uint32_t)
+constexpr uint32_t mesh_blob_magic   = 0x534D3354; // "T3MS"
+constexpr uint32_t mesh_blob_version = 2;
+
+struct mesh_blob
+{
+    enum class vertex_format : uint32_t
+    {
+        textured, // vertex3d_textured, uv outside [0, 1]
+        packed,   // vertex3d_packed
+    };
+
+    vertex_format                  format         = vertex_format::textured;
+    float                          position_scale = 1.f; // packed only
+    std::vector<vertex3d_textured> vertexes;             // textured only
+    std::vector<vertex3d_packed>   packed_vertexes;      // packed only
+    std::vector<uint32_t>          indexes;
+};
+
+// One read of the file, or none when it is in the asset pack. False when
+// the file is missing, throws when it is malformed.
+bool read_mesh_blob(const char* path, mesh_blob& result);
+
+void write_mesh_blob(const char* path, const mesh_blob& blob);
+
+// model.obj -> model.mesh
+std::string get_mesh_blob_path(const char* model_path);
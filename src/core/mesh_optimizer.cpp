@@ -0,0 +1,238 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+constexpr size_t   lru_size = 32; // Cache modelled by the scoring
+constexpr uint32_t unused   = UINT32_MAX;
+
+// FNV-1a over the vertex bytes
+uint64_t hash_vertex(const vertex3d_textured& v)
+{
+    auto     bytes = reinterpret_cast<const unsigned char*>(&v);
+    uint64_t hash  = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < sizeof(v); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+float vertex_score(int cache_position, uint32_t remaining_triangles)
+{
+    if (remaining_triangles == 0)
+        return -1.f;
+
+    float score = 0.f;
+    if (cache_position >= 0)
+    {
+        // The last triangle's vertexes get a fixed score, so the next one
+        // does not simply reuse its edge in strip order
+        if (cache_position < 3)
+            score = 0.75f;
+        else
+            score = std::pow(
+                1.f - float(cache_position - 3) / (lru_size - 3), 1.5f);
+    }
+    // Finish vertexes with few triangles left, they would turn into lone
+    // triangles later
+    return score + 2.f / std::sqrt(float(remaining_triangles));
+}
+} // namespace
+
+void weld_vertexes(std::vector<vertex3d_textured>& vertexes,
+                   std::vector<uint32_t>&          indexes)
+{
+    static_assert(sizeof(vertex3d_textured) == 8 * sizeof(float),
+                  "padding would break the bitwise compare");
+
+    size_t table_size = 1;
+    while (table_size < vertexes.size() * 2)
+        table_size *= 2;
+    std::vector<uint32_t> table(table_size, unused);
+
+    std::vector<vertex3d_textured> welded;
+    std::vector<uint32_t>          remap(vertexes.size());
+    for (size_t i = 0; i < vertexes.size(); i++)
+    {
+        size_t slot = hash_vertex(vertexes[i]) & (table_size - 1);
+        while (table[slot] != unused &&
+               std::memcmp(&welded[table[slot]],
+                           &vertexes[i],
+                           sizeof(vertex3d_textured)) != 0)
+        {
+            slot = (slot + 1) & (table_size - 1);
+        }
+
+        if (table[slot] == unused)
+        {
+            table[slot] = static_cast<uint32_t>(welded.size());
+            welded.push_back(vertexes[i]);
+        }
+        remap[i] = table[slot];
+    }
+
+    for (uint32_t& index : indexes)
+        index = remap[index];
+    vertexes = std::move(welded);
+}
+
+void optimize_vertex_cache(std::vector<uint32_t>& indexes,
+                           size_t                 vertex_count)
+{
+    const size_t triangle_count = indexes.size() / 3;
+    if (triangle_count == 0)
+        return;
+
+    // Triangles of every vertex, the first remaining[v] are not emitted yet
+    std::vector<uint32_t> remaining(vertex_count, 0);
+    for (uint32_t index : indexes)
+        remaining[index]++;
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (size_t v = 0; v < vertex_count; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<uint32_t> adjacency(offsets.back());
+    {
+        std::vector<uint32_t> filled(vertex_count, 0);
+        for (size_t i = 0; i < indexes.size(); i++)
+        {
+            const uint32_t v = indexes[i];
+            adjacency[offsets[v] + filled[v]++] = static_cast<uint32_t>(i / 3);
+        }
+    }
+
+    std::vector<int>   cache_position(vertex_count, -1);
+    std::vector<float> scores(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++)
+        scores[v] = vertex_score(-1, remaining[v]);
+
+    std::vector<float> triangle_scores(triangle_count);
+    std::vector<bool>  is_emitted(triangle_count, false);
+    for (size_t t = 0; t < triangle_count; t++)
+        triangle_scores[t] = scores[indexes[t * 3]] +
+                             scores[indexes[t * 3 + 1]] +
+                             scores[indexes[t * 3 + 2]];
+
+    std::vector<uint32_t> result;
+    result.reserve(indexes.size());
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> next_cache;
+    size_t                cursor = 0;
+    uint32_t              best   = 0;
+
+    for (size_t emitted = 0; emitted < triangle_count; emitted++)
+    {
+        const uint32_t* tri = &indexes[best * 3];
+        result.insert(result.end(), tri, tri + 3);
+        is_emitted[best] = true;
+
+        for (int k = 0; k < 3; k++)
+        {
+            const uint32_t v     = tri[k];
+            uint32_t*      first = &adjacency[offsets[v]];
+            uint32_t*      last  = first + remaining[v];
+            std::iter_swap(std::find(first, last, best), last - 1);
+            remaining[v]--;
+        }
+
+        // Emitted vertexes move to the front, the rest shift back and the
+        // oldest fall out
+        next_cache.assign(tri, tri + 3);
+        for (uint32_t v : cache)
+        {
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                next_cache.push_back(v);
+        }
+        for (size_t i = lru_size; i < next_cache.size(); i++)
+        {
+            const uint32_t v  = next_cache[i];
+            cache_position[v] = -1;
+            scores[v]         = vertex_score(-1, remaining[v]);
+        }
+        next_cache.resize(std::min(next_cache.size(), lru_size));
+        cache.swap(next_cache);
+
+        for (size_t i = 0; i < cache.size(); i++)
+        {
+            const uint32_t v  = cache[i];
+            cache_position[v] = static_cast<int>(i);
+            scores[v]         = vertex_score(static_cast<int>(i), remaining[v]);
+        }
+
+        // Only triangles around the cache changed, the best of them is next
+        float best_score = -1.f;
+        for (uint32_t v : cache)
+        {
+            for (uint32_t i = 0; i < remaining[v]; i++)
+            {
+                const uint32_t t = adjacency[offsets[v] + i];
+                triangle_scores[t] = scores[indexes[t * 3]] +
+                                     scores[indexes[t * 3 + 1]] +
+                                     scores[indexes[t * 3 + 2]];
+                if (triangle_scores[t] > best_score)
+                {
+                    best_score = triangle_scores[t];
+                    best       = t;
+                }
+            }
+        }
+
+        // Nothing left around the cache, continue with the next island
+        if (best_score < 0.f)
+        {
+            while (cursor < triangle_count && is_emitted[cursor])
+                cursor++;
+            best = static_cast<uint32_t>(cursor);
+        }
+    }
+
+    indexes = std::move(result);
+}
+
+void optimize_vertex_fetch(std::vector<vertex3d_textured>& vertexes,
+                           std::vector<uint32_t>&          indexes)
+{
+    std::vector<uint32_t>          remap(vertexes.size(), unused);
+    std::vector<vertex3d_textured> ordered;
+    ordered.reserve(vertexes.size());
+
+    for (uint32_t& index : indexes)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = static_cast<uint32_t>(ordered.size());
+            ordered.push_back(vertexes[index]);
+        }
+        index = remap[index];
+    }
+    vertexes = std::move(ordered);
+}
+
+float get_acmr(const std::vector<uint32_t>& indexes, size_t cache_size)
+{
+    if (indexes.size() < 3)
+        return 0.f;
+
+    uint32_t max_index = 0;
+    for (uint32_t index : indexes)
+        max_index = std::max(max_index, index);
+
+    // FIFO: a hit does not refresh the entry, unlike the LRU model above
+    std::vector<size_t> inserted_at(size_t(max_index) + 1, 0);
+    size_t              misses = 0;
+    for (uint32_t index : indexes)
+    {
+        if (inserted_at[index] == 0 ||
+            misses - inserted_at[index] >= cache_size)
+        {
+            misses++;
+            inserted_at[index] = misses;
+        }
+    }
+    return float(misses) / float(indexes.size() / 3);
+}
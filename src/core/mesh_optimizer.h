@@ -0,0 +1,28 @@
+#pragma once
+#include "types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Import time passes over triangle lists, run once by tools/mesh_baker.
+// Order: weld, vertex cache, vertex fetch.
+
+// Merges bitwise identical vertexes and remaps the indexes
+void weld_vertexes(std::vector<vertex3d_textured>& vertexes,
+                   std::vector<uint32_t>&          indexes);
+
+// Reorders triangles for the post-transform vertex cache, after Tom
+// Forsyth's "Linear-Speed Vertex Cache Optimisation"
+void optimize_vertex_cache(std::vector<uint32_t>& indexes,
+                           size_t                 vertex_count);
+
+// Renumbers vertexes in the order the indexes first use them, so fetches
+// walk the vertex buffer forward. Unused vertexes are dropped.
+void optimize_vertex_fetch(std::vector<vertex3d_textured>& vertexes,
+                           std::vector<uint32_t>&          indexes);
+
+// Average cache miss ratio: transformed vertexes per triangle with a FIFO
+// cache of cache_size entries. 3 is the worst case, 0.5 the ideal for
+// regular grids.
+float get_acmr(const std::vector<uint32_t>& indexes, size_t cache_size);
@@ -1,3 +1,4 @@
+#include <cstddef>
 #include <vector>
 
 /*
@@ -27,12 +28,12 @@ data
 information.
 return: 0 if success, not 0 if some error occured.
 */
-int decodePNG(std::vector<std::byte>& out_image,
-              unsigned long&          image_width,
-              unsigned long&          image_height,
-              const std::byte*        in_png,
-              size_t                  in_size,
-              bool                    convert_to_rgba32 = true)
+inline int decodePNG(std::vector<std::byte>& out_image,
+                     unsigned long&          image_width,
+                     unsigned long&          image_height,
+                     const std::byte*        in_png,
+                     size_t                  in_size,
+                     bool                    convert_to_rgba32 = true)
 {
     // picoPNG version 20101224
     // Copyright (c) 2005-2010 Lode Vandevenne
@@ -1187,9 +1188,10 @@ int decodePNG(std::vector<std::byte>& out_image,
 #include <fstream>
 #include <iostream>
 
-void loadFile(std::vector<unsigned char>& buffer,
-              const std::string& filename) // designed for loading files from
-                                           // hard disk in an std::vector
+inline void loadFile(
+    std::vector<unsigned char>& buffer,
+    const std::string& filename) // designed for loading files from hard disk
+                                 // in an std::vector
 {
     std::ifstream file(filename.c_str(),
                        std::ios::in | std::ios::binary | std::ios::ate);
@@ -0,0 +1,580 @@
+#include "png.h"
+#include "asset_pack.h"
+#include "inflate.h"
+#include "picopng.hxx"
+#include "simd.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace
+{
+uint32_t read_u32(const uint8_t* p)
+{
+    return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 |
+           uint32_t(p[3]);
+}
+
+enum filter_type : uint8_t
+{
+    filter_none,
+    filter_sub,
+    filter_up,
+    filter_average,
+    filter_paeth,
+};
+
+// Rows are reconstructed in place or into out, prev is the reconstructed row
+// above (zeros for the first one)
+void unfilter_up(const uint8_t* src,
+                 const uint8_t* prev,
+                 uint8_t*       dst,
+                 size_t         size)
+{
+    size_t i = 0;
+#if defined(USE_SIMD_SSE2)
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i*)(src + i));
+        const __m128i b = _mm_loadu_si128((const __m128i*)(prev + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_add_epi8(a, b));
+    }
+#elif defined(USE_SIMD_NEON)
+    for (; i + 16 <= size; i += 16)
+        vst1q_u8(dst + i, vaddq_u8(vld1q_u8(src + i), vld1q_u8(prev + i)));
+#endif
+    for (; i < size; i++)
+        dst[i] = static_cast<uint8_t>(src[i] + prev[i]);
+}
+
+uint8_t paeth_predict(int a, int b, int c)
+{
+    const int pa = std::abs(b - c);
+    const int pb = std::abs(a - c);
+    const int pc = std::abs(a + b - 2 * c);
+    if (pa <= pb && pa <= pc)
+        return static_cast<uint8_t>(a);
+    return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+void unfilter_scalar(uint8_t        type,
+                     const uint8_t* src,
+                     const uint8_t* prev,
+                     uint8_t*       dst,
+                     size_t         size,
+                     size_t         bpp)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        const int a         = i >= bpp ? dst[i - bpp] : 0;
+        const int c         = i >= bpp ? prev[i - bpp] : 0;
+        int       predicted = 0;
+        if (type == filter_sub)
+            predicted = a;
+        else if (type == filter_average)
+            predicted = (a + prev[i]) >> 1;
+        else
+            predicted = paeth_predict(a, prev[i], c);
+        dst[i] = static_cast<uint8_t>(src[i] + predicted);
+    }
+}
+
+#if defined(USE_SIMD_SSE2) || defined(USE_SIMD_NEON)
+// Sub, average and paeth depend on the pixel to the left, so these work on
+// one 3 or 4 byte pixel at a time, widened to 16 bit lanes
+#if defined(USE_SIMD_SSE2)
+using pixel = __m128i;
+
+template <size_t bpp>
+pixel load_pixel(const uint8_t* p)
+{
+    uint32_t v = 0;
+    std::memcpy(&v, p, bpp);
+    return _mm_unpacklo_epi8(_mm_cvtsi32_si128(int(v)), _mm_setzero_si128());
+}
+template <size_t bpp>
+void store_pixel(uint8_t* p, pixel x)
+{
+    const auto v = uint32_t(_mm_cvtsi128_si32(_mm_packus_epi16(x, x)));
+    std::memcpy(p, &v, bpp);
+}
+pixel zero_pixel()
+{
+    return _mm_setzero_si128();
+}
+pixel add_wrap(pixel a, pixel b)
+{
+    return _mm_and_si128(_mm_add_epi16(a, b), _mm_set1_epi16(0xFF));
+}
+pixel average(pixel a, pixel b)
+{
+    return _mm_srli_epi16(_mm_add_epi16(a, b), 1);
+}
+pixel paeth_predict(pixel a, pixel b, pixel c)
+{
+    const pixel zero     = zero_pixel();
+    const pixel bc       = _mm_sub_epi16(b, c);
+    const pixel ac       = _mm_sub_epi16(a, c);
+    const pixel bc_ac    = _mm_add_epi16(bc, ac);
+    const pixel pa       = _mm_max_epi16(bc, _mm_sub_epi16(zero, bc));
+    const pixel pb       = _mm_max_epi16(ac, _mm_sub_epi16(zero, ac));
+    const pixel pc       = _mm_max_epi16(bc_ac, _mm_sub_epi16(zero, bc_ac));
+    const pixel smallest = _mm_min_epi16(_mm_min_epi16(pa, pb), pc);
+
+    const pixel is_b    = _mm_cmpeq_epi16(pb, smallest);
+    const pixel nearest = _mm_or_si128(_mm_and_si128(is_b, b),
+                                       _mm_andnot_si128(is_b, c));
+    const pixel is_a    = _mm_cmpeq_epi16(pa, smallest);
+    return _mm_or_si128(_mm_and_si128(is_a, a),
+                        _mm_andnot_si128(is_a, nearest));
+}
+#else
+using pixel = int16x8_t;
+
+template <size_t bpp>
+pixel load_pixel(const uint8_t* p)
+{
+    uint32_t v = 0;
+    std::memcpy(&v, p, bpp);
+    return vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(v))));
+}
+template <size_t bpp>
+void store_pixel(uint8_t* p, pixel x)
+{
+    const uint8x8_t bytes = vmovn_u16(vreinterpretq_u16_s16(x));
+    const uint32_t  v     = vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+    std::memcpy(p, &v, bpp);
+}
+pixel zero_pixel()
+{
+    return vdupq_n_s16(0);
+}
+pixel add_wrap(pixel a, pixel b)
+{
+    return vandq_s16(vaddq_s16(a, b), vdupq_n_s16(0xFF));
+}
+pixel average(pixel a, pixel b)
+{
+    return vshrq_n_s16(vaddq_s16(a, b), 1);
+}
+pixel paeth_predict(pixel a, pixel b, pixel c)
+{
+    const pixel bc       = vsubq_s16(b, c);
+    const pixel ac       = vsubq_s16(a, c);
+    const pixel pa       = vabsq_s16(bc);
+    const pixel pb       = vabsq_s16(ac);
+    const pixel pc       = vabsq_s16(vaddq_s16(bc, ac));
+    const pixel smallest = vminq_s16(vminq_s16(pa, pb), pc);
+
+    const pixel nearest = vbslq_s16(vceqq_s16(pb, smallest), b, c);
+    return vbslq_s16(vceqq_s16(pa, smallest), a, nearest);
+}
+#endif
+
+template <size_t bpp>
+void unfilter_simd(uint8_t        type,
+                   const uint8_t* src,
+                   const uint8_t* prev,
+                   uint8_t*       dst,
+                   size_t         size)
+{
+    pixel a = zero_pixel();
+    pixel c = zero_pixel();
+    for (size_t i = 0; i < size; i += bpp)
+    {
+        const pixel x = load_pixel<bpp>(src + i);
+        if (type == filter_sub)
+            a = add_wrap(x, a);
+        else
+        {
+            const pixel b = load_pixel<bpp>(prev + i);
+            if (type == filter_average)
+                a = add_wrap(x, average(a, b));
+            else
+                a = add_wrap(x, paeth_predict(a, b, c));
+            c = b;
+        }
+        store_pixel<bpp>(dst + i, a);
+    }
+}
+#endif
+
+void unfilter_row(uint8_t        type,
+                  const uint8_t* src,
+                  const uint8_t* prev,
+                  uint8_t*       dst,
+                  size_t         size,
+                  size_t         bpp)
+{
+    if (type == filter_none)
+    {
+        if (dst != src)
+            std::memcpy(dst, src, size);
+        return;
+    }
+    if (type == filter_up)
+    {
+        unfilter_up(src, prev, dst, size);
+        return;
+    }
+#if defined(USE_SIMD_SSE2) || defined(USE_SIMD_NEON)
+    if (bpp == 4)
+    {
+        unfilter_simd<4>(type, src, prev, dst, size);
+        return;
+    }
+    if (bpp == 3)
+    {
+        unfilter_simd<3>(type, src, prev, dst, size);
+        return;
+    }
+#endif
+    unfilter_scalar(type, src, prev, dst, size, bpp);
+}
+
+struct png_palette
+{
+    uint8_t rgba[256][4];
+    size_t  size   = 0;
+    int     key[3] = { -1, -1, -1 }; // tRNS color of grey and RGB images
+};
+
+void expand_row(const png_info&    info,
+                const png_palette& palette,
+                const uint8_t*     src,
+                uint8_t*           dst)
+{
+    const int* key = palette.key;
+    switch (info.color_type)
+    {
+        case 0:
+            for (uint32_t x = 0; x < info.width; x++, dst += 4)
+            {
+                dst[0] = dst[1] = dst[2] = src[x];
+                dst[3]                   = src[x] == key[0] ? 0 : 255;
+            }
+            break;
+        case 2:
+            for (uint32_t x = 0; x < info.width; x++, src += 3, dst += 4)
+            {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+                dst[3] = src[0] == key[0] && src[1] == key[1] &&
+                                 src[2] == key[2]
+                             ? 0
+                             : 255;
+            }
+            break;
+        case 3:
+            for (uint32_t x = 0; x < info.width; x++, dst += 4)
+            {
+                if (src[x] >= palette.size)
+                    throw std::runtime_error("png palette index out of range");
+                std::memcpy(dst, palette.rgba[src[x]], 4);
+            }
+            break;
+        case 4:
+            for (uint32_t x = 0; x < info.width; x++, src += 2, dst += 4)
+            {
+                dst[0] = dst[1] = dst[2] = src[0];
+                dst[3]                   = src[1];
+            }
+            break;
+    }
+}
+
+int get_channel_count(uint8_t color_type)
+{
+    switch (color_type)
+    {
+        case 0:
+            return 1;
+        case 2:
+            return 3;
+        case 3:
+            return 1;
+        case 4:
+            return 2;
+        case 6:
+            return 4;
+    }
+    throw std::runtime_error("bad png color type");
+}
+} // namespace
+
+bool read_png_info(const std::byte* data, size_t size, png_info& info)
+{
+    static const uint8_t signature[] = { 0x89, 'P',  'N',  'G',
+                                         '\r', '\n', 0x1A, '\n' };
+
+    const auto* p = reinterpret_cast<const uint8_t*>(data);
+    if (size < 33 || std::memcmp(p, signature, sizeof(signature)) != 0 ||
+        read_u32(p + 8) != 13 || std::memcmp(p + 12, "IHDR", 4) != 0)
+    {
+        return false;
+    }
+
+    info.width      = read_u32(p + 16);
+    info.height     = read_u32(p + 20);
+    info.bit_depth  = p[24];
+    info.color_type = p[25];
+    info.interlace  = p[28];
+    return info.width > 0 && info.height > 0 && info.width < (1u << 24) &&
+           info.height < (1u << 24);
+}
+
+void decode_png(const std::byte* data,
+                size_t           size,
+                std::byte*       out,
+                size_t           out_size)
+{
+    TRACE_ZONE("decode_png");
+
+    png_info info;
+    if (!read_png_info(data, size, info))
+        throw std::runtime_error("not a png");
+
+    const size_t image_size = size_t(info.width) * info.height * 4;
+    if (out_size < image_size)
+        throw std::runtime_error("png output buffer too small");
+
+    if (info.bit_depth != 8 || info.interlace != 0)
+    {
+        std::vector<std::byte> image;
+        unsigned long          w     = 0;
+        unsigned long          h     = 0;
+        const int              error = decodePNG(image, w, h, data, size, true);
+        if (error != 0)
+            throw std::runtime_error("png error " + std::to_string(error));
+        std::memcpy(out, image.data(), image_size);
+        return;
+    }
+
+    const int channels = get_channel_count(info.color_type);
+
+    // IDAT chunks are inflated where they are, no concatenated copy
+    std::vector<byte_span> idat;
+    png_palette            palette;
+    const auto*            p   = reinterpret_cast<const uint8_t*>(data);
+    size_t                 pos = 8;
+    while (pos + 12 <= size)
+    {
+        const uint32_t length = read_u32(p + pos);
+        const uint8_t* type   = p + pos + 4;
+        const uint8_t* chunk  = p + pos + 8;
+        if (length > size - pos - 12)
+            throw std::runtime_error("truncated png chunk");
+
+        if (std::memcmp(type, "IDAT", 4) == 0)
+            idat.push_back({ chunk, length });
+        else if (std::memcmp(type, "PLTE", 4) == 0)
+        {
+            palette.size = std::min<size_t>(length / 3, 256);
+            for (size_t i = 0; i < palette.size; i++)
+            {
+                std::memcpy(palette.rgba[i], chunk + 3 * i, 3);
+                palette.rgba[i][3] = 255;
+            }
+        }
+        else if (std::memcmp(type, "tRNS", 4) == 0)
+        {
+            if (info.color_type == 3)
+            {
+                for (size_t i = 0; i < std::min<size_t>(length, 256); i++)
+                    palette.rgba[i][3] = chunk[i];
+            }
+            else if (info.color_type == 0 && length >= 2)
+                palette.key[0] = chunk[0] << 8 | chunk[1];
+            else if (info.color_type == 2 && length >= 6)
+            {
+                for (int c = 0; c < 3; c++)
+                    palette.key[c] = chunk[2 * c] << 8 | chunk[2 * c + 1];
+            }
+        }
+        else if (std::memcmp(type, "IEND", 4) == 0)
+            break;
+        pos += 12 + size_t(length);
+    }
+    if (idat.empty())
+        throw std::runtime_error("png without image data");
+
+    // Scanlines with their filter type byte in front
+    const size_t         stride = size_t(info.width) * channels;
+    std::vector<uint8_t> filtered((stride + 1) * info.height);
+    if (inflate_zlib(idat, filtered.data(), filtered.size()) !=
+        filtered.size())
+    {
+        throw std::runtime_error("truncated png image data");
+    }
+
+    // RGBA rows are reconstructed directly into out, other formats in place
+    // and then expanded
+    std::vector<uint8_t> zero_row(stride);
+    const uint8_t*       prev   = zero_row.data();
+    auto*                pixels = reinterpret_cast<uint8_t*>(out);
+    for (uint32_t y = 0; y < info.height; y++)
+    {
+        uint8_t*      row  = filtered.data() + y * (stride + 1);
+        const uint8_t type = row[0];
+        if (type > filter_paeth)
+            throw std::runtime_error("bad png filter type");
+
+        uint8_t* dst_row = pixels + size_t(y) * info.width * 4;
+        if (info.color_type == 6)
+        {
+            unfilter_row(type, row + 1, prev, dst_row, stride, 4);
+            prev = dst_row;
+        }
+        else
+        {
+            unfilter_row(type, row + 1, prev, row + 1, stride, channels);
+            expand_row(info, palette, row + 1, dst_row);
+            prev = row + 1;
+        }
+    }
+}
+
+void get_pixels_from_png(const char*             path,
+                         std::vector<std::byte>& image,
+                         unsigned long&          w,
+                         unsigned long&          h)
+{
+    TRACE_ZONE("get_pixels_from_png");
+
+    // Decoded straight from the pack mapping or the loose file buffer
+    membuff          storage;
+    const asset_view file = load_asset(path, storage);
+
+    png_info info;
+    if (!read_png_info(file.data, file.size, info))
+        throw std::runtime_error("not a png: " + std::string(path));
+
+    image.resize(size_t(info.width) * info.height * 4);
+    try
+    {
+        decode_png(file.data, file.size, image.data(), image.size());
+    }
+    catch (const std::exception& e)
+    {
+        throw std::runtime_error("can't load texture " + std::string(path) +
+                                 ": " + e.what());
+    }
+    w = info.width;
+    h = info.height;
+}
+
+static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+    static const std::array<uint32_t, 256> table = []
+    {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void push_u32(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static void write_chunk(std::ofstream&              file,
+                        const char*                 type,
+                        const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> chunk;
+    push_u32(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    push_u32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+
+    file.write(reinterpret_cast<const char*>(chunk.data()),
+               static_cast<std::streamsize>(chunk.size()));
+}
+
+void write_png(const char* path,
+               const void* pixels,
+               uint32_t    width,
+               uint32_t    height)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error(std::string("can't write png: ") + path);
+    }
+
+    static const uint8_t signature[] = { 0x89, 'P',  'N',  'G',
+                                         '\r', '\n', 0x1A, '\n' };
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<uint8_t> header;
+    push_u32(header, width);
+    push_u32(header, height);
+    header.push_back(8); // bit depth
+    header.push_back(6); // RGBA
+    header.push_back(0); // deflate
+    header.push_back(0); // adaptive filtering
+    header.push_back(0); // no interlace
+    write_chunk(file, "IHDR", header);
+
+    // Raw scanlines, each prefixed with filter type "none"
+    const size_t         row_size = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> raw;
+    raw.reserve((row_size + 1) * height);
+    auto src = static_cast<const uint8_t*>(pixels);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), src + y * row_size, src + (y + 1) * row_size);
+    }
+
+    // zlib stream made of stored deflate blocks
+    std::vector<uint8_t> zlib;
+    zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    size_t pos = 0;
+    do
+    {
+        const size_t   block = std::min<size_t>(raw.size() - pos, 65535);
+        const uint16_t len   = static_cast<uint16_t>(block);
+        zlib.push_back(pos + block == raw.size() ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(len));
+        zlib.push_back(static_cast<uint8_t>(len >> 8));
+        zlib.push_back(static_cast<uint8_t>(~len));
+        zlib.push_back(static_cast<uint8_t>(~len >> 8));
+        zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + block);
+        pos += block;
+    } while (pos < raw.size());
+
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for (uint8_t byte : raw)
+    {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    push_u32(zlib, (b << 16) | a);
+    write_chunk(file, "IDAT", zlib);
+    write_chunk(file, "IEND", {});
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct png_info
+{
+    uint32_t width      = 0;
+    uint32_t height     = 0;
+    uint8_t  bit_depth  = 0;
+    uint8_t  color_type = 0;
+    uint8_t  interlace  = 0;
+};
+
+// Reads the header only, false when data is not a png
+bool read_png_info(const std::byte* data, size_t size, png_info& info);
+
+// Decodes to RGBA8 rows, top to bottom, straight into out (width * height *
+// 4 bytes), e.g. texture memory. 8 bit non interlaced files, all the game
+// ships, take the fast path, the rest goes through picopng. Throws when the
+// file is malformed.
+void decode_png(const std::byte* data,
+                size_t           size,
+                std::byte*       out,
+                size_t           out_size);
+
+// Decodes png file to RGBA8 pixels
+void get_pixels_from_png(const char*             path,
+                         std::vector<std::byte>& image,
+                         unsigned long&          w,
+                         unsigned long&          h);
+
+// Writes RGBA8 pixels (rows top to bottom) as uncompressed png
+void write_png(const char* path,
+               const void* pixels,
+               uint32_t    width,
+               uint32_t    height);
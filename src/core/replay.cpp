@@ -0,0 +1,67 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+replay::replay(const char* path)
+{
+    std::ifstream file(path);
+    if (!file)
+        throw std::runtime_error(std::string("can't open replay: ") + path);
+
+    std::string line;
+    size_t      line_number = 0;
+    while (std::getline(file, line))
+    {
+        line_number++;
+
+        std::istringstream stream(line);
+        std::string        first;
+        if (!(stream >> first) || first[0] == '#')
+            continue;
+
+        if (first == "seed")
+        {
+            stream >> seed;
+            continue;
+        }
+
+        step s;
+        try
+        {
+            s.frame = std::stoull(first);
+        }
+        catch (const std::exception&)
+        {
+            throw std::runtime_error(std::string(path) + ":" +
+                                     std::to_string(line_number) +
+                                     ": expected frame number");
+        }
+        if (!(stream >> s.action))
+            throw std::runtime_error(std::string(path) + ":" +
+                                     std::to_string(line_number) +
+                                     ": expected action");
+
+        std::string arg;
+        while (stream >> arg)
+            s.args.push_back(arg);
+
+        steps.push_back(std::move(s));
+    }
+
+    std::stable_sort(steps.begin(),
+                     steps.end(),
+                     [](const step& a, const step& b)
+                     { return a.frame < b.frame; });
+}
+
+bool replay::next(uint64_t frame, step& s)
+{
+    if (current == steps.size() || steps[current].frame > frame)
+        return false;
+
+    s = steps[current++];
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scripted input for deterministic runs. Every line holds the frame number,
+// an action and its arguments, e.g.
+//
+//   seed 7
+//   1 start
+//   30 move left
+//   45 rotate x
+//   60 orbit 5 0
+//   120 capture frame_120.png
+//   121 quit
+//
+// Lines starting with '#' are comments. The game decides what the actions
+// mean, steps are sorted by frame on load.
+class replay
+{
+public:
+    struct step
+    {
+        uint64_t                 frame = 0;
+        std::string              action;
+        std::vector<std::string> args;
+    };
+
+    explicit replay(const char* path);
+
+    // Returns the steps scheduled for the frame one by one, frames must be
+    // requested in increasing order
+    bool next(uint64_t frame, step& s);
+
+    bool     is_finished() const { return current == steps.size(); }
+    uint32_t get_seed() const { return seed; }
+
+private:
+    std::vector<step> steps;
+    size_t            current = 0;
+    uint32_t          seed    = 0;
+};
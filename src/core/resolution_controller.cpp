@@ -0,0 +1,70 @@
+#include "resolution_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+constexpr float smoothing  = 0.1f;  // Weight of the newest frame
+constexpr float scale_step = 0.05f; // Scales snap to this grid
+constexpr float min_factor = 0.85f; // Largest single drop
+constexpr float max_factor = 1.1f;  // Largest single raise
+} // namespace
+
+resolution_controller::resolution_controller()
+    : resolution_controller(settings())
+{
+}
+
+resolution_controller::resolution_controller(const settings& s)
+    : cfg(s)
+{
+    cfg.min_scale = std::min(cfg.min_scale, cfg.max_scale);
+    scale         = cfg.max_scale;
+}
+
+bool resolution_controller::update(float frame_ms)
+{
+    smoothed_ms = smoothed_ms == 0.f
+                      ? frame_ms
+                      : smoothed_ms + smoothing * (frame_ms - smoothed_ms);
+
+    if (cooldown > 0)
+    {
+        cooldown--;
+        return false;
+    }
+
+    if (smoothed_ms > cfg.target_ms)
+    {
+        over++;
+        under = 0;
+    }
+    else if (smoothed_ms < cfg.target_ms * (1.f - cfg.headroom))
+    {
+        under++;
+        over = 0;
+    }
+    else
+    {
+        over  = 0;
+        under = 0;
+    }
+
+    if (over < cfg.drop_frames && under < cfg.grow_frames)
+        return false;
+    over  = 0;
+    under = 0;
+
+    // Fill cost follows the pixel count, the square of the scale
+    const float factor = std::clamp(
+        std::sqrt(cfg.target_ms / smoothed_ms), min_factor, max_factor);
+    float next = std::round(scale * factor / scale_step) * scale_step;
+    next       = std::clamp(next, cfg.min_scale, cfg.max_scale);
+    if (std::abs(next - scale) < scale_step / 2)
+        return false;
+
+    scale    = next;
+    cooldown = cfg.drop_frames * 2;
+    return true;
+}
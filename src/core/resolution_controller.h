@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+
+// Picks the render scale of the 3D scene that holds a frame time budget.
+// Frame times are smoothed and the scale only moves after the budget was
+// missed, or met with headroom, for a number of frames in a row. Every
+// change is followed by a cooldown, so the scale settles instead of
+// oscillating around the target.
+class resolution_controller
+{
+public:
+    struct settings
+    {
+        float    target_ms   = 1000.f / 60.f;
+        float    min_scale   = 0.5f;
+        float    max_scale   = 1.f;
+        float    headroom    = 0.15f; // Grow only below target * (1 - this)
+        uint32_t drop_frames = 8;     // Over budget this long to shrink
+        uint32_t grow_frames = 60;    // Under budget this long to grow
+    };
+
+    resolution_controller();
+    explicit resolution_controller(const settings& s);
+
+    // Returns true when the scale changed
+    bool update(float frame_ms);
+
+    float get_scale() const { return scale; }
+    float get_smoothed_ms() const { return smoothed_ms; }
+
+private:
+    settings cfg;
+    float    scale       = 1.f;
+    float    smoothed_ms = 0.f;
+    uint32_t over        = 0;
+    uint32_t under       = 0;
+    uint32_t cooldown    = 0;
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include "asset_pack.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+struct resource_cache_stats
+{
+    size_t hits           = 0;
+    size_t misses         = 0;
+    size_t resident       = 0; // Assets with a live handle
+    size_t resident_bytes = 0;
+};
+
+// Interns assets by path hash (hash_asset_name) and hands out shared
+// handles. Only weak references are kept, an asset is freed with its last
+// handle and loaded again when asked for after that. T provides
+// get_resident_bytes().
+template <class T>
+class resource_cache
+{
+public:
+    // The resident asset for path, else the one load() returns. load() runs
+    // outside the lock: two threads missing the same path both load it and
+    // the first one stored is kept. Thread safe.
+    template <class F>
+    std::shared_ptr<T> get(const char* path, F&& load)
+    {
+        const uint64_t key = hash_asset_name(path);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(key);
+            if (it != entries.end())
+            {
+                if (std::shared_ptr<T> resident = it->second.lock())
+                {
+                    hits++;
+                    return resident;
+                }
+            }
+            misses++;
+        }
+
+        std::shared_ptr<T> loaded = load();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::weak_ptr<T>&           entry = entries[key];
+        if (std::shared_ptr<T> resident = entry.lock())
+            return resident;
+        entry = loaded;
+        return loaded;
+    }
+
+    // The resident asset for path or nullptr, never loads. Not counted in
+    // the stats.
+    std::shared_ptr<T> find(const char* path) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(hash_asset_name(path));
+        return it == entries.end() ? nullptr : it->second.lock();
+    }
+
+    resource_cache_stats get_stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        resource_cache_stats        result;
+        result.hits   = hits;
+        result.misses = misses;
+        // Asked each time, a reloaded asset may have changed its size
+        for (const auto& [key, entry] : entries)
+        {
+            if (std::shared_ptr<T> resident = entry.lock())
+            {
+                result.resident++;
+                result.resident_bytes += resident->get_resident_bytes();
+            }
+        }
+        return result;
+    }
+
+private:
+    std::unordered_map<uint64_t, std::weak_ptr<T>> entries;
+    size_t                                         hits   = 0;
+    size_t                                         misses = 0;
+    mutable std::mutex                             mutex;
+};
@@ -0,0 +1,212 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USE_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define USE_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// Four packed floats. Maps to SSE2 or NEON registers when available and to
+// plain scalar code otherwise, so callers are written only once.
+struct float4
+{
+#if defined(USE_SIMD_SSE2)
+    __m128 v;
+
+    float4() = default;
+    float4(__m128 value)
+        : v(value)
+    {
+    }
+    explicit float4(float s)
+        : v(_mm_set1_ps(s))
+    {
+    }
+    float4(float x, float y, float z, float w)
+        : v(_mm_setr_ps(x, y, z, w))
+    {
+    }
+
+    static float4 load(const float* p) { return _mm_loadu_ps(p); }
+    void          store(float* p) const { _mm_storeu_ps(p, v); }
+
+    friend float4 operator+(float4 a, float4 b) { return _mm_add_ps(a.v, b.v); }
+    friend float4 operator-(float4 a, float4 b) { return _mm_sub_ps(a.v, b.v); }
+    friend float4 operator*(float4 a, float4 b) { return _mm_mul_ps(a.v, b.v); }
+    friend float4 operator/(float4 a, float4 b) { return _mm_div_ps(a.v, b.v); }
+
+    friend float4 min(float4 a, float4 b) { return _mm_min_ps(a.v, b.v); }
+    friend float4 max(float4 a, float4 b) { return _mm_max_ps(a.v, b.v); }
+    friend float4 sqrt(float4 a) { return _mm_sqrt_ps(a.v); }
+
+    // Bit i of the result is set when lane i of a >= b
+    friend int mask_ge(float4 a, float4 b)
+    {
+        return _mm_movemask_ps(_mm_cmpge_ps(a.v, b.v));
+    }
+    friend int mask_lt(float4 a, float4 b)
+    {
+        return _mm_movemask_ps(_mm_cmplt_ps(a.v, b.v));
+    }
+#elif defined(USE_SIMD_NEON)
+    float32x4_t v;
+
+    float4() = default;
+    float4(float32x4_t value)
+        : v(value)
+    {
+    }
+    explicit float4(float s)
+        : v(vdupq_n_f32(s))
+    {
+    }
+    float4(float x, float y, float z, float w)
+    {
+        const float tmp[4] = { x, y, z, w };
+        v                  = vld1q_f32(tmp);
+    }
+
+    static float4 load(const float* p) { return vld1q_f32(p); }
+    void          store(float* p) const { vst1q_f32(p, v); }
+
+    friend float4 operator+(float4 a, float4 b) { return vaddq_f32(a.v, b.v); }
+    friend float4 operator-(float4 a, float4 b) { return vsubq_f32(a.v, b.v); }
+    friend float4 operator*(float4 a, float4 b) { return vmulq_f32(a.v, b.v); }
+
+    friend float4 min(float4 a, float4 b) { return vminq_f32(a.v, b.v); }
+    friend float4 max(float4 a, float4 b) { return vmaxq_f32(a.v, b.v); }
+
+#if defined(__aarch64__)
+    friend float4 operator/(float4 a, float4 b) { return vdivq_f32(a.v, b.v); }
+    friend float4 sqrt(float4 a) { return vsqrtq_f32(a.v); }
+#else
+    // ARMv7 NEON has neither, go through the lanes
+    friend float4 operator/(float4 a, float4 b)
+    {
+        float x[4], y[4];
+        vst1q_f32(x, a.v);
+        vst1q_f32(y, b.v);
+        return float4(x[0] / y[0], x[1] / y[1], x[2] / y[2], x[3] / y[3]);
+    }
+    friend float4 sqrt(float4 a)
+    {
+        float x[4];
+        vst1q_f32(x, a.v);
+        return float4(std::sqrt(x[0]),
+                      std::sqrt(x[1]),
+                      std::sqrt(x[2]),
+                      std::sqrt(x[3]));
+    }
+#endif
+
+    friend int mask_ge(float4 a, float4 b)
+    {
+        return to_mask(vcgeq_f32(a.v, b.v));
+    }
+    friend int mask_lt(float4 a, float4 b)
+    {
+        return to_mask(vcltq_f32(a.v, b.v));
+    }
+
+    static int to_mask(uint32x4_t m)
+    {
+        return static_cast<int>((vgetq_lane_u32(m, 0) & 1) |
+                                (vgetq_lane_u32(m, 1) & 2) |
+                                (vgetq_lane_u32(m, 2) & 4) |
+                                (vgetq_lane_u32(m, 3) & 8));
+    }
+#else
+    float v[4];
+
+    float4() = default;
+    explicit float4(float s)
+        : v{ s, s, s, s }
+    {
+    }
+    float4(float x, float y, float z, float w)
+        : v{ x, y, z, w }
+    {
+    }
+
+    static float4 load(const float* p)
+    {
+        return float4(p[0], p[1], p[2], p[3]);
+    }
+    void          store(float* p) const
+    {
+        for (int i = 0; i < 4; i++)
+            p[i] = v[i];
+    }
+
+    friend float4 operator+(float4 a, float4 b)
+    {
+        return float4(a.v[0] + b.v[0],
+                      a.v[1] + b.v[1],
+                      a.v[2] + b.v[2],
+                      a.v[3] + b.v[3]);
+    }
+    friend float4 operator-(float4 a, float4 b)
+    {
+        return float4(a.v[0] - b.v[0],
+                      a.v[1] - b.v[1],
+                      a.v[2] - b.v[2],
+                      a.v[3] - b.v[3]);
+    }
+    friend float4 operator*(float4 a, float4 b)
+    {
+        return float4(a.v[0] * b.v[0],
+                      a.v[1] * b.v[1],
+                      a.v[2] * b.v[2],
+                      a.v[3] * b.v[3]);
+    }
+    friend float4 operator/(float4 a, float4 b)
+    {
+        return float4(a.v[0] / b.v[0],
+                      a.v[1] / b.v[1],
+                      a.v[2] / b.v[2],
+                      a.v[3] / b.v[3]);
+    }
+
+    friend float4 min(float4 a, float4 b)
+    {
+        float4 r;
+        for (int i = 0; i < 4; i++)
+            r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+        return r;
+    }
+    friend float4 max(float4 a, float4 b)
+    {
+        float4 r;
+        for (int i = 0; i < 4; i++)
+            r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+        return r;
+    }
+    friend float4 sqrt(float4 a)
+    {
+        float4 r;
+        for (int i = 0; i < 4; i++)
+            r.v[i] = std::sqrt(a.v[i]);
+        return r;
+    }
+
+    friend int mask_ge(float4 a, float4 b)
+    {
+        int m = 0;
+        for (int i = 0; i < 4; i++)
+            m |= (a.v[i] >= b.v[i]) << i;
+        return m;
+    }
+    friend int mask_lt(float4 a, float4 b)
+    {
+        int m = 0;
+        for (int i = 0; i < 4; i++)
+            m |= (a.v[i] < b.v[i]) << i;
+        return m;
+    }
+#endif
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free ring for exactly one producer and one consumer thread.
+// push() fails instead of blocking when the ring is full.
+template <class T, size_t capacity>
+class spsc_queue
+{
+    static_assert((capacity & (capacity - 1)) == 0,
+                  "capacity must be power of 2");
+
+public:
+    bool push(const T& value)
+    {
+        const size_t tail = write_index.load(std::memory_order_relaxed);
+        if (tail - read_index.load(std::memory_order_acquire) == capacity)
+            return false;
+        items[tail & (capacity - 1)] = value;
+        write_index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value)
+    {
+        const size_t head = read_index.load(std::memory_order_relaxed);
+        if (head == write_index.load(std::memory_order_acquire))
+            return false;
+        value = items[head & (capacity - 1)];
+        read_index.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Bulk versions for plain data, copy what fits or what is queued and
+    // return how many
+    size_t push(const T* values, size_t count)
+    {
+        const size_t tail = write_index.load(std::memory_order_relaxed);
+        const size_t used = tail - read_index.load(std::memory_order_acquire);
+        count             = std::min(count, capacity - used);
+
+        const size_t start = tail & (capacity - 1);
+        const size_t first = std::min(count, capacity - start);
+        std::copy_n(values, first, items.begin() + start);
+        std::copy_n(values + first, count - first, items.begin());
+        write_index.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t pop(T* values, size_t count)
+    {
+        const size_t head = read_index.load(std::memory_order_relaxed);
+        const size_t used = write_index.load(std::memory_order_acquire) - head;
+        count             = std::min(count, used);
+
+        const size_t start = head & (capacity - 1);
+        const size_t first = std::min(count, capacity - start);
+        std::copy_n(items.begin() + start, first, values);
+        std::copy_n(items.begin(), count - first, values + first);
+        read_index.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // A lower bound for the consumer, an upper bound for the producer
+    size_t size() const
+    {
+        return write_index.load(std::memory_order_acquire) -
+               read_index.load(std::memory_order_acquire);
+    }
+
+    bool empty() const
+    {
+        return read_index.load(std::memory_order_acquire) ==
+               write_index.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T, capacity> items{};
+    alignas(64) std::atomic<size_t> write_index{ 0 };
+    alignas(64) std::atomic<size_t> read_index{ 0 };
+};
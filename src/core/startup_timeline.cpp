@@ -0,0 +1,92 @@
+#include "startup_timeline.h"
+
+#include <algorithm>
+#include <iomanip>
+
+std::atomic<startup_timeline*> startup_timeline::current{ nullptr };
+
+startup_timeline::startup_timeline(clock::time_point origin)
+    : origin(origin)
+    , main_thread(std::this_thread::get_id())
+{
+}
+
+float startup_timeline::to_ms(clock::time_point t) const
+{
+    return std::chrono::duration<float, std::milli>(t - origin).count();
+}
+
+void startup_timeline::add(const std::string& name,
+                           clock::time_point  begin,
+                           clock::time_point  end)
+{
+    const span s{
+        name, std::this_thread::get_id(), to_ms(begin), to_ms(end), false
+    };
+    std::lock_guard<std::mutex> lock(mutex);
+    spans.push_back(s);
+}
+
+void startup_timeline::mark(const char* name)
+{
+    const float now = to_ms(clock::now());
+    const span  s{ name, std::this_thread::get_id(), now, now, true };
+    std::lock_guard<std::mutex> lock(mutex);
+    spans.push_back(s);
+}
+
+void startup_timeline::print(std::ostream& out) const
+{
+    std::vector<span> sorted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sorted = spans;
+    }
+    std::stable_sort(sorted.begin(),
+                     sorted.end(),
+                     [](const span& a, const span& b)
+                     { return a.begin_ms < b.begin_ms; });
+
+    // Workers are numbered in the order they show up. Stages nest, like
+    // the engine ones inside "engine initialize", so work_ms adds the time
+    // each thread is covered by any stage rather than every stage.
+    std::vector<std::thread::id> workers;
+    std::vector<float>           covered_ms(1, 0.f); // main, then workers
+    float                        work_ms = 0.f;
+    float                        wall_ms = 0.f;
+
+    // Greppable and parsed by scripts: "startup stage=... ms=..."
+    out << std::fixed << std::setprecision(1);
+    for (const span& s : sorted)
+    {
+        std::string thread = "main";
+        size_t      index  = 0;
+        if (s.thread != main_thread)
+        {
+            auto it = std::find(workers.begin(), workers.end(), s.thread);
+            if (it == workers.end())
+            {
+                it = workers.insert(workers.end(), s.thread);
+                covered_ms.push_back(0.f);
+            }
+            index  = static_cast<size_t>(it - workers.begin()) + 1;
+            thread = "worker" + std::to_string(index - 1);
+        }
+
+        if (s.is_mark)
+        {
+            out << "startup mark=\"" << s.name << "\" at_ms=" << s.begin_ms
+                << '\n';
+            continue;
+        }
+        out << "startup stage=\"" << s.name << "\" thread=" << thread
+            << " begin_ms=" << s.begin_ms << " end_ms=" << s.end_ms
+            << " ms=" << s.end_ms - s.begin_ms << '\n';
+        float& covered = covered_ms[index];
+        work_ms += std::max(0.f, s.end_ms - std::max(s.begin_ms, covered));
+        covered = std::max(covered, s.end_ms);
+        wall_ms = std::max(wall_ms, s.end_ms);
+    }
+    out << "startup total work_ms=" << work_ms << " wall_ms=" << wall_ms
+        << std::endl;
+}
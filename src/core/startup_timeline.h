@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Spans of startup work on every thread, relative to the process start.
+// print() logs them with the milestones, one key=value line each, and
+// compares the summed work to the wall time it took, the gap is what
+// running it in parallel saved.
+class startup_timeline
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit startup_timeline(clock::time_point origin);
+
+    // Thread safe
+    void add(const std::string& name,
+             clock::time_point  begin,
+             clock::time_point  end);
+    // A point in time, e.g. "menu shown"
+    void mark(const char* name);
+
+    void print(std::ostream& out) const;
+
+    // The one the engine reports its stages to, nullptr outside startup
+    static startup_timeline* get_current() { return current; }
+    static void set_current(startup_timeline* t) { current = t; }
+
+    // Adds a span from construction to destruction, nothing for nullptr
+    class scope
+    {
+    public:
+        scope(startup_timeline& timeline, std::string name)
+            : scope(&timeline, std::move(name))
+        {
+        }
+        scope(startup_timeline* timeline, std::string name)
+            : timeline(timeline)
+            , name(std::move(name))
+            , begin(clock::now())
+        {
+        }
+        ~scope()
+        {
+            if (timeline != nullptr)
+                timeline->add(name, begin, clock::now());
+        }
+
+    private:
+        startup_timeline* timeline;
+        std::string       name;
+        clock::time_point begin;
+    };
+
+private:
+    struct span
+    {
+        std::string     name;
+        std::thread::id thread;
+        float           begin_ms = 0.f;
+        float           end_ms   = 0.f;
+        bool            is_mark  = false;
+    };
+
+    float to_ms(clock::time_point t) const;
+
+    clock::time_point  origin;
+    std::thread::id    main_thread;
+    std::vector<span>  spans;
+    mutable std::mutex mutex;
+
+    static std::atomic<startup_timeline*> current;
+};
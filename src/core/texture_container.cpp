@@ -0,0 +1,172 @@
+#include "texture_container.h"
+#include "asset_pack.h"
+#include "trace.h"
+
+#include <SDL3/SDL.h>
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+struct file_header
+{
+    uint32_t magic             = texture_container_magic;
+    uint32_t version           = texture_container_version;
+    uint32_t width             = 0;
+    uint32_t height            = 0;
+    uint32_t levels            = 0;
+    uint32_t compressed_format = 0;
+};
+
+struct level_entry
+{
+    uint32_t width  = 0;
+    uint32_t height = 0;
+    uint32_t offset = 0;
+    uint32_t size   = 0;
+};
+
+void read_exact(SDL_RWops* file, void* dst, size_t size, const char* path)
+{
+    if (file->read(file, dst, size) != size)
+    {
+        file->close(file);
+        throw std::runtime_error("truncated texture container: " +
+                                 std::string(path));
+    }
+}
+} // namespace
+
+size_t get_texture_level_size(texture_container::format format,
+                              uint32_t                  width,
+                              uint32_t                  height)
+{
+    const size_t blocks = size_t((width + 3) / 4) * ((height + 3) / 4);
+    switch (format)
+    {
+        case texture_container::format::etc2_rgb8:
+            return blocks * 8;
+        case texture_container::format::etc2_rgba8:
+            return blocks * 16;
+        default:
+            return size_t(width) * height * 4;
+    }
+}
+
+bool read_texture_container(const char*        path,
+                            bool               compressed,
+                            texture_container& result)
+{
+    TRACE_ZONE("read_texture_container");
+
+    SDL_RWops* file = open_asset(path);
+    if (file == nullptr)
+        return false;
+
+    file_header header;
+    read_exact(file, &header, sizeof(header), path);
+    if (header.magic != texture_container_magic ||
+        header.version != texture_container_version || header.levels == 0 ||
+        header.levels > 32)
+    {
+        file->close(file);
+        throw std::runtime_error("bad texture container: " +
+                                 std::string(path));
+    }
+
+    std::vector<level_entry> entries(header.levels * 2);
+    read_exact(file,
+               entries.data(),
+               entries.size() * sizeof(level_entry),
+               path);
+
+    result.chain_format =
+        compressed ? static_cast<texture_container::format>(
+                         header.compressed_format)
+                   : texture_container::format::rgba8;
+    result.levels.resize(header.levels);
+
+    const size_t first = compressed ? 0 : header.levels;
+    for (size_t i = 0; i < header.levels; i++)
+    {
+        const level_entry&        entry = entries[first + i];
+        texture_container::level& level = result.levels[i];
+        if (entry.size != get_texture_level_size(
+                              result.chain_format, entry.width, entry.height))
+        {
+            file->close(file);
+            throw std::runtime_error("bad texture level size: " +
+                                     std::string(path));
+        }
+
+        level.width  = entry.width;
+        level.height = entry.height;
+        level.data.resize(entry.size);
+        if (file->seek(file, entry.offset, SDL_RW_SEEK_SET) < 0)
+        {
+            file->close(file);
+            throw std::runtime_error("can't seek in: " + std::string(path));
+        }
+        read_exact(file, level.data.data(), entry.size, path);
+    }
+
+    file->close(file);
+    return true;
+}
+
+void write_texture_container(const char*              path,
+                             const texture_container& compressed,
+                             const texture_container& rgba)
+{
+    if (compressed.levels.empty() ||
+        compressed.levels.size() != rgba.levels.size())
+    {
+        throw std::runtime_error("mip chains differ in length");
+    }
+
+    file_header header;
+    header.width             = rgba.levels[0].width;
+    header.height            = rgba.levels[0].height;
+    header.levels            = static_cast<uint32_t>(rgba.levels.size());
+    header.compressed_format = static_cast<uint32_t>(compressed.chain_format);
+
+    std::vector<level_entry> entries;
+    uint32_t                 offset = static_cast<uint32_t>(
+        sizeof(header) + header.levels * 2 * sizeof(level_entry));
+    for (const texture_container* chain : { &compressed, &rgba })
+    {
+        for (const texture_container::level& level : chain->levels)
+        {
+            level_entry entry;
+            entry.width  = level.width;
+            entry.height = level.height;
+            entry.offset = offset;
+            entry.size   = static_cast<uint32_t>(level.data.size());
+            entries.push_back(entry);
+            offset += entry.size;
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()),
+               entries.size() * sizeof(level_entry));
+    for (const texture_container* chain : { &compressed, &rgba })
+    {
+        for (const texture_container::level& level : chain->levels)
+        {
+            file.write(reinterpret_cast<const char*>(level.data.data()),
+                       level.data.size());
+        }
+    }
+    if (!file)
+        throw std::runtime_error("can't write: " + std::string(path));
+}
+
+std::string get_texture_container_path(const char* png_path)
+{
+    const std::string path = png_path;
+    return path.substr(0, path.find_last_of('.')) + ".texc";
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Offline converted texture, written by tools/texture_converter. The file
+// holds the full mip chain twice: ETC2 blocks (GLES 3 baseline) and RGBA8
+// for drivers without ETC2. Only the chain that is asked for is read.
+//
+// layout: header, levels * 2 level_entry (compressed chain first), data
+struct texture_container
+{
+    enum class format : uint32_t
+    {
+        rgba8,
+        etc2_rgb8,  // 8 bytes per 4x4 block
+        etc2_rgba8, // EAC alpha + ETC2 color, 16 bytes per 4x4 block
+    };
+
+    struct level
+    {
+        uint32_t               width  = 0;
+        uint32_t               height = 0;
+        std::vector<std::byte> data;
+    };
+
+    format             chain_format = format::rgba8;
+    std::vector<level> levels;
+};
+
+constexpr uint32_t texture_container_magic   = 0x58543354; // "T3TX"
+constexpr uint32_t texture_container_version = 1;
+
+size_t get_texture_level_size(texture_container::format format,
+                              uint32_t                  width,
+                              uint32_t                  height);
+
+// Reads the ETC2 chain if compressed is set, the RGBA8 one otherwise. False
+// when the file is missing, throws when it is malformed.
+bool read_texture_container(const char*        path,
+                            bool               compressed,
+                            texture_container& result);
+
+void write_texture_container(const char*              path,
+                             const texture_container& compressed,
+                             const texture_container& rgba);
+
+// texture.png -> texture.texc
+std::string get_texture_container_path(const char* png_path);
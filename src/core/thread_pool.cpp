@@ -0,0 +1,71 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+
+thread_pool::thread_pool(size_t num_threads)
+{
+    if (num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < num_threads; i++)
+        workers.emplace_back(&thread_pool::worker_loop, this);
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void thread_pool::parallel_for(size_t                             count,
+                               const std::function<void(size_t)>& func)
+{
+    if (count == 0)
+        return;
+    if (count == 1 || workers.empty())
+    {
+        for (size_t i = 0; i < count; i++)
+            func(i);
+        return;
+    }
+
+    std::atomic<size_t> next{ 0 };
+    auto                run = [&]()
+    {
+        for (size_t i = next++; i < count; i = next++)
+            func(i);
+    };
+
+    const size_t             helpers = std::min(workers.size(), count - 1);
+    std::vector<std::future<void>> done;
+    done.reserve(helpers);
+    for (size_t i = 0; i < helpers; i++)
+        done.push_back(submit(run));
+
+    run();
+    for (std::future<void>& f : done)
+        f.get();
+}
+
+void thread_pool::worker_loop()
+{
+    for (;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return is_stopping || !jobs.empty(); });
+            if (is_stopping && jobs.empty())
+                return;
+            job = std::move(jobs.front());
+            jobs.pop();
+        }
+        job();
+    }
+}
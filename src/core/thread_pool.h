@@ -0,0 +1,50 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class thread_pool
+{
+public:
+    // 0 means one worker per hardware thread
+    explicit thread_pool(size_t num_threads = 0);
+    ~thread_pool();
+
+    thread_pool(const thread_pool&)            = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    template <class F>
+    auto submit(F&& task) -> std::future<decltype(task())>
+    {
+        using result_type = decltype(task());
+        auto job          = std::make_shared<std::packaged_task<result_type()>>(
+            std::forward<F>(task));
+        std::future<result_type> result = job->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.emplace([job]() { (*job)(); });
+        }
+        wake.notify_one();
+        return result;
+    }
+
+    // Calls func(i) for every i in [0, count) and waits for all of them. The
+    // calling thread takes part in the work.
+    void parallel_for(size_t count, const std::function<void(size_t)>& func);
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread>          workers;
+    std::queue<std::function<void()>> jobs;
+    std::mutex                        mutex;
+    std::condition_variable           wake;
+    bool                              is_stopping = false;
+};
@@ -0,0 +1,251 @@
+#include "trace.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trace
+{
+std::atomic<bool> is_recording{ false };
+
+namespace
+{
+struct trace_event
+{
+    enum class type : uint8_t
+    {
+        zone,
+        counter
+    };
+
+    const char* name;
+    uint64_t    start_ns;
+    uint64_t    end_ns;
+    double      value;
+    type        kind;
+};
+
+// Bumped by start(), a buffer filled during an earlier recording is emptied
+// by its owner on the next push
+std::atomic<uint32_t> recording_id{ 0 };
+
+// Filled only by its owner thread. Events go into fixed size chunks, a new
+// chunk is linked in when the last one is full, so readers can walk the
+// published part while the owner keeps writing.
+struct thread_buffer
+{
+    static constexpr size_t chunk_size = 4096;
+
+    struct chunk
+    {
+        trace_event         events[chunk_size];
+        std::atomic<size_t> count{ 0 };
+        std::atomic<chunk*> next{ nullptr };
+    };
+
+    thread_buffer() { tail = head = new chunk(); }
+    ~thread_buffer() { free_chunks(head); }
+
+    static void free_chunks(chunk* c)
+    {
+        while (c != nullptr)
+        {
+            chunk* next = c->next.load();
+            delete c;
+            c = next;
+        }
+    }
+
+    // Keeps the first chunk, the rest goes back to the heap
+    void clear()
+    {
+        free_chunks(head->next.exchange(nullptr));
+        head->count.store(0, std::memory_order_release);
+        tail = head;
+    }
+
+    void push(const trace_event& e)
+    {
+        const uint32_t current = recording_id.load(std::memory_order_relaxed);
+        if (generation != current)
+        {
+            clear();
+            generation = current;
+        }
+
+        size_t count = tail->count.load(std::memory_order_relaxed);
+        if (count == chunk_size)
+        {
+            chunk* c = new chunk();
+            tail->next.store(c, std::memory_order_release);
+            tail  = c;
+            count = 0;
+        }
+        tail->events[count] = e;
+        tail->count.store(count + 1, std::memory_order_release);
+    }
+
+    chunk*                   head       = nullptr;
+    chunk*                   tail       = nullptr;
+    uint32_t                 id         = 0;
+    uint32_t                 generation = 0; // Recording of the events
+    std::atomic<const char*> name{ nullptr };
+};
+
+std::mutex                                  buffers_mutex;
+std::vector<std::shared_ptr<thread_buffer>> buffers;
+
+const auto epoch = std::chrono::steady_clock::now();
+
+uint64_t start_time_ns = 0;
+uint64_t stop_time_ns  = UINT64_MAX;
+
+thread_buffer& get_thread_buffer()
+{
+    // Shared with the registry so the events outlive the thread
+    thread_local std::shared_ptr<thread_buffer> buffer;
+    if (!buffer)
+    {
+        buffer = std::make_shared<thread_buffer>();
+
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        buffer->id = static_cast<uint32_t>(buffers.size() + 1);
+        buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void write_string(std::ostream& out, const char* str)
+{
+    out << '"';
+    for (; *str != '\0'; str++)
+    {
+        if (*str == '"' || *str == '\\')
+            out << '\\';
+        out << *str;
+    }
+    out << '"';
+}
+} // namespace
+
+uint64_t now_ns()
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch)
+            .count());
+}
+
+// Buffers are emptied lazily by their owners. A thread that records nothing
+// this time keeps its old events, those are filtered out by time on save.
+void start()
+{
+    recording_id++;
+    start_time_ns = now_ns();
+    stop_time_ns  = UINT64_MAX;
+    is_recording  = true;
+}
+
+void stop()
+{
+    is_recording = false;
+    stop_time_ns = now_ns();
+}
+
+void set_thread_name(const char* name)
+{
+    get_thread_buffer().name.store(name, std::memory_order_release);
+}
+
+void counter(const char* name, double value)
+{
+    if (!is_recording.load(std::memory_order_relaxed))
+        return;
+
+    const uint64_t t = now_ns();
+    get_thread_buffer().push(
+        { name, t, t, value, trace_event::type::counter });
+}
+
+void add_zone(const char* name, uint64_t start_ns, uint64_t end_ns)
+{
+    get_thread_buffer().push(
+        { name, start_ns, end_ns, 0., trace_event::type::zone });
+}
+
+bool save(const char* path)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        std::cerr << "can't write trace: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<std::shared_ptr<thread_buffer>> threads;
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        threads = buffers;
+    }
+
+    size_t num_events = 0;
+    bool   is_first   = true;
+    auto   separator  = [&]()
+    {
+        if (!is_first)
+            out << ",\n";
+        is_first = false;
+    };
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    for (const auto& buffer : threads)
+    {
+        if (const char* name = buffer->name.load(std::memory_order_acquire))
+        {
+            separator();
+            out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+                << buffer->id << ",\"args\":{\"name\":";
+            write_string(out, name);
+            out << "}}";
+        }
+
+        const thread_buffer::chunk* c = buffer->head;
+        for (; c != nullptr; c = c->next.load(std::memory_order_acquire))
+        {
+            const size_t count = c->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; i++)
+            {
+                const trace_event& e = c->events[i];
+                if (e.start_ns < start_time_ns || e.end_ns > stop_time_ns)
+                    continue;
+
+                // Chrome wants microseconds
+                const double ts = (e.start_ns - start_time_ns) / 1000.;
+
+                separator();
+                out << "{\"name\":";
+                write_string(out, e.name);
+                if (e.kind == trace_event::type::zone)
+                    out << ",\"ph\":\"X\",\"dur\":"
+                        << (e.end_ns - e.start_ns) / 1000.;
+                else
+                    out << ",\"ph\":\"C\",\"args\":{\"value\":" << e.value
+                        << "}";
+                out << ",\"ts\":" << ts << ",\"pid\":1,\"tid\":" << buffer->id
+                    << "}";
+                num_events++;
+            }
+        }
+    }
+    out << "\n]}\n";
+
+    std::cout << "trace: " << num_events << " events written to " << path
+              << std::endl;
+    return static_cast<bool>(out);
+}
+} // namespace trace
@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lightweight tracing. Every thread records into its own buffer without
+// locks, save() writes everything as Chrome trace-event JSON (chrome://tracing,
+// ui.perfetto.dev). Zone, counter and thread names must be string literals.
+//
+// Configure with -DTETRIS_TRACING=OFF to compile all macros out.
+
+#ifdef USE_TRACING
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#define TRACE_ZONE(name)                                                       \
+    trace::scoped_zone TRACE_CONCAT(trace_zone_, __LINE__)(name)
+#define TRACE_FUNCTION() TRACE_ZONE(__func__)
+#define TRACE_COUNTER(name, value)                                             \
+    trace::counter(name, static_cast<double>(value))
+#define TRACE_THREAD_NAME(name) trace::set_thread_name(name)
+
+#else
+
+#define TRACE_ZONE(name)
+#define TRACE_FUNCTION()
+#define TRACE_COUNTER(name, value) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif
+
+namespace trace
+{
+extern std::atomic<bool> is_recording;
+
+void start();
+void stop();
+// Writes events recorded since start(), call after stop() and before the
+// next start()
+bool save(const char* path);
+
+void     set_thread_name(const char* name);
+void     counter(const char* name, double value);
+uint64_t now_ns();
+void     add_zone(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+class scoped_zone
+{
+public:
+    explicit scoped_zone(const char* zone_name)
+    {
+        if (is_recording.load(std::memory_order_relaxed))
+        {
+            name     = zone_name;
+            start_ns = now_ns();
+        }
+    }
+    ~scoped_zone()
+    {
+        if (name != nullptr)
+            add_zone(name, start_ns, now_ns());
+    }
+
+    scoped_zone(const scoped_zone&)            = delete;
+    scoped_zone& operator=(const scoped_zone&) = delete;
+
+private:
+    const char* name     = nullptr;
+    uint64_t    start_ns = 0;
+};
+} // namespace trace
@@ -0,0 +1,40 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Single producer / single consumer triple buffer. The producer always owns
+// one slot, the consumer owns another and the third one is exchanged between
+// them with a single atomic operation, so neither side ever waits.
+template <class T>
+class triple_buffer
+{
+public:
+    // Producer side
+    T& write_buffer() { return buffers[back]; }
+    void publish()
+    {
+        back = middle.exchange(back | dirty_bit, std::memory_order_acq_rel) &
+               index_mask;
+    }
+
+    // Consumer side. Returns true if a new value was published since the
+    // previous call.
+    bool update()
+    {
+        if ((middle.load(std::memory_order_relaxed) & dirty_bit) == 0)
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+        return true;
+    }
+    const T& read_buffer() const { return buffers[front]; }
+
+private:
+    static constexpr uint8_t dirty_bit  = 0x4;
+    static constexpr uint8_t index_mask = 0x3;
+
+    std::array<T, 3>     buffers{};
+    uint8_t              back  = 0;
+    std::atomic<uint8_t> middle{ 1 };
+    uint8_t              front = 2;
+};
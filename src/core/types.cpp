@@ -1,5 +1,6 @@
 #include "types.h"
 #include "SDL3/SDL_rwops.h"
+#include <algorithm>
 #include <string>
 
 color::rgba::rgba() {}
@@ -222,7 +223,58 @@ vertex3d_colored_textured::vertex3d_colored_textured(vertex3d    ver,
     this->uv   = uv;
 }
 
-membuff* load_file_to_memory(const char* path)
+static int32_t to_snorm(float value, int32_t max)
+{
+    return static_cast<int32_t>(
+        std::lround(std::clamp(value, -1.f, 1.f) * max));
+}
+
+static float from_snorm(int32_t value, int32_t max)
+{
+    return std::max(static_cast<float>(value) / max, -1.f);
+}
+
+// Sign extends a 10 bit field of the packed normal
+static int32_t normal_field(uint32_t normal, int shift)
+{
+    const int32_t field = static_cast<int32_t>((normal >> shift) & 0x3FF);
+    return field >= 512 ? field - 1024 : field;
+}
+
+vertex3d_packed::vertex3d_packed() {}
+vertex3d_packed::vertex3d_packed(const vertex3d_textured& ver,
+                                 float                    position_scale)
+{
+    pos[0] = static_cast<int16_t>(to_snorm(ver.pos.x / position_scale, 32767));
+    pos[1] = static_cast<int16_t>(to_snorm(ver.pos.y / position_scale, 32767));
+    pos[2] = static_cast<int16_t>(to_snorm(ver.pos.z / position_scale, 32767));
+    pos[3] = 0;
+
+    normal = (to_snorm(ver.normal.x, 511) & 0x3FF) |
+             (to_snorm(ver.normal.y, 511) & 0x3FF) << 10 |
+             (to_snorm(ver.normal.z, 511) & 0x3FF) << 20;
+
+    uv[0] = static_cast<uint16_t>(
+        std::lround(std::clamp(ver.uv.x, 0.f, 1.f) * 65535));
+    uv[1] = static_cast<uint16_t>(
+        std::lround(std::clamp(ver.uv.y, 0.f, 1.f) * 65535));
+}
+
+vertex3d_textured vertex3d_packed::unpack(float position_scale) const
+{
+    vertex3d_textured result;
+    result.pos.x    = from_snorm(pos[0], 32767) * position_scale;
+    result.pos.y    = from_snorm(pos[1], 32767) * position_scale;
+    result.pos.z    = from_snorm(pos[2], 32767) * position_scale;
+    result.normal.x = from_snorm(normal_field(normal, 0), 511);
+    result.normal.y = from_snorm(normal_field(normal, 10), 511);
+    result.normal.z = from_snorm(normal_field(normal, 20), 511);
+    result.uv.x     = uv[0] / 65535.f;
+    result.uv.y     = uv[1] / 65535.f;
+    return result;
+}
+
+membuff load_file_to_memory(const char* path)
 {
     SDL_RWops* file = SDL_RWFromFile(path, "rb");
     if (file == nullptr)
@@ -233,6 +285,7 @@ membuff* load_file_to_memory(const char* path)
     Sint64 file_size = file->size(file);
     if (file_size == -1)
     {
+        file->close(file);
         throw std::runtime_error("can't determine size of file: " +
                                  std::string(path));
     }
@@ -242,6 +295,7 @@ membuff* load_file_to_memory(const char* path)
     const size_t num_readed_objects = file->read(file, mem.get(), size);
     if (num_readed_objects != size)
     {
+        file->close(file);
         throw std::runtime_error("can't read all content from file: " +
                                  std::string(path));
     }
@@ -250,6 +304,5 @@ membuff* load_file_to_memory(const char* path)
     {
         throw std::runtime_error("failed close file: " + std::string(path));
     }
-    mem[size] = 0;
-    return new membuff{ std::move(mem), size };
+    return membuff{ std::move(mem), size };
 }
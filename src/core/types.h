@@ -11,6 +11,12 @@
 #include <memory>
 #include <stdexcept>
 
+#ifdef NDEBUG
+// glGetError waits for the driver, release builds skip it
+#define GL_CHECK_ERRORS()                                                      \
+    {                                                                          \
+    }
+#else
 #define GL_CHECK_ERRORS()                                                      \
     {                                                                          \
         const GLenum err = glGetError();                                       \
@@ -40,6 +46,13 @@
             assert(false);                                                     \
         }                                                                      \
     }
+#endif
+
+enum class buffer_usage
+{
+    static_draw, // Owns a GL buffer
+    stream,      // Frame memory (stream_buffer_opengl), valid until swap
+};
 
 struct uniform
 {
@@ -48,25 +61,27 @@ struct uniform
     float width  = 0.f; // Resolution
     float height = 0.f;
 
-    float* rotate_alpha_obj; // Rotate object
-    float* rotate_beta_obj;
-    float* rotate_gamma_obj;
+    float rotate_alpha_obj = 0.f; // Rotate object
+    float rotate_beta_obj  = 0.f;
+    float rotate_gamma_obj = 0.f;
+
+    float rotate_alpha_camera = 0.f; // Rotate camera
+    float rotate_beta_camera  = 0.f;
+    float rotate_gamma_camera = 0.f;
 
-    float* rotate_alpha_camera; // Rotate camera
-    float* rotate_beta_camera;
-    float* rotate_gamma_camera;
+    float translate_x_obj = 0.f; // Translate object
+    float translate_y_obj = 0.f;
+    float translate_z_obj = 0.f;
 
-    float* translate_x_obj; // Translate object
-    float* translate_y_obj;
-    float* translate_z_obj;
+    float translate_x_camera = 0.f; // Translate camera
+    float translate_y_camera = 0.f;
+    float translate_z_camera = 0.f;
 
-    float* translate_x_camera; // Translate camera
-    float* translate_y_camera;
-    float* translate_z_camera;
+    float scale_x_obj = 1.f; // Scale object
+    float scale_y_obj = 1.f;
+    float scale_z_obj = 1.f;
 
-    float* scale_x_obj; // Scale object
-    float* scale_y_obj;
-    float* scale_z_obj;
+    float position_scale = 1.f; // Decodes vertex3d_packed positions
 };
 
 struct vertex3d;
@@ -277,6 +292,26 @@ struct vertex3d_colored_textured : vertex3d
         sizeof(vertex3d) + sizeof(color::rgba);
 };
 
+// Compact vertex3d_textured, 16 bytes instead of 32. Positions are snorm16
+// of pos / position_scale, the per-mesh scale is the largest coordinate and
+// is applied in the vertex shader. Normals are snorm 10:10:10:2
+// (GL_INT_2_10_10_10_REV), uv is unorm16 and so limited to [0, 1].
+struct vertex3d_packed
+{
+    vertex3d_packed();
+    vertex3d_packed(const vertex3d_textured& ver, float position_scale);
+
+    vertex3d_textured unpack(float position_scale) const;
+
+    int16_t  pos[4]; // w only pads the normal to 4 byte alignment
+    uint32_t normal;
+    uint16_t uv[2];
+
+    static const uint8_t OFFSET_POSITION = 0;
+    static const uint8_t OFFSET_NORMAL   = 4 * sizeof(int16_t);
+    static const uint8_t OFFSET_TEXTURE  = OFFSET_NORMAL + sizeof(uint32_t);
+};
+
 inline float dot(const vector3d& x, const vector3d& y)
 {
     return x.x * y.x + x.y * y.y + x.z * y.z;
@@ -334,7 +369,8 @@ struct membuff
     size_t                  size = 0;
 };
 
-membuff* load_file_to_memory(const char* path);
+// Reads the whole file, throws when it is missing or unreadable
+membuff load_file_to_memory(const char* path);
 
 struct image
 {
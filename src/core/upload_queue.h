@@ -0,0 +1,57 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// Work that must run on the render thread, GL uploads mostly, queued by
+// loader jobs on other threads.
+class upload_queue
+{
+public:
+    void push(std::function<void()> upload)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            uploads.push_back(std::move(upload));
+        }
+        ready.notify_one();
+    }
+
+    // Runs queued uploads until the queue is empty or budget_ms has passed,
+    // at least one per call. Returns the number left.
+    size_t run(float budget_ms)
+    {
+        using clock      = std::chrono::steady_clock;
+        using ms         = std::chrono::duration<float, std::milli>;
+        const auto start = clock::now();
+        for (bool is_first = true;; is_first = false)
+        {
+            std::function<void()> upload;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (uploads.empty())
+                    return 0;
+                if (!is_first && ms(clock::now() - start).count() > budget_ms)
+                    return uploads.size();
+                upload = std::move(uploads.front());
+                uploads.pop_front();
+            }
+            upload();
+        }
+    }
+
+    // Blocks until something is queued
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this]() { return !uploads.empty(); });
+    }
+
+private:
+    std::deque<std::function<void()>> uploads;
+    std::mutex                        mutex;
+    std::condition_variable           ready;
+};
@@ -1,14 +1,10 @@
 #include "audio_buffer.h"
+#include "core/asset_pack.h"
 #include <stdexcept>
 
-audio_buffer::audio_buffer(const char*   path,
-                           uint32_t      device_,
-                           SDL_AudioSpec audio_spec,
-                           bool          is_looped_)
-    : device(device_)
-    , is_looped(is_looped_)
+audio_buffer::audio_buffer(const char* path, const SDL_AudioSpec& audio_spec)
 {
-    SDL_RWops* file = SDL_RWFromFile(path, "rb");
+    SDL_RWops* file = open_asset(path);
     if (file == nullptr)
     {
         throw std::runtime_error(std::string("can't open audio file: ") + path);
@@ -41,6 +37,7 @@ audio_buffer::audio_buffer(const char*   path,
                                                      &output_length);
         if (0 != convert_status)
         {
+            SDL_free(buffer);
             throw std::runtime_error(
                 std::string("failed to convert WAV byte stream: ") +
                 SDL_GetError());
@@ -59,6 +56,4 @@ audio_buffer::audio_buffer(const char*   path,
 audio_buffer::~audio_buffer()
 {
     SDL_free(buffer);
-    // buffer = nullptr;
-    length = 0;
 }
@@ -1,24 +1,18 @@
 #pragma once
 #include "SDL3/SDL.h"
-#include <memory>
-#include <mutex>
+#include <cstdint>
 
-#pragma pack(push, 1)
+// A wav file decoded and converted to the mixer format once. Immutable
+// after construction, voices in audio_mixer only read it.
 class audio_buffer
 {
 public:
-    audio_buffer(const char*   path,
-                 uint32_t      device,
-                 SDL_AudioSpec audio_spec,
-                 bool          is_looped);
+    audio_buffer(const char* path, const SDL_AudioSpec& audio_spec);
     ~audio_buffer();
 
-    // std::unique_ptr<uint8_t*> tmp_buf;
-    uint8_t*          buffer        = nullptr;
-    uint32_t          length        = 0;
-    uint32_t          current_index = 0;
-    SDL_AudioDeviceID device;
-    bool              is_playing = false;
-    bool              is_looped  = false;
+    audio_buffer(const audio_buffer&)            = delete;
+    audio_buffer& operator=(const audio_buffer&) = delete;
+
+    uint8_t* buffer = nullptr;
+    uint32_t length = 0; // Bytes
 };
-#pragma pack(pop)
@@ -0,0 +1,277 @@
+#include "audio_mixer.h"
+#include "core/trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+static sample_format get_sample_format(SDL_AudioFormat format)
+{
+    switch (format)
+    {
+        case SDL_AUDIO_U8:
+            return sample_format::u8;
+        case SDL_AUDIO_S16LSB:
+            return sample_format::s16;
+        case SDL_AUDIO_S32LSB:
+            return sample_format::s32;
+        case SDL_AUDIO_F32LSB:
+            return sample_format::f32;
+        default:
+            throw std::runtime_error("audio mixer: unsupported device format");
+    }
+}
+
+audio_mixer::audio_mixer(const SDL_AudioSpec& device_spec)
+    : spec(device_spec)
+    , device_format(get_sample_format(device_spec.format))
+    , device_frame_bytes(SDL_AUDIO_BITSIZE(device_spec.format) / 8 *
+                         device_spec.channels)
+    , bus_frame_bytes(sizeof(float) * device_spec.channels)
+    , bus(size_t(bus_frames) * device_spec.channels)
+    , scratch(bus.size())
+    , limiter(static_cast<uint32_t>(device_spec.freq))
+{
+    spec.format = SDL_AUDIO_F32;
+}
+
+bool audio_mixer::play(const audio_buffer* sound,
+                       bool                is_looped,
+                       uint8_t             priority,
+                       float               volume,
+                       float               pan)
+{
+    command cmd;
+    cmd.kind      = command::type::play;
+    cmd.sound     = sound;
+    cmd.volume    = volume;
+    cmd.pan       = pan;
+    cmd.priority  = priority;
+    cmd.is_looped = is_looped;
+    return commands.push(cmd);
+}
+
+bool audio_mixer::stop(const audio_buffer* sound)
+{
+    command cmd;
+    cmd.kind  = command::type::stop;
+    cmd.sound = sound;
+    return commands.push(cmd);
+}
+
+bool audio_mixer::set_volume(const audio_buffer* sound, float volume)
+{
+    command cmd;
+    cmd.kind   = command::type::set_volume;
+    cmd.sound  = sound;
+    cmd.volume = volume;
+    return commands.push(cmd);
+}
+
+bool audio_mixer::play(music_stream* music, uint8_t priority, float volume)
+{
+    command cmd;
+    cmd.kind     = command::type::play;
+    cmd.music    = music;
+    cmd.volume   = volume;
+    cmd.priority = priority;
+    return commands.push(cmd);
+}
+
+bool audio_mixer::stop(music_stream* music)
+{
+    command cmd;
+    cmd.kind  = command::type::stop;
+    cmd.music = music;
+    return commands.push(cmd);
+}
+
+bool audio_mixer::set_volume(music_stream* music, float volume)
+{
+    command cmd;
+    cmd.kind   = command::type::set_volume;
+    cmd.music  = music;
+    cmd.volume = volume;
+    return commands.push(cmd);
+}
+
+audio_mixer::voice* audio_mixer::find_voice(uint8_t priority)
+{
+    voice* victim = nullptr;
+    for (voice& v : voices)
+    {
+        if (v.is_free())
+            return &v;
+        if (v.priority > priority)
+            continue;
+        if (victim == nullptr || v.priority < victim->priority ||
+            (v.priority == victim->priority && v.position > victim->position))
+            victim = &v;
+    }
+    return victim;
+}
+
+void audio_mixer::apply(const command& cmd)
+{
+    switch (cmd.kind)
+    {
+        case command::type::play:
+        {
+            voice* v = nullptr;
+            if (cmd.music != nullptr)
+            {
+                auto it = std::find_if(
+                    voices.begin(), voices.end(), [&cmd](const voice& other) {
+                        return other.is_playing(cmd);
+                    });
+                v = it != voices.end() ? &*it : find_voice(cmd.priority);
+            }
+            else if (cmd.sound->length >= bus_frame_bytes)
+            {
+                v = find_voice(cmd.priority);
+            }
+            if (v == nullptr)
+                return;
+            v->sound     = cmd.sound;
+            v->music     = cmd.music;
+            v->position  = 0;
+            v->volume    = std::clamp(cmd.volume, 0.f, 1.f);
+            v->pan       = std::clamp(cmd.pan, -1.f, 1.f);
+            v->priority  = cmd.priority;
+            v->is_looped = cmd.is_looped;
+            return;
+        }
+        case command::type::stop:
+            for (voice& v : voices)
+            {
+                if (v.is_playing(cmd))
+                    v = voice{};
+            }
+            return;
+        case command::type::set_volume:
+            for (voice& v : voices)
+            {
+                if (v.is_playing(cmd))
+                    v.volume = std::clamp(cmd.volume, 0.f, 1.f);
+            }
+            return;
+    }
+}
+
+void audio_mixer::mix(uint8_t* stream, uint32_t size)
+{
+    TRACE_ZONE("audio_mixer::mix");
+    const auto start = std::chrono::steady_clock::now();
+
+    command cmd;
+    while (commands.pop(cmd))
+        apply(cmd);
+
+    const uint32_t frames_total = size / device_frame_bytes;
+    lowest_fill                 = -1.f;
+    for (uint32_t done = 0; done < frames_total;)
+    {
+        const uint32_t frames = std::min(bus_frames, frames_total - done);
+        std::fill_n(bus.begin(), size_t(frames) * spec.channels, 0.f);
+
+        for (voice& v : voices)
+        {
+            if (v.music != nullptr)
+                mix_music(v, frames);
+            else if (v.sound != nullptr)
+                mix_sound(v, frames);
+        }
+
+        limiter.process(bus.data(), frames, spec.channels);
+        mix_convert(bus.data(),
+                    size_t(frames) * spec.channels,
+                    device_format,
+                    stream + size_t(done) * device_frame_bytes);
+        done += frames;
+    }
+
+    update_stats(frames_total,
+                 std::chrono::duration<float, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count());
+}
+
+void audio_mixer::update_stats(uint32_t frames, float ms)
+{
+    constexpr float smoothing = 0.1f;
+    constexpr float decay     = 0.995f; // Per callback, ~5 s at 1024 frames
+    constexpr float recovery  = 0.005f; // Fill per callback
+
+    const float budget_ms = 1000.f * frames / spec.freq;
+    if (ms > budget_ms)
+        over_budget++;
+    buffer_frames = frames;
+    callback_ms   = callback_ms + (ms - callback_ms) * smoothing;
+    max_callback_ms = std::max(ms, max_callback_ms * decay);
+    if (lowest_fill < 0.f)
+        music_fill = -1.f;
+    else if (music_fill < 0.f)
+        music_fill = lowest_fill;
+    else
+        music_fill = std::min(lowest_fill, music_fill + recovery);
+    callbacks++;
+}
+
+audio_stats audio_mixer::get_stats() const
+{
+    audio_stats stats;
+    stats.buffer_frames   = buffer_frames;
+    stats.budget_ms       = 1000.f * stats.buffer_frames / spec.freq;
+    stats.callback_ms     = callback_ms;
+    stats.max_callback_ms = max_callback_ms;
+    stats.music_fill      = music_fill;
+    stats.callbacks       = callbacks;
+    stats.underruns       = underruns;
+    stats.over_budget     = over_budget;
+    return stats;
+}
+
+void audio_mixer::mix_sound(voice& v, uint32_t frames)
+{
+    // A looped voice wraps around within one pass
+    const uint32_t length =
+        v.sound->length / bus_frame_bytes * bus_frame_bytes;
+    uint32_t done = 0;
+    while (v.sound != nullptr && done < frames)
+    {
+        const uint32_t rest = (length - v.position) / bus_frame_bytes;
+        const uint32_t part = std::min(rest, frames - done);
+        mix_add(bus.data() + size_t(done) * spec.channels,
+                reinterpret_cast<const float*>(v.sound->buffer + v.position),
+                part,
+                spec.channels,
+                v.volume,
+                v.pan);
+        done += part;
+        v.position += part * bus_frame_bytes;
+
+        if (v.position == length)
+        {
+            v.position = 0;
+            if (!v.is_looped)
+                v.sound = nullptr;
+        }
+    }
+}
+
+void audio_mixer::mix_music(voice& v, uint32_t frames)
+{
+    const float fill = v.music->get_fill();
+    lowest_fill = lowest_fill < 0.f ? fill : std::min(lowest_fill, fill);
+
+    // A short read leaves silence
+    const uint32_t got =
+        v.music->read(reinterpret_cast<uint8_t*>(scratch.data()),
+                      frames * bus_frame_bytes) /
+        bus_frame_bytes;
+    mix_add(bus.data(), scratch.data(), got, spec.channels, v.volume, v.pan);
+    if (v.music->is_finished())
+        v = voice{};
+    else if (got < frames)
+        underruns++;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "audio_buffer.h"
+#include "core/audio_mix.h"
+#include "core/spsc_queue.h"
+#include "music_stream.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Mixes the playing voices into the device stream. The game talks to it
+// through a lock-free command ring and the voices belong to the audio
+// thread alone, so mix() never waits on a lock or on decoding. Voices only
+// point into the shared decoded sounds or pull from a music stream,
+// nothing is allocated after construction.
+//
+// Sources are float in the device channel layout and rate (get_spec()).
+// Every voice is added to a float bus with its gain and pan, the bus goes
+// through a limiter and is converted to the device format once.
+class audio_mixer
+{
+public:
+    static constexpr size_t   voice_count = 16;
+    static constexpr uint32_t bus_frames  = 1024; // Per mixing pass
+
+    // Throws for a device format the bus can't convert to
+    explicit audio_mixer(const SDL_AudioSpec& device_spec);
+
+    // What sounds and music streams have to be converted to
+    const SDL_AudioSpec& get_spec() const { return spec; }
+
+    // One producer thread. False when the command ring is full, the command
+    // is dropped then. With every voice busy a new sound takes the one with
+    // the lowest priority, if that is not above its own, and the one that
+    // played longest among equals.
+    bool play(const audio_buffer* sound,
+              bool                is_looped,
+              uint8_t             priority,
+              float               volume = 1.f,
+              float               pan    = 0.f);
+    // Every voice of sound
+    bool stop(const audio_buffer* sound);
+    bool set_volume(const audio_buffer* sound, float volume);
+
+    // A stream plays on one voice at most, playing it again only updates
+    // the volume and priority. Its voice is freed once it is finished.
+    bool play(music_stream* music, uint8_t priority, float volume = 1.f);
+    bool stop(music_stream* music);
+    bool set_volume(music_stream* music, float volume);
+
+    // Audio thread: applies the queued commands, then fills stream
+    void mix(uint8_t* stream, uint32_t size);
+
+    // Any thread, backend is left for the caller
+    audio_stats get_stats() const;
+
+private:
+    struct command
+    {
+        enum class type : uint8_t
+        {
+            play,
+            stop,
+            set_volume
+        };
+
+        type                kind      = type::play;
+        const audio_buffer* sound     = nullptr;
+        music_stream*       music     = nullptr;
+        float               volume    = 1.f;
+        float               pan       = 0.f;
+        uint8_t             priority  = 0;
+        bool                is_looped = false;
+    };
+
+    struct voice
+    {
+        const audio_buffer* sound     = nullptr; // Both nullptr when free
+        music_stream*       music     = nullptr;
+        uint32_t            position  = 0; // Bytes
+        float               volume    = 1.f;
+        float               pan       = 0.f;
+        uint8_t             priority  = 0;
+        bool                is_looped = false;
+
+        bool is_free() const { return sound == nullptr && music == nullptr; }
+        bool is_playing(const command& cmd) const
+        {
+            return (cmd.sound != nullptr && sound == cmd.sound) ||
+                   (cmd.music != nullptr && music == cmd.music);
+        }
+    };
+
+    void   apply(const command& cmd);
+    voice* find_voice(uint8_t priority);
+    void   mix_sound(voice& v, uint32_t frames);
+    void   mix_music(voice& v, uint32_t frames);
+    void   update_stats(uint32_t frames, float ms);
+
+    SDL_AudioSpec                  spec; // Device layout, float samples
+    sample_format                  device_format;
+    uint32_t                       device_frame_bytes;
+    uint32_t                       bus_frame_bytes;
+    spsc_queue<command, 64>        commands;
+    std::array<voice, voice_count> voices{};
+    std::vector<float>             bus;
+    std::vector<float>             scratch; // Music pulled per pass
+    audio_limiter                  limiter;
+
+    // Written by the audio thread only
+    float                 lowest_fill = -1.f; // This pass, -1 without music
+    std::atomic<uint32_t> buffer_frames{ 0 };
+    std::atomic<float>    callback_ms{ 0.f };
+    std::atomic<float>    max_callback_ms{ 0.f };
+    std::atomic<float>    music_fill{ -1.f };
+    std::atomic<uint64_t> callbacks{ 0 };
+    std::atomic<uint32_t> underruns{ 0 };
+    std::atomic<uint32_t> over_budget{ 0 };
+};
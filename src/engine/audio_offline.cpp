@@ -0,0 +1,100 @@
+#include "audio_offline.h"
+#include "core/trace.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+audio_offline::audio_offline(const char* path, const SDL_AudioSpec& spec)
+    : spec(spec)
+{
+    if (path != nullptr)
+    {
+        file.open(path, std::ios::binary);
+        if (!file)
+            throw std::runtime_error(std::string("can't create ") + path);
+    }
+
+    switch (spec.format)
+    {
+        case SDL_AUDIO_U8:
+        case SDL_AUDIO_S16LSB:
+        case SDL_AUDIO_S32LSB:
+            format_tag = 1; // PCM
+            break;
+        case SDL_AUDIO_F32LSB:
+            format_tag = 3; // IEEE float
+            break;
+        default:
+            throw std::runtime_error("no wav format for the audio spec");
+    }
+
+    buffer.resize(size_t(spec.samples) * spec.channels *
+                  (SDL_AUDIO_BITSIZE(spec.format) / 8));
+    if (file.is_open())
+        write_header();
+    worker = std::thread(&audio_offline::run, this);
+}
+
+audio_offline::~audio_offline()
+{
+    is_running = false;
+    worker.join();
+
+    if (!file.is_open())
+        return;
+    file.seekp(0);
+    write_header();
+}
+
+void audio_offline::write_header()
+{
+    auto put = [this](const void* data, size_t size)
+    { file.write(static_cast<const char*>(data), size); };
+    auto put16 = [&put](uint16_t value) { put(&value, sizeof(value)); };
+    auto put32 = [&put](uint32_t value) { put(&value, sizeof(value)); };
+
+    const uint16_t bytes       = SDL_AUDIO_BITSIZE(spec.format) / 8;
+    const uint16_t frame_bytes = bytes * spec.channels;
+
+    put("RIFF", 4);
+    put32(36 + data_bytes);
+    put("WAVE", 4);
+    put("fmt ", 4);
+    put32(16);
+    put16(format_tag);
+    put16(spec.channels);
+    put32(static_cast<uint32_t>(spec.freq));
+    put32(static_cast<uint32_t>(spec.freq) * frame_bytes);
+    put16(frame_bytes);
+    put16(bytes * 8);
+    put("data", 4);
+    put32(data_bytes);
+}
+
+void audio_offline::run()
+{
+    TRACE_THREAD_NAME("audio");
+    using clock = std::chrono::steady_clock;
+
+    const auto period = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(double(spec.samples) / spec.freq));
+    auto next = clock::now();
+    while (is_running)
+    {
+        spec.callback(
+            spec.userdata, buffer.data(), static_cast<int>(buffer.size()));
+        if (file.is_open())
+        {
+            file.write(reinterpret_cast<const char*>(buffer.data()),
+                       static_cast<std::streamsize>(buffer.size()));
+            data_bytes += static_cast<uint32_t>(buffer.size());
+        }
+
+        next += period;
+        const auto now = clock::now();
+        if (now > next + period)
+            next = now; // More than a period behind
+        std::this_thread::sleep_until(next);
+    }
+}
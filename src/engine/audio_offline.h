@@ -0,0 +1,38 @@
+#pragma once
+#include "SDL3/SDL.h"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+// Stands in for an audio device. A thread of its own calls spec.callback
+// for spec.samples frames at the pace a device would and appends the result
+// to a wav file, so the mix can be listened to or compared after a headless
+// run. Without a path the result is dropped, that is the null backend.
+// Falling behind the pace resyncs instead of catching up in a burst.
+class audio_offline
+{
+public:
+    // path may be nullptr. Throws when the file can't be created or the
+    // format has no wav tag.
+    audio_offline(const char* path, const SDL_AudioSpec& spec);
+    // Stops the thread and writes the final sizes into the header
+    ~audio_offline();
+
+    audio_offline(const audio_offline&)            = delete;
+    audio_offline& operator=(const audio_offline&) = delete;
+
+private:
+    void write_header();
+    void run();
+
+    std::ofstream        file;
+    SDL_AudioSpec        spec;
+    uint16_t             format_tag = 0;
+    uint32_t             data_bytes = 0;
+    std::vector<uint8_t> buffer;
+    std::atomic<bool>    is_running{ true };
+    std::thread          worker;
+};
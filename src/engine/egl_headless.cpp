@@ -0,0 +1,120 @@
+#include "egl_headless.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <iostream>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static EGLDisplay egl_display = EGL_NO_DISPLAY;
+static EGLContext egl_context = EGL_NO_CONTEXT;
+
+static EGLDisplay get_surfaceless_display()
+{
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions != nullptr &&
+        std::strstr(extensions, "EGL_MESA_platform_surfaceless") != nullptr)
+    {
+        auto get_platform_display =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display != nullptr)
+            return get_platform_display(
+                EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool egl_headless_create_context()
+{
+    egl_display = get_surfaceless_display();
+    if (egl_display == EGL_NO_DISPLAY)
+    {
+        std::cerr << "egl: no display" << std::endl;
+        return false;
+    }
+
+    EGLint major = 0;
+    EGLint minor = 0;
+    if (!eglInitialize(egl_display, &major, &minor))
+    {
+        std::cerr << "egl: can't initialize display" << std::endl;
+        return false;
+    }
+    std::cout << "egl: " << major << "." << minor << " "
+              << eglQueryString(egl_display, EGL_VENDOR) << std::endl;
+
+    const char* extensions = eglQueryString(egl_display, EGL_EXTENSIONS);
+    if (extensions == nullptr ||
+        std::strstr(extensions, "EGL_KHR_surfaceless_context") == nullptr)
+    {
+        std::cerr << "egl: EGL_KHR_surfaceless_context is not supported"
+                  << std::endl;
+        return false;
+    }
+
+    const EGLint config_attributes[] = { EGL_RENDERABLE_TYPE,
+                                         EGL_OPENGL_ES3_BIT,
+                                         EGL_SURFACE_TYPE,
+                                         EGL_PBUFFER_BIT,
+                                         EGL_NONE };
+    EGLConfig    egl_config          = nullptr;
+    EGLint       num_configs         = 0;
+    if (!eglChooseConfig(
+            egl_display, config_attributes, &egl_config, 1, &num_configs) ||
+        num_configs == 0)
+    {
+        std::cerr << "egl: no GLES3 config" << std::endl;
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_ES_API))
+    {
+        std::cerr << "egl: can't bind GLES api" << std::endl;
+        return false;
+    }
+
+    const EGLint context_attributes[] = { EGL_CONTEXT_MAJOR_VERSION,
+                                          3,
+                                          EGL_CONTEXT_MINOR_VERSION,
+                                          0,
+                                          EGL_NONE };
+    egl_context                       = eglCreateContext(
+        egl_display, egl_config, EGL_NO_CONTEXT, context_attributes);
+    if (egl_context == EGL_NO_CONTEXT)
+    {
+        std::cerr << "egl: can't create context" << std::endl;
+        return false;
+    }
+
+    if (!eglMakeCurrent(
+            egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context))
+    {
+        std::cerr << "egl: can't make context current" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void egl_headless_destroy_context()
+{
+    if (egl_display == EGL_NO_DISPLAY)
+        return;
+
+    eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (egl_context != EGL_NO_CONTEXT)
+        eglDestroyContext(egl_display, egl_context);
+    eglTerminate(egl_display);
+
+    egl_context = EGL_NO_CONTEXT;
+    egl_display = EGL_NO_DISPLAY;
+}
+
+void* egl_headless_get_proc_address(const char* name)
+{
+    return reinterpret_cast<void*>(eglGetProcAddress(name));
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+// Surfaceless EGL context for rendering without a window system, e.g. Mesa
+// llvmpipe on a build machine. Only available when USE_EGL_HEADLESS is
+// defined, the caller renders into its own framebuffer object.
+bool  egl_headless_create_context();
+void  egl_headless_destroy_context();
+void* egl_headless_get_proc_address(const char* name);
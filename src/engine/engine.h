@@ -1,6 +1,8 @@
 #pragma once
+#include "core/audio_mix.h"
 #include "core/config.h"
 #include "core/event.h"
+#include "core/resource_cache.h"
 #include "core/types.h"
 #include "index_buffer.h"
 #include "objects/figure.h"
@@ -9,8 +11,17 @@
 #include "vertex_buffer.h"
 
 #include <iostream>
+#include <memory>
 #include <vector>
 
+// Render passes measured with GPU timer queries
+enum class gpu_pass : uint8_t
+{
+    scene,
+    ui,
+    count
+};
+
 class engine
 {
 public:
@@ -45,6 +56,12 @@ public:
                                   const texture*,
                                   const uint16_t*,
                                   size_t) = 0;
+    // Positions are decoded with uniform::position_scale
+    virtual void render_triangles(vertex_buffer<vertex3d_packed>*,
+                                  index_buffer*,
+                                  const texture*,
+                                  const uint16_t*,
+                                  size_t) = 0;
     virtual void render_triangles(
         vertex_buffer<vertex2d_colored_textured>* vertexes,
         index_buffer*                             indexes,
@@ -54,15 +71,76 @@ public:
 
     virtual void swap_buffers() = 0;
 
-    virtual void     reload_uniform()                               = 0;
-    virtual texture* load_texture(uint32_t index, const char* path) = 0;
+    // The 3D scene is drawn between these, possibly into a smaller target
+    // that end_scene() scales up to the window. UI is drawn after it at the
+    // native resolution.
+    virtual void  begin_scene()                = 0;
+    virtual void  end_scene()                  = 0;
+    virtual float get_resolution_scale() const = 0;
+
+    virtual void reload_uniform() = 0;
+
+    // Textures are shared by path, loading a file that is still resident
+    // returns the same texture. It is freed with its last handle.
+    virtual std::shared_ptr<texture> load_texture(uint32_t    index,
+                                                  const char* path) = 0;
+
+    // load_texture() in two halves. read_texture() only decodes and may run
+    // on any thread, the upload runs on the render thread.
+    virtual texture_source           read_texture(const char* path) const = 0;
+    virtual std::shared_ptr<texture> load_texture(uint32_t         index,
+                                                  texture_source&& source) = 0;
+    virtual resource_cache_stats     get_texture_cache_stats() const      = 0;
+    // Replaces the texels of the resident texture for source.path, handles
+    // to it stay valid. False when it is not loaded. Render thread only.
+    virtual bool reload_texture(texture_source&& source) = 0;
 
     virtual void set_texture(uint32_t index)         = 0;
-    virtual void set_uniform(uniform& uni)           = 0;
+    virtual void set_uniform(const uniform& uni)     = 0;
     virtual void set_shader(shader* shader)          = 0;
     virtual void set_relative_mouse_mode(bool state) = 0;
+    // shader_feature bits of the scene material for the following draws.
+    // Backends without shader programs branch on them, capped by
+    // config::quality. GL gets them from the permutation in set_shader().
+    virtual void set_shader_features(uint32_t features) = 0;
+
+    // Queue a command for the mixer and return, from one thread only (the
+    // render thread). Sounds are cached by path hash and have to be
+    // preloaded, playing one never decodes. One that wasn't, or failed to
+    // decode, is skipped and logged once.
+    // When the voices run out, higher priority sounds keep theirs.
+    virtual void play_sound(const char* path,
+                            bool        is_looped,
+                            uint8_t     priority = 0)             = 0;
+    virtual void stop_sound(const char* path)                     = 0;
+    virtual void set_sound_volume(const char* path, float volume) = 0;
+    // Decodes and converts the file for a later play_sound(), any thread.
+    // A looped one is streamed instead, only a small ring stays resident.
+    virtual void preload_sound(const char* path, bool is_looped) = 0;
+
+    // Audio backend in use and the timing of its callbacks, any thread
+    virtual audio_stats get_audio_stats() const = 0;
+
+    // Writes the frame finished by the next swap_buffers() to a png file
+    virtual void capture_frame(const char* path) = 0;
+
+    // GPU time per pass, results lag a few frames behind. get_gpu_pass_ms()
+    // returns false when the driver has no timer queries or timing is off.
+    virtual void set_gpu_timing(bool state)                      = 0;
+    virtual void begin_gpu_pass(gpu_pass pass)                   = 0;
+    virtual void end_gpu_pass(gpu_pass pass)                     = 0;
+    virtual bool get_gpu_pass_ms(gpu_pass pass, float& ms) const = 0;
+
+    // Memory held by loaded textures on the device, mip levels included
+    virtual size_t get_texture_bytes() const = 0;
+
+    // Whether index_buffer may hold 32 bit indexes, else meshes with more
+    // than 65536 vertexes are drawn as 16 bit meshlets
+    virtual bool has_32bit_indexes() const = 0;
 
-    virtual void play_sound(const char* path, bool is_looped) = 0;
+    // Time the CPU blocked last frame before rewriting per frame vertex
+    // data the GPU was still reading
+    virtual float get_fence_wait_ms() const = 0;
 
 protected:
     config _config;
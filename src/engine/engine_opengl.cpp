@@ -1,10 +1,21 @@
 #include "engine_opengl.h"
 
 #include "audio_buffer.h"
+#include "core/asset_pack.h"
+#include "core/png.h"
+#include "core/startup_timeline.h"
+#include "core/trace.h"
 #include "objects/mesh.h"
 
+#ifdef USE_EGL_HEADLESS
+#include "egl_headless.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <map>
 #include <stdexcept>
 
@@ -121,8 +132,21 @@ void APIENTRY gl_debug_output(GLenum        source,
 }
 #endif
 
+static GLenum gl_index_type(const index_buffer* indexes)
+{
+    return indexes->is_32bit() ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+}
+
+// start_vertex_index is a byte offset into the index buffer object
+static const void* index_offset(const index_buffer* indexes,
+                                const uint16_t*     start_vertex_index)
+{
+    const uintptr_t start = reinterpret_cast<uintptr_t>(start_vertex_index);
+    return reinterpret_cast<const void*>(indexes->get_offset() + start);
+}
+
 template <class vertex_type>
-void bind_vertexes()
+void bind_vertexes(size_t base)
 {
     glEnableVertexAttribArray(0);
     GL_CHECK_ERRORS();
@@ -132,12 +156,12 @@ void bind_vertexes()
         GL_FLOAT,
         GL_FALSE,
         sizeof(vertex_type),
-        reinterpret_cast<GLvoid*>(vertex_type::OFFSET_POSITION));
+        reinterpret_cast<GLvoid*>(base + vertex_type::OFFSET_POSITION));
     GL_CHECK_ERRORS()
 }
 
 template <class vertex_type>
-void bind_normal()
+void bind_normal(size_t base)
 {
     glEnableVertexAttribArray(1);
     GL_CHECK_ERRORS();
@@ -147,12 +171,12 @@ void bind_normal()
         GL_FLOAT,
         GL_FALSE,
         sizeof(vertex_type),
-        reinterpret_cast<GLvoid*>(vertex_type::OFFSET_NORMAL));
+        reinterpret_cast<GLvoid*>(base + vertex_type::OFFSET_NORMAL));
     GL_CHECK_ERRORS();
 }
 
 template <class vertex_type>
-void bind_texture_coords()
+void bind_texture_coords(size_t base)
 {
     glEnableVertexAttribArray(2);
     GL_CHECK_ERRORS();
@@ -162,24 +186,86 @@ void bind_texture_coords()
         GL_FLOAT,
         GL_FALSE,
         sizeof(vertex_type),
-        reinterpret_cast<GLvoid*>(vertex_type::OFFSET_TEXTURE));
+        reinterpret_cast<GLvoid*>(base + vertex_type::OFFSET_TEXTURE));
     GL_CHECK_ERRORS();
 }
 
 template <class vertex_type>
-void bind_colors()
+void bind_colors(size_t base)
 {
     glEnableVertexAttribArray(3);
     GL_CHECK_ERRORS();
-    glVertexAttribPointer(3,
-                          4,
-                          GL_UNSIGNED_BYTE,
-                          GL_TRUE,
-                          sizeof(vertex_type),
-                          reinterpret_cast<GLvoid*>(vertex_type::OFFSET_COLOR));
+    glVertexAttribPointer(
+        3,
+        4,
+        GL_UNSIGNED_BYTE,
+        GL_TRUE,
+        sizeof(vertex_type),
+        reinterpret_cast<GLvoid*>(base + vertex_type::OFFSET_COLOR));
+    GL_CHECK_ERRORS();
+}
+
+// vertex3d_packed attributes are normalized integers, GL converts them back
+// to floats before the shader runs
+template <>
+void bind_vertexes<vertex3d_packed>(size_t base)
+{
+    glEnableVertexAttribArray(0);
+    GL_CHECK_ERRORS();
+    glVertexAttribPointer(
+        0,
+        3,
+        GL_SHORT,
+        GL_TRUE,
+        sizeof(vertex3d_packed),
+        reinterpret_cast<GLvoid*>(base + vertex3d_packed::OFFSET_POSITION));
+    GL_CHECK_ERRORS()
+}
+
+template <>
+void bind_normal<vertex3d_packed>(size_t base)
+{
+    glEnableVertexAttribArray(1);
+    GL_CHECK_ERRORS();
+    glVertexAttribPointer(
+        1,
+        4,
+        GL_INT_2_10_10_10_REV,
+        GL_TRUE,
+        sizeof(vertex3d_packed),
+        reinterpret_cast<GLvoid*>(base + vertex3d_packed::OFFSET_NORMAL));
     GL_CHECK_ERRORS();
 }
 
+template <>
+void bind_texture_coords<vertex3d_packed>(size_t base)
+{
+    glEnableVertexAttribArray(2);
+    GL_CHECK_ERRORS();
+    glVertexAttribPointer(
+        2,
+        2,
+        GL_UNSIGNED_SHORT,
+        GL_TRUE,
+        sizeof(vertex3d_packed),
+        reinterpret_cast<GLvoid*>(base + vertex3d_packed::OFFSET_TEXTURE));
+    GL_CHECK_ERRORS();
+}
+
+#ifdef USE_EGL_HEADLESS
+// Headless rendering doesn't need SDL video at all
+static constexpr Uint32 headless_sdl_flags = SDL_INIT_EVENTS | SDL_INIT_TIMER;
+#else
+// Falls back to a hidden window whose default framebuffer is never shown
+static constexpr Uint32 headless_sdl_flags =
+    SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_TIMER;
+#endif
+
+// What the first frame needs. Audio starts with the first sound, nothing
+// reads joysticks, gamepads, haptics or sensors.
+static constexpr Uint32 window_sdl_flags =
+    SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_TIMER;
+
 void* load_gl_func(const char* name)
 {
     SDL_FunctionPointer gl_pointer = SDL_GL_GetProcAddress(name);
@@ -194,9 +280,13 @@ static float          g_Time            = 0.0;
 static bool           g_MousePressed[3] = { false, false, false };
 static float          g_MouseWheel      = 0.0f;
 static shader_opengl* g_imgui_shader    = nullptr;
+// Read while the window and context are being created
+static std::future<shader_opengl::source> g_imgui_shader_source;
 
 void ImGui_ImplSdlGL3_RenderDrawLists(engine* eng, ImDrawData* draw_data)
 {
+    TRACE_ZONE("ImGui_ImplSdlGL3_RenderDrawLists");
+
     ImGuiIO& io        = ImGui::GetIO();
     int      fb_width  = int(io.DisplaySize.x * io.DisplayFramebufferScale.x);
     int      fb_height = int(io.DisplaySize.y * io.DisplayFramebufferScale.y);
@@ -236,12 +326,14 @@ void ImGui_ImplSdlGL3_RenderDrawLists(engine* eng, ImDrawData* draw_data)
             cmd_list->VtxBuffer.Data);
         auto vert_count = static_cast<size_t>(cmd_list->VtxBuffer.size());
 
-        auto vertex_buff = new vertex_buffer(vertex_data, vert_count);
+        auto vertex_buff =
+            new vertex_buffer(vertex_data, vert_count, buffer_usage::stream);
 
         const std::uint16_t* indexes = cmd_list->IdxBuffer.Data;
         auto index_count = static_cast<size_t>(cmd_list->IdxBuffer.size());
 
-        auto index_buff = new index_buffer(indexes, index_count);
+        auto index_buff =
+            new index_buffer(indexes, index_count, buffer_usage::stream);
 
         for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
         {
@@ -272,145 +364,156 @@ static void ImGui_ImplSdlGL3_SetClipboardText(void*, const char* text)
     SDL_SetClipboardText(text);
 }
 
+#ifdef NDEBUG
+// The glad debug loader calls glGetError after every GL call by default
+static void gl_skip_error_check(const char*, void*, int, ...) {}
+#endif
+
 int engine_opengl::initialize(config& cfg)
 {
-    if (SDL_Init(SDL_INIT_EVERYTHING) > 0)
-    {
-        throw std::runtime_error(std::string("Error in Init SDL3: ") +
-                                 SDL_GetError());
-    }
+    is_headless = cfg.is_headless;
 
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+#ifdef NDEBUG
+    glad_set_post_callback(gl_skip_error_check);
+#endif
 
-    std::cout << "Window size: (" << cfg.width << " " << cfg.height << ")"
-              << std::endl;
+    g_imgui_shader_source = std::async(std::launch::async,
+                                       shader_opengl::read_source,
+                                       cfg.shader_vertex_imgui,
+                                       cfg.shader_fragment_imgui);
 
-#ifdef __ANDROID__
-    cfg.is_full_screen = true;
-#endif
+    startup_timeline* timeline = startup_timeline::get_current();
+    {
+        startup_timeline::scope s(timeline, "sdl init");
+        if (SDL_Init(is_headless ? headless_sdl_flags : window_sdl_flags) > 0)
+        {
+            throw std::runtime_error(std::string("Error in Init SDL3: ") +
+                                     SDL_GetError());
+        }
+    }
 
-    if (cfg.is_full_screen)
+    if (is_headless)
     {
-        const SDL_DisplayMode* display_mode = SDL_GetCurrentDisplayMode(1);
-        if (!display_mode)
+        startup_timeline::scope s(timeline, "headless context");
+        if (!create_headless_context(cfg))
         {
-            std::cout << "can't get current display mode: " << SDL_GetError()
-                      << std::endl;
+            SDL_Quit();
+            return 0;
         }
-        cfg.width  = display_mode->w;
-        cfg.height = display_mode->h;
-
-        window = static_cast<SDL_Window*>(
-            SDL_CreateWindow(cfg.app_name,
-                             static_cast<int>(cfg.width),
-                             static_cast<int>(cfg.height),
-                             SDL_WINDOW_FULLSCREEN | SDL_WINDOW_OPENGL));
+        _config = cfg;
     }
     else
     {
+        startup_timeline::scope s(timeline, "window and context");
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+
+        std::cout << "Window size: (" << cfg.width << " " << cfg.height << ")"
+                  << std::endl;
+
 #ifdef __ANDROID__
-        const SDL_DisplayMode* display_mode = SDL_GetCurrentDisplayMode(1);
-        if (!display_mode)
+        cfg.is_full_screen = true;
+#endif
+
+        if (cfg.is_full_screen)
         {
-            std::cout << "can't get current display mode: " << SDL_GetError()
-                      << std::endl;
+            const SDL_DisplayMode* display_mode =
+                SDL_GetCurrentDisplayMode(1);
+            if (!display_mode)
+            {
+                std::cout << "can't get current display mode: "
+                          << SDL_GetError() << std::endl;
+            }
+            cfg.width  = display_mode->w;
+            cfg.height = display_mode->h;
+
+            window = static_cast<SDL_Window*>(
+                SDL_CreateWindow(cfg.app_name,
+                                 static_cast<int>(cfg.width),
+                                 static_cast<int>(cfg.height),
+                                 SDL_WINDOW_FULLSCREEN | SDL_WINDOW_OPENGL));
         }
-        cfg.width  = display_mode->w;
-        cfg.height = display_mode->h;
+        else
+        {
+#ifdef __ANDROID__
+            const SDL_DisplayMode* display_mode =
+                SDL_GetCurrentDisplayMode(1);
+            if (!display_mode)
+            {
+                std::cout << "can't get current display mode: "
+                          << SDL_GetError() << std::endl;
+            }
+            cfg.width  = display_mode->w;
+            cfg.height = display_mode->h;
 #endif
-        window = static_cast<SDL_Window*>(
-            SDL_CreateWindow(cfg.app_name,
-                             static_cast<int>(cfg.width),
-                             static_cast<int>(cfg.height),
-                             SDL_WINDOW_OPENGL));
-    }
-    std::cout << "Window size: (" << cfg.width << " " << cfg.height << ")"
-              << std::endl;
-    int w, h;
-    SDL_GetWindowSizeInPixels(static_cast<SDL_Window*>(window), &w, &h);
-    cfg.width  = w;
-    cfg.height = h;
-    std::cout << "Window size: (" << cfg.width << " " << cfg.height << ")"
-              << std::endl;
-
-    _config = cfg;
-
-    if (window == nullptr)
-    {
-        std::cerr << SDL_GetError();
-        SDL_Quit();
-        return 0;
-    }
+            window = static_cast<SDL_Window*>(
+                SDL_CreateWindow(cfg.app_name,
+                                 static_cast<int>(cfg.width),
+                                 static_cast<int>(cfg.height),
+                                 SDL_WINDOW_OPENGL));
+        }
+        std::cout << "Window size: (" << cfg.width << " " << cfg.height << ")"
+                  << std::endl;
+        int w, h;
+        SDL_GetWindowSizeInPixels(static_cast<SDL_Window*>(window), &w, &h);
+        cfg.width  = w;
+        cfg.height = h;
+        std::cout << "Window size: (" << cfg.width << " " << cfg.height << ")"
+                  << std::endl;
+
+        _config = cfg;
+
+        if (window == nullptr)
+        {
+            std::cerr << SDL_GetError();
+            SDL_Quit();
+            return 0;
+        }
 
-    audio_device_spec.freq     = 48000;
-    audio_device_spec.format   = SDL_AUDIO_S16LSB;
-    audio_device_spec.channels = 2;
-    audio_device_spec.samples  = 1024; // must be power of 2
-    audio_device_spec.callback = engine_opengl::audio_callback;
-    audio_device_spec.userdata = this;
+#ifndef _WIN32
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK,
+                            SDL_GL_CONTEXT_PROFILE_ES);
+#endif
+        gl_context = SDL_GL_CreateContext(static_cast<SDL_Window*>(window));
 
-    const int num_audio_drivers = SDL_GetNumAudioDrivers();
+        if (gl_context == nullptr)
+        {
+            std::cerr << SDL_GetError();
+            SDL_Quit();
+            return 0;
+        }
 
-    const char* default_audio_device_name = nullptr;
+        int swap_applyed = SDL_GL_SetSwapInterval(0);
+        assert(swap_applyed == 0);
 
-    const int num_audio_devices = SDL_GetNumAudioDevices(SDL_FALSE);
-    if (num_audio_devices > 0)
-    {
-        default_audio_device_name =
-            SDL_GetAudioDeviceName(num_audio_devices - 1, SDL_FALSE);
-        for (int i = 0; i < num_audio_devices; ++i)
+        if (gladLoadGLES2Loader(load_gl_func) == 0)
         {
-            std::cout << "audio device #" << i << ": "
-                      << SDL_GetAudioDeviceName(i, SDL_FALSE) << '\n';
+            std::cerr << "cant init glad" << std::endl;
+            SDL_Quit();
+            return 0;
         }
     }
-    std::cout << std::flush;
 
-    audio_device = SDL_OpenAudioDevice(
-        default_audio_device_name, 0, &audio_device_spec, nullptr, 0);
+    startup_timeline::scope gl_setup(timeline, "gl setup");
 
-    if (audio_device == 0)
-    {
-        std::cerr << "failed open audio device: " << SDL_GetError();
-        throw std::runtime_error("audio failed");
-    }
-    else
-    {
-        std::cout << "--------------------------------------------\n";
-        std::cout << "audio device selected: " << default_audio_device_name
-                  << '\n'
-                  << "freq: " << audio_device_spec.freq << '\n'
-                  << "format: "
-                  << get_sound_format_name(audio_device_spec.format) << '\n'
-                  << "channels: "
-                  << static_cast<uint32_t>(audio_device_spec.channels) << '\n'
-                  << "samples: " << audio_device_spec.samples << '\n'
-                  << std::flush;
-
-        SDL_PlayAudioDevice(audio_device);
-    }
-#ifndef _WIN32
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+#ifdef USE_EGL_HEADLESS
+    gpu_timer.initialize(is_headless ? egl_headless_get_proc_address
+                                     : load_gl_func);
+#else
+    gpu_timer.initialize(load_gl_func);
 #endif
-    gl_context = SDL_GL_CreateContext(static_cast<SDL_Window*>(window));
 
-    if (gl_context == nullptr)
-    {
-        std::cerr << SDL_GetError();
-        SDL_Quit();
-        return 0;
-    }
+    has_etc2 = texture_opengl::is_etc2_supported();
 
-    int swap_applyed = SDL_GL_SetSwapInterval(0);
-    assert(swap_applyed == 0);
+    if (program_cache.initialize(cfg.shader_cache_path))
+        shader_opengl::set_program_cache(&program_cache);
 
-    if (gladLoadGLES2Loader(load_gl_func) == 0)
+    if (stream_buffer.initialize(cfg.stream_buffer_kib * 1024,
+                                 cfg.stream_buffer_kib * 256,
+                                 cfg.frames_in_flight))
     {
-        std::cerr << "cant init glad" << std::endl;
-        SDL_Quit();
-        return 0;
+        stream_buffer_opengl::set_current(&stream_buffer);
     }
 
 #ifdef USE_GL_DEBUG
@@ -444,6 +547,21 @@ int engine_opengl::initialize(config& cfg)
     glViewport(0, 0, cfg.width, cfg.height);
     GL_CHECK_ERRORS()
 
+    output_framebuffer = offscreen_framebuffer;
+    if (cfg.dynamic_resolution && !is_headless)
+    {
+        resolution_controller::settings settings;
+        settings.target_ms    = cfg.target_frame_ms;
+        settings.min_scale    = cfg.min_resolution_scale;
+        settings.max_scale    = cfg.max_resolution_scale;
+        resolution            = resolution_controller(settings);
+        is_dynamic_resolution = create_scene_target(cfg);
+    }
+    last_swap = std::chrono::steady_clock::now();
+
+    create_audio_mixer();
+
+    startup_timeline::scope imgui_setup(timeline, "imgui init");
     if (!ImGui_ImplSdlGL3_Init(static_cast<SDL_Window*>(window), _config))
     {
         throw std::runtime_error("error: failed to init ImGui");
@@ -454,10 +572,325 @@ int engine_opengl::initialize(config& cfg)
     return 1;
 }
 
+bool engine_opengl::create_scene_target(const config& cfg)
+{
+    // Blits and sized RGBA8/DEPTH24 renderbuffers are ES 3.0, ES 2.0 draws
+    // straight into the output framebuffer at native resolution
+    if (!GLAD_GL_ES_VERSION_3_0)
+    {
+        std::cout << "scene framebuffer: needs ES 3.0, dynamic resolution is "
+                     "off"
+                  << std::endl;
+        return false;
+    }
+
+    // Sized for the largest scale, smaller ones use a part of it
+    const float scale  = resolution.get_scale();
+    const auto  width  = static_cast<GLsizei>(std::ceil(cfg.width * scale));
+    const auto  height = static_cast<GLsizei>(std::ceil(cfg.height * scale));
+
+    glGenRenderbuffers(1, &scene_color);
+    glBindRenderbuffer(GL_RENDERBUFFER, scene_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    GL_CHECK_ERRORS()
+
+    glGenRenderbuffers(1, &scene_depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, scene_depth);
+    glRenderbufferStorage(
+        GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    GL_CHECK_ERRORS()
+
+    glGenFramebuffers(1, &scene_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, scene_framebuffer);
+    glFramebufferRenderbuffer(
+        GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, scene_color);
+    glFramebufferRenderbuffer(
+        GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, scene_depth);
+    GL_CHECK_ERRORS()
+
+    const bool is_complete =
+        glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, output_framebuffer);
+    if (!is_complete)
+    {
+        std::cerr << "scene framebuffer is incomplete, dynamic resolution is "
+                     "off"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void engine_opengl::get_scene_size(GLsizei& width, GLsizei& height) const
+{
+    const float scale = resolution.get_scale();
+    width  = std::max(1, static_cast<GLsizei>(_config.width * scale));
+    height = std::max(1, static_cast<GLsizei>(_config.height * scale));
+}
+
+void engine_opengl::begin_scene()
+{
+    if (!is_dynamic_resolution)
+        return;
+
+    GLsizei width  = 0;
+    GLsizei height = 0;
+    get_scene_size(width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, scene_framebuffer);
+    GL_CHECK_ERRORS()
+    glViewport(0, 0, width, height);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    GL_CHECK_ERRORS()
+}
+
+void engine_opengl::end_scene()
+{
+    if (!is_dynamic_resolution)
+        return;
+
+    GLsizei width  = 0;
+    GLsizei height = 0;
+    get_scene_size(width, height);
+
+    const auto native_width  = static_cast<GLsizei>(_config.width);
+    const auto native_height = static_cast<GLsizei>(_config.height);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, scene_framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, output_framebuffer);
+    glBlitFramebuffer(0,
+                      0,
+                      width,
+                      height,
+                      0,
+                      0,
+                      native_width,
+                      native_height,
+                      GL_COLOR_BUFFER_BIT,
+                      GL_LINEAR);
+    GL_CHECK_ERRORS()
+
+    glBindFramebuffer(GL_FRAMEBUFFER, output_framebuffer);
+    glViewport(0, 0, native_width, native_height);
+    GL_CHECK_ERRORS()
+}
+
+float engine_opengl::get_resolution_scale() const
+{
+    return is_dynamic_resolution ? resolution.get_scale() : 1.f;
+}
+
+bool engine_opengl::create_headless_context(config& cfg)
+{
+    cfg.is_full_screen = false;
+
+#ifdef USE_EGL_HEADLESS
+    if (!egl_headless_create_context())
+        return false;
+
+    if (gladLoadGLES2Loader(egl_headless_get_proc_address) == 0)
+    {
+        std::cerr << "cant init glad" << std::endl;
+        return false;
+    }
+#else
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+
+    window = SDL_CreateWindow(cfg.app_name,
+                              static_cast<int>(cfg.width),
+                              static_cast<int>(cfg.height),
+                              SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (window == nullptr)
+    {
+        std::cerr << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    gl_context = SDL_GL_CreateContext(window);
+    if (gl_context == nullptr)
+    {
+        std::cerr << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    if (gladLoadGLES2Loader(load_gl_func) == 0)
+    {
+        std::cerr << "cant init glad" << std::endl;
+        return false;
+    }
+#endif
+
+    const auto width  = static_cast<GLsizei>(cfg.width);
+    const auto height = static_cast<GLsizei>(cfg.height);
+
+    glGenRenderbuffers(1, &offscreen_color);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreen_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    GL_CHECK_ERRORS()
+
+    glGenRenderbuffers(1, &offscreen_depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreen_depth);
+    glRenderbufferStorage(
+        GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    GL_CHECK_ERRORS()
+
+    glGenFramebuffers(1, &offscreen_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, offscreen_framebuffer);
+    glFramebufferRenderbuffer(
+        GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen_color);
+    glFramebufferRenderbuffer(
+        GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, offscreen_depth);
+    GL_CHECK_ERRORS()
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "offscreen framebuffer is incomplete" << std::endl;
+        return false;
+    }
+
+    std::cout << "headless: " << glGetString(GL_RENDERER) << ", "
+              << cfg.width << "x" << cfg.height << std::endl;
+
+    return true;
+}
+
+void engine_opengl::create_audio_mixer()
+{
+    // Asked for without allowed changes, SDL converts to it if the device
+    // differs, so sounds can be decoded before the device is open
+    audio_device_spec.freq     = 48000;
+    audio_device_spec.format   = SDL_AUDIO_S16LSB;
+    audio_device_spec.channels = 2;
+    audio_device_spec.samples  = static_cast<Uint16>(
+        std::clamp<uint32_t>(_config.audio_buffer_frames, 64, 8192));
+    audio_device_spec.callback = engine_opengl::audio_callback;
+    audio_device_spec.userdata = this;
+
+    mixer = std::make_unique<audio_mixer>(audio_device_spec);
+}
+
+void engine_opengl::open_audio_device()
+{
+    if (is_audio_open)
+        return;
+    open_audio_backend();
+    is_audio_open = true;
+}
+
+void engine_opengl::open_audio_backend()
+{
+    const auto print_spec = [this](const char* name)
+    {
+        std::cout << "audio device selected: " << name << ", "
+                  << audio_device_spec.freq << " Hz, "
+                  << get_sound_format_name(audio_device_spec.format) << ", "
+                  << static_cast<uint32_t>(audio_device_spec.channels)
+                  << " channels, " << audio_device_spec.samples << " samples"
+                  << std::endl;
+    };
+
+    // Offline and null need no audio subsystem, only the converters of SDL
+    const auto open_offline = [this](const char* path)
+    {
+        try
+        {
+            audio_output =
+                std::make_unique<audio_offline>(path, audio_device_spec);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "failed open offline audio: " << e.what()
+                      << ", using null audio" << std::endl;
+            return false;
+        }
+        return true;
+    };
+
+    if (_config.audio == audio_backend::offline &&
+        open_offline(_config.audio_offline_path))
+    {
+        audio_backend_name = "offline";
+        print_spec(_config.audio_offline_path);
+        return;
+    }
+    if (_config.audio == audio_backend::device && !is_headless &&
+        open_audio_stream())
+    {
+        audio_backend_name = "device";
+        print_spec("default");
+        SDL_PlayAudioDevice(audio_device);
+        return;
+    }
+
+    // Mixed like any other backend so stats and the command ring behave the
+    // same, the result is dropped
+    if (open_offline(nullptr))
+        print_spec(is_headless ? "null (headless)" : "null");
+}
+
+bool engine_opengl::open_audio_stream()
+{
+    startup_timeline::scope s(startup_timeline::get_current(), "audio init");
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0)
+    {
+        std::cerr << "failed init audio: " << SDL_GetError()
+                  << ", using null audio" << std::endl;
+        return false;
+    }
+
+    // The system default, the device list is not walked
+    audio_device =
+        SDL_OpenAudioDevice(nullptr, 0, &audio_device_spec, nullptr, 0);
+
+    if (audio_device == 0)
+    {
+        std::cerr << "failed open audio device: " << SDL_GetError()
+                  << ", using null audio" << std::endl;
+        return false;
+    }
+    return true;
+}
+
 void engine_opengl::uninitialize()
 {
-    SDL_GL_DeleteContext(gl_context);
-    SDL_DestroyWindow(static_cast<SDL_Window*>(window));
+    gpu_timer.uninitialize();
+    stream_buffer.uninitialize();
+    shader_opengl::set_program_cache(nullptr);
+
+    if (audio_device != 0)
+        SDL_CloseAudioDevice(audio_device);
+    audio_output.reset();
+    // The callback has stopped, nothing reads the sounds anymore
+    for (auto& [path, sound] : sounds)
+        delete sound;
+    sounds.clear();
+    for (auto& [path, music] : streams)
+        delete music;
+    streams.clear();
+
+    if (scene_framebuffer != 0)
+    {
+        glDeleteFramebuffers(1, &scene_framebuffer);
+        glDeleteRenderbuffers(1, &scene_color);
+        glDeleteRenderbuffers(1, &scene_depth);
+    }
+    if (offscreen_framebuffer != 0)
+    {
+        glDeleteFramebuffers(1, &offscreen_framebuffer);
+        glDeleteRenderbuffers(1, &offscreen_color);
+        glDeleteRenderbuffers(1, &offscreen_depth);
+    }
+
+#ifdef USE_EGL_HEADLESS
+    if (is_headless)
+        egl_headless_destroy_context();
+#endif
+    if (gl_context != nullptr)
+        SDL_GL_DeleteContext(gl_context);
+    if (window != nullptr)
+        SDL_DestroyWindow(static_cast<SDL_Window*>(window));
     SDL_Quit();
 }
 
@@ -488,6 +921,8 @@ bool engine_opengl::event_keyboard(event& e)
             if (sdl_event.key.keysym.sym == SDLK_RIGHT) e.keyboard.right_clicked = 1;
             if (sdl_event.key.keysym.sym == SDLK_UP) e.keyboard.up_clicked       = 1;
             if (sdl_event.key.keysym.sym == SDLK_DOWN) e.keyboard.down_clicked   = 1;
+            if (sdl_event.key.keysym.sym == SDLK_F1) e.keyboard.f1_clicked       = 1;
+            if (sdl_event.key.keysym.sym == SDLK_F2) e.keyboard.f2_clicked       = 1;
                 // clang-format on
                 is_event = true;
                 break;
@@ -504,6 +939,8 @@ bool engine_opengl::event_keyboard(event& e)
             if (sdl_event.key.keysym.sym == SDLK_RIGHT) e.keyboard.right_released = 1;
             if (sdl_event.key.keysym.sym == SDLK_UP) e.keyboard.up_released       = 1;
             if (sdl_event.key.keysym.sym == SDLK_DOWN) e.keyboard.down_released   = 1;
+            if (sdl_event.key.keysym.sym == SDLK_F1) e.keyboard.f1_released       = 1;
+            if (sdl_event.key.keysym.sym == SDLK_F2) e.keyboard.f2_released       = 1;
                 // clang-format on
                 is_event = true;
                 break;
@@ -541,8 +978,8 @@ void engine_opengl::render_triangle(const triangle<vertex3d>& tr)
     glBufferData(GL_ARRAY_BUFFER, sizeof(tr), &tr, GL_STATIC_DRAW);
     GL_CHECK_ERRORS()
 
-    bind_vertexes<vertex3d>();
-    bind_normal<vertex3d>();
+    bind_vertexes<vertex3d>(0);
+    bind_normal<vertex3d>(0);
 
     glDrawArrays(GL_TRIANGLES, 0, 3);
     GL_CHECK_ERRORS()
@@ -555,9 +992,9 @@ void engine_opengl::render_triangle(const triangle<vertex3d_colored>& tr)
     glBufferData(GL_ARRAY_BUFFER, sizeof(tr), &tr, GL_STATIC_DRAW);
     GL_CHECK_ERRORS()
 
-    bind_vertexes<vertex3d_colored>();
-    bind_normal<vertex3d_colored>();
-    bind_colors<vertex3d_colored>();
+    bind_vertexes<vertex3d_colored>(0);
+    bind_normal<vertex3d_colored>(0);
+    bind_colors<vertex3d_colored>(0);
 
     glDrawArrays(GL_TRIANGLES, 0, 3);
     GL_CHECK_ERRORS()
@@ -570,9 +1007,9 @@ void engine_opengl::render_triangle(const triangle<vertex3d_textured>& tr)
     glBufferData(GL_ARRAY_BUFFER, sizeof(tr), &tr, GL_STATIC_DRAW);
     GL_CHECK_ERRORS()
 
-    bind_vertexes<vertex3d_textured>();
-    bind_normal<vertex3d_textured>();
-    bind_texture_coords<vertex3d_textured>();
+    bind_vertexes<vertex3d_textured>(0);
+    bind_normal<vertex3d_textured>(0);
+    bind_texture_coords<vertex3d_textured>(0);
 
     glDrawArrays(GL_TRIANGLES, 0, 3);
     GL_CHECK_ERRORS()
@@ -586,10 +1023,10 @@ void engine_opengl::render_triangle(
     glBufferData(GL_ARRAY_BUFFER, sizeof(tr), &tr, GL_STATIC_DRAW);
     GL_CHECK_ERRORS()
 
-    bind_vertexes<vertex3d_colored_textured>();
-    bind_normal<vertex3d_colored_textured>();
-    bind_texture_coords<vertex3d_colored_textured>();
-    bind_colors<vertex3d_colored_textured>();
+    bind_vertexes<vertex3d_colored_textured>(0);
+    bind_normal<vertex3d_colored_textured>(0);
+    bind_texture_coords<vertex3d_colored_textured>(0);
+    bind_colors<vertex3d_colored_textured>(0);
 
     glDrawArrays(GL_TRIANGLES, 0, 3);
     GL_CHECK_ERRORS()
@@ -605,13 +1042,13 @@ void engine_opengl::render_triangles(vertex_buffer<vertex3d>* vertexes,
     vertexes->bind();
     indexes->bind();
 
-    bind_vertexes<vertex3d>();
-    bind_normal<vertex3d>();
+    bind_vertexes<vertex3d>(vertexes->get_offset());
+    bind_normal<vertex3d>(vertexes->get_offset());
 
     glDrawElements(GL_TRIANGLES,
                    static_cast<int>(num_vertexes),
-                   GL_UNSIGNED_SHORT,
-                   start_vertex_index);
+                   gl_index_type(indexes),
+                   index_offset(indexes, start_vertex_index));
     GL_CHECK_ERRORS()
 }
 void engine_opengl::render_triangles(vertex_buffer<vertex3d_colored>* vertexes,
@@ -624,14 +1061,14 @@ void engine_opengl::render_triangles(vertex_buffer<vertex3d_colored>* vertexes,
     vertexes->bind();
     indexes->bind();
 
-    bind_vertexes<vertex3d_colored>();
-    bind_normal<vertex3d_colored>();
-    bind_colors<vertex3d_colored>();
+    bind_vertexes<vertex3d_colored>(vertexes->get_offset());
+    bind_normal<vertex3d_colored>(vertexes->get_offset());
+    bind_colors<vertex3d_colored>(vertexes->get_offset());
 
     glDrawElements(GL_TRIANGLES,
                    static_cast<int>(num_vertexes),
-                   GL_UNSIGNED_SHORT,
-                   start_vertex_index);
+                   gl_index_type(indexes),
+                   index_offset(indexes, start_vertex_index));
     GL_CHECK_ERRORS()
 }
 void engine_opengl::render_triangles(vertex_buffer<vertex3d_textured>* vertexes,
@@ -646,14 +1083,14 @@ void engine_opengl::render_triangles(vertex_buffer<vertex3d_textured>* vertexes,
     indexes->bind();
     tex->bind();
 
-    bind_vertexes<vertex3d_textured>();
-    bind_normal<vertex3d_textured>();
-    bind_texture_coords<vertex3d_textured>();
+    bind_vertexes<vertex3d_textured>(vertexes->get_offset());
+    bind_normal<vertex3d_textured>(vertexes->get_offset());
+    bind_texture_coords<vertex3d_textured>(vertexes->get_offset());
 
     glDrawElements(GL_TRIANGLES,
                    static_cast<int>(num_vertexes),
-                   GL_UNSIGNED_SHORT,
-                   start_vertex_index);
+                   gl_index_type(indexes),
+                   index_offset(indexes, start_vertex_index));
     GL_CHECK_ERRORS()
 }
 
@@ -668,15 +1105,38 @@ void engine_opengl::render_triangles(
     indexes->bind();
     tex->bind();
 
-    bind_vertexes<vertex3d_colored_textured>();
-    bind_normal<vertex3d_colored_textured>();
-    bind_texture_coords<vertex3d_colored_textured>();
-    bind_colors<vertex3d_colored_textured>();
+    bind_vertexes<vertex3d_colored_textured>(vertexes->get_offset());
+    bind_normal<vertex3d_colored_textured>(vertexes->get_offset());
+    bind_texture_coords<vertex3d_colored_textured>(vertexes->get_offset());
+    bind_colors<vertex3d_colored_textured>(vertexes->get_offset());
 
     glDrawElements(GL_TRIANGLES,
                    static_cast<int>(num_vertexes),
-                   GL_UNSIGNED_SHORT,
-                   start_vertex_index);
+                   gl_index_type(indexes),
+                   index_offset(indexes, start_vertex_index));
+    GL_CHECK_ERRORS()
+}
+
+void engine_opengl::render_triangles(vertex_buffer<vertex3d_packed>* vertexes,
+                                     index_buffer*                   indexes,
+                                     const texture*                  tex,
+                                     const uint16_t* start_vertex_index,
+                                     size_t          num_vertexes)
+{
+    reload_uniform();
+
+    vertexes->bind();
+    indexes->bind();
+    tex->bind();
+
+    bind_vertexes<vertex3d_packed>(vertexes->get_offset());
+    bind_normal<vertex3d_packed>(vertexes->get_offset());
+    bind_texture_coords<vertex3d_packed>(vertexes->get_offset());
+
+    glDrawElements(GL_TRIANGLES,
+                   static_cast<int>(num_vertexes),
+                   gl_index_type(indexes),
+                   index_offset(indexes, start_vertex_index));
     GL_CHECK_ERRORS()
 }
 
@@ -691,23 +1151,46 @@ void engine_opengl::render_triangles(
     indexes->bind();
     tex->bind();
 
-    bind_vertexes<vertex2d_colored_textured>();
-    bind_texture_coords<vertex2d_colored_textured>();
-    bind_colors<vertex2d_colored_textured>();
+    bind_vertexes<vertex2d_colored_textured>(vertexes->get_offset());
+    bind_texture_coords<vertex2d_colored_textured>(vertexes->get_offset());
+    bind_colors<vertex2d_colored_textured>(vertexes->get_offset());
 
     glDrawElements(GL_TRIANGLES,
                    static_cast<int>(num_vertexes),
-                   GL_UNSIGNED_SHORT,
-                   start_vertex_index);
+                   gl_index_type(indexes),
+                   index_offset(indexes, start_vertex_index));
     GL_CHECK_ERRORS()
 }
 
 void engine_opengl::swap_buffers()
 {
+    TRACE_ZONE("swap_buffers");
 
+    begin_gpu_pass(gpu_pass::ui);
     ImGui_ImplSdlGL3_RenderDrawLists(this, ImGui::GetDrawData());
+    end_gpu_pass(gpu_pass::ui);
+
+    if (!capture_path.empty())
+    {
+        save_framebuffer(capture_path.c_str());
+        capture_path.clear();
+    }
+
+    stream_buffer.next_frame();
+
+    if (!is_headless)
+        SDL_GL_SwapWindow(static_cast<SDL_Window*>(window));
 
-    SDL_GL_SwapWindow(static_cast<SDL_Window*>(window));
+    if (is_gpu_timing)
+        gpu_timer.next_frame();
+
+    const auto now = std::chrono::steady_clock::now();
+    if (is_dynamic_resolution)
+    {
+        using ms = std::chrono::duration<float, std::milli>;
+        resolution.update(ms(now - last_swap).count());
+    }
+    last_swap = now;
 
     ImGui_ImplSdlGL3_NewFrame(static_cast<SDL_Window*>(window));
 
@@ -718,23 +1201,131 @@ void engine_opengl::swap_buffers()
     GL_CHECK_ERRORS()
 }
 
-texture* engine_opengl::load_texture(uint32_t index, const char* path)
+void engine_opengl::set_gpu_timing(bool state)
+{
+    is_gpu_timing = state && gpu_timer.is_supported();
+}
+
+void engine_opengl::begin_gpu_pass(gpu_pass pass)
+{
+    if (is_gpu_timing)
+        gpu_timer.begin(pass);
+}
+
+void engine_opengl::end_gpu_pass(gpu_pass pass)
+{
+    if (is_gpu_timing)
+        gpu_timer.end(pass);
+}
+
+bool engine_opengl::get_gpu_pass_ms(gpu_pass pass, float& ms) const
+{
+    return is_gpu_timing && gpu_timer.get_ms(pass, ms);
+}
+
+size_t engine_opengl::get_texture_bytes() const
+{
+    return texture_opengl::get_total_bytes();
+}
+
+bool engine_opengl::has_32bit_indexes() const
+{
+    // Core in ES 3.0, GL_OES_element_index_uint is not loaded by glad
+    return GLAD_GL_ES_VERSION_3_0;
+}
+
+float engine_opengl::get_fence_wait_ms() const
+{
+    return stream_buffer.get_wait_ms();
+}
+
+void engine_opengl::capture_frame(const char* path)
+{
+    capture_path = path;
+}
+
+void engine_opengl::save_framebuffer(const char* path)
+{
+    const auto width  = static_cast<uint32_t>(_config.width);
+    const auto height = static_cast<uint32_t>(_config.height);
+
+    std::vector<uint32_t> pixels(static_cast<size_t>(width) * height);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0,
+                 0,
+                 static_cast<GLsizei>(width),
+                 static_cast<GLsizei>(height),
+                 GL_RGBA,
+                 GL_UNSIGNED_BYTE,
+                 pixels.data());
+    GL_CHECK_ERRORS()
+
+    // GL rows go from bottom to top
+    for (uint32_t y = 0; y < height / 2; y++)
+        std::swap_ranges(pixels.begin() + y * width,
+                         pixels.begin() + (y + 1) * width,
+                         pixels.begin() + (height - 1 - y) * width);
+
+    write_png(path, pixels.data(), width, height);
+}
+
+std::shared_ptr<texture> engine_opengl::load_texture(uint32_t    index,
+                                                     const char* path)
 {
-    texture* tex = new texture_opengl(path);
+    std::shared_ptr<texture> tex = textures.get(
+        path, [path]() { return std::make_shared<texture_opengl>(path); });
     tex->bind();
 
     return tex;
 }
 
+texture_source engine_opengl::read_texture(const char* path) const
+{
+    return texture_opengl::read_source(path, has_etc2);
+}
+
+std::shared_ptr<texture> engine_opengl::load_texture(uint32_t         index,
+                                                     texture_source&& source)
+{
+    // Decoded already, a resident texture for the path still wins
+    std::shared_ptr<texture> tex =
+        textures.get(source.path.c_str(),
+                     [&source]()
+                     {
+                         return std::make_shared<texture_opengl>(
+                             std::move(source));
+                     });
+    tex->bind();
+
+    return tex;
+}
+
+resource_cache_stats engine_opengl::get_texture_cache_stats() const
+{
+    return textures.get_stats();
+}
+
+bool engine_opengl::reload_texture(texture_source&& source)
+{
+    std::shared_ptr<texture> resident = textures.find(source.path.c_str());
+    if (!resident)
+        return false;
+
+    // Uploaded aside, the old texture goes away with fresh
+    texture_opengl fresh(std::move(source));
+    static_cast<texture_opengl&>(*resident).swap(fresh);
+    return true;
+}
+
 void engine_opengl::set_texture(uint32_t index)
 {
     glActiveTexture(GL_TEXTURE0 + index);
     active_shader->set_uniform1("u_texture", index);
 }
 
-void engine_opengl::set_uniform(uniform& uni)
+void engine_opengl::set_uniform(const uniform& uni)
 {
-    this->uniforms_world = &uni;
+    this->uniforms_world = uni;
 }
 
 void engine_opengl::reload_uniform()
@@ -742,32 +1333,35 @@ void engine_opengl::reload_uniform()
     try
     {
         active_shader->set_uniform2(
-            "u_size_window", uniforms_world->width, uniforms_world->height);
+            "u_size_window", uniforms_world.width, uniforms_world.height);
 
         active_shader->set_uniform3("u_rotate_obj",
-                                    *uniforms_world->rotate_alpha_obj,
-                                    *uniforms_world->rotate_beta_obj,
-                                    *uniforms_world->rotate_gamma_obj);
+                                    uniforms_world.rotate_alpha_obj,
+                                    uniforms_world.rotate_beta_obj,
+                                    uniforms_world.rotate_gamma_obj);
 
         active_shader->set_uniform3("u_rotate_camera",
-                                    *uniforms_world->rotate_alpha_camera,
-                                    *uniforms_world->rotate_beta_camera,
-                                    *uniforms_world->rotate_gamma_camera);
+                                    uniforms_world.rotate_alpha_camera,
+                                    uniforms_world.rotate_beta_camera,
+                                    uniforms_world.rotate_gamma_camera);
 
         active_shader->set_uniform3("u_translate_obj",
-                                    *uniforms_world->translate_x_obj,
-                                    *uniforms_world->translate_y_obj,
-                                    *uniforms_world->translate_z_obj);
+                                    uniforms_world.translate_x_obj,
+                                    uniforms_world.translate_y_obj,
+                                    uniforms_world.translate_z_obj);
 
         active_shader->set_uniform3("u_translate_camera",
-                                    *uniforms_world->translate_x_camera,
-                                    *uniforms_world->translate_y_camera,
-                                    *uniforms_world->translate_z_camera);
+                                    uniforms_world.translate_x_camera,
+                                    uniforms_world.translate_y_camera,
+                                    uniforms_world.translate_z_camera);
 
         active_shader->set_uniform3("u_scale_obj",
-                                    *uniforms_world->scale_x_obj,
-                                    *uniforms_world->scale_y_obj,
-                                    *uniforms_world->scale_z_obj);
+                                    uniforms_world.scale_x_obj,
+                                    uniforms_world.scale_y_obj,
+                                    uniforms_world.scale_z_obj);
+
+        active_shader->set_uniform1("u_position_scale",
+                                    uniforms_world.position_scale);
     }
     catch (std::runtime_error e)
     {
@@ -775,86 +1369,144 @@ void engine_opengl::reload_uniform()
     }
 }
 
-std::mutex engine_opengl::audio_mutex;
+void engine_opengl::set_shader(shader* shader)
+{
+    this->active_shader = shader;
+
+    active_shader->use();
+}
+
+void engine_opengl::set_relative_mouse_mode(bool state)
+{
+    if (is_headless)
+        return;
+
+    if (state)
+        SDL_SetRelativeMouseMode(SDL_TRUE);
+    else
+        SDL_SetRelativeMouseMode(SDL_FALSE);
+}
 
 void engine_opengl::audio_callback(void*    engine_ptr,
                                    uint8_t* stream,
                                    int      stream_size)
 {
-
-    std::lock_guard<std::mutex> lock(audio_mutex);
-
-    std::fill_n(stream, stream_size, '\0');
+    TRACE_THREAD_NAME("audio");
+    TRACE_ZONE("audio_callback");
 
     auto e = static_cast<engine_opengl*>(engine_ptr);
+    e->mixer->mix(stream, static_cast<uint32_t>(stream_size));
+}
 
-    for (audio_buffer* buff : e->audio_output)
-    {
-        if (buff->is_playing)
-        {
-            uint32_t rest         = buff->length - buff->current_index;
-            uint8_t* current_buff = &buff->buffer[buff->current_index];
-
-            if (rest <= static_cast<uint32_t>(stream_size))
-            {
-                SDL_MixAudioFormat(stream,
-                                   current_buff,
-                                   e->audio_device_spec.format,
-                                   rest,
-                                   SDL_MIX_MAXVOLUME);
-                buff->current_index += rest;
-            }
-            else
-            {
-                SDL_MixAudioFormat(stream,
-                                   current_buff,
-                                   e->audio_device_spec.format,
-                                   static_cast<uint32_t>(stream_size),
-                                   SDL_MIX_MAXVOLUME);
-                buff->current_index += static_cast<uint32_t>(stream_size);
-            }
+const audio_buffer* engine_opengl::get_sound(const char* path)
+{
+    if (mixer == nullptr)
+        return nullptr;
 
-            if (buff->current_index == buff->length)
-            {
-                if (buff->is_looped)
-                {
-                    buff->current_index = 0;
-                }
-                else
-                {
-                    buff->is_playing = false;
-                }
-            }
-        }
-    }
+    std::lock_guard<std::mutex> lock(sounds_mutex);
+    auto                        it = sounds.find(hash_asset_name(path));
+    return it != sounds.end() ? it->second : nullptr;
 }
 
-void engine_opengl::set_shader(shader* shader)
+music_stream* engine_opengl::get_music(const char* path)
 {
-    this->active_shader = shader;
+    if (mixer == nullptr)
+        return nullptr;
 
-    active_shader->use();
+    std::lock_guard<std::mutex> lock(sounds_mutex);
+    auto                        it = streams.find(hash_asset_name(path));
+    return it != streams.end() ? it->second : nullptr;
 }
 
-void engine_opengl::set_relative_mouse_mode(bool state)
+void engine_opengl::preload_sound(const char* path, bool is_looped)
 {
-    if (state)
-        SDL_SetRelativeMouseMode(SDL_TRUE);
+    // Decoding only needs the mixer format, the device is opened by the
+    // render thread
+    if (mixer == nullptr)
+        return;
+
+    const uint64_t id = hash_asset_name(path);
+    {
+        std::lock_guard<std::mutex> lock(sounds_mutex);
+        if (sounds.count(id) != 0 || streams.count(id) != 0)
+            return;
+    }
+    if (is_looped)
+    {
+        auto music = new music_stream(path, mixer->get_spec(), true);
+
+        std::lock_guard<std::mutex> lock(sounds_mutex);
+        music_stream*&              slot = streams[id];
+        if (slot == nullptr)
+            slot = music;
+        else
+            delete music;
+        return;
+    }
+    // Decoded outside the lock, two loads of one path keep the first
+    auto sound = new audio_buffer(path, mixer->get_spec());
+
+    std::lock_guard<std::mutex> lock(sounds_mutex);
+    audio_buffer*&              slot = sounds[id];
+    if (slot == nullptr)
+        slot = sound;
     else
-        SDL_SetRelativeMouseMode(SDL_FALSE);
+        delete sound;
 }
 
-void engine_opengl::play_sound(const char* path, bool is_looped)
+audio_stats engine_opengl::get_audio_stats() const
 {
-    std::lock_guard<std::mutex> lock(audio_mutex);
+    // The backend is opened by the first sound played
+    if (!is_audio_open || mixer == nullptr)
+        return {};
+    audio_stats stats = mixer->get_stats();
+    stats.backend     = audio_backend_name;
+    return stats;
+}
 
-    auto audio_buff =
-        new audio_buffer(path, audio_device, audio_device_spec, is_looped);
+void engine_opengl::play_sound(const char* path,
+                               bool        is_looped,
+                               uint8_t     priority)
+{
+    open_audio_device();
+    bool is_queued = true;
+    if (music_stream* music = get_music(path))
+        is_queued = mixer->play(music, priority);
+    else if (const audio_buffer* sound = get_sound(path))
+        is_queued = mixer->play(sound, is_looped, priority);
+    else if (mixer != nullptr &&
+             missing_sounds.insert(hash_asset_name(path)).second)
+        std::cerr << "sound was not preloaded, not played: " << path
+                  << std::endl;
+    if (!is_queued)
+        std::cerr << "audio command ring is full, dropped " << path
+                  << std::endl;
+}
 
-    audio_buff->current_index = 0;
-    audio_buff->is_playing    = true;
+void engine_opengl::stop_sound(const char* path)
+{
+    open_audio_device();
+    bool is_queued = true;
+    if (music_stream* music = get_music(path))
+        is_queued = mixer->stop(music);
+    else if (const audio_buffer* sound = get_sound(path))
+        is_queued = mixer->stop(sound);
+    if (!is_queued)
+        std::cerr << "audio command ring is full, dropped stop of " << path
+                  << std::endl;
+}
 
-    audio_output.push_back(audio_buff);
+void engine_opengl::set_sound_volume(const char* path, float volume)
+{
+    open_audio_device();
+    bool is_queued = true;
+    if (music_stream* music = get_music(path))
+        is_queued = mixer->set_volume(music, volume);
+    else if (const audio_buffer* sound = get_sound(path))
+        is_queued = mixer->set_volume(sound, volume);
+    if (!is_queued)
+        std::cerr << "audio command ring is full, dropped volume of " << path
+                  << std::endl;
 }
 
 bool ImGui_ImplSdlGL3_ProcessEvent(const SDL_Event* event, config& cfg)
@@ -932,6 +1584,8 @@ bool ImGui_ImplSdlGL3_ProcessEvent(const SDL_Event* event, config& cfg)
 
 void ImGui_ImplSdlGL3_CreateFontsTexture()
 {
+    TRACE_ZONE("ImGui_ImplSdlGL3_CreateFontsTexture");
+
     // Build texture atlas
     ImGuiIO&       io     = ImGui::GetIO();
     unsigned char* pixels = nullptr;
@@ -947,8 +1601,13 @@ void ImGui_ImplSdlGL3_CreateFontsTexture()
 
 bool ImGui_ImplSdlGL3_CreateDeviceObjects(config& cfg)
 {
-    g_imgui_shader =
-        new shader_opengl(cfg.shader_vertex_imgui, cfg.shader_fragment_imgui);
+    const shader_opengl::source source =
+        g_imgui_shader_source.valid()
+            ? g_imgui_shader_source.get()
+            : shader_opengl::read_source(cfg.shader_vertex_imgui,
+                                         cfg.shader_fragment_imgui);
+    g_imgui_shader = new shader_opengl(
+        cfg.shader_vertex_imgui, cfg.shader_fragment_imgui, source);
 
     ImGui_ImplSdlGL3_CreateFontsTexture();
 
@@ -975,6 +1634,7 @@ bool ImGui_ImplSdlGL3_Init(SDL_Window* window, config& cfg)
 
     ImGuiIO& io            = ImGui::GetIO();
     io.BackendPlatformName = "imgui_menu";
+    io.DisplaySize         = ImVec2(cfg.width, cfg.height);
 
     io.KeyMap[ImGuiKey_Tab]        = SDL_SCANCODE_TAB;
     io.KeyMap[ImGuiKey_LeftArrow]  = SDL_SCANCODE_LEFT;
@@ -1046,7 +1706,20 @@ void ImGui_ImplSdlGL3_Shutdown()
 
 void ImGui_ImplSdlGL3_NewFrame(SDL_Window* window)
 {
+    TRACE_ZONE("ImGui_ImplSdlGL3_NewFrame");
+
     ImGuiIO& io = ImGui::GetIO();
+
+    // Headless: display size stays as set in ImGui_ImplSdlGL3_Init
+    if (window == nullptr)
+    {
+        const float current_time = static_cast<float>(SDL_GetTicks()) / 1000.f;
+        io.DeltaTime = std::max(current_time - g_Time, 0.00001f);
+        g_Time       = current_time;
+        io.MousePos  = ImVec2(-FLT_MAX, -FLT_MAX);
+        return;
+    }
+
     // Setup display size (every frame to accommodate for window resizing)
     int w, h;
     int display_w, display_h;
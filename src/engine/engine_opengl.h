@@ -1,8 +1,23 @@
 #include "audio_buffer.h"
+#include "audio_mixer.h"
+#include "audio_offline.h"
+#include "music_stream.h"
+#include "core/resolution_controller.h"
 #include "engine.h"
+#include "gpu_timer_opengl.h"
 #include "imgui/imgui.h"
+#include "program_cache_opengl.h"
+#include "stream_buffer_opengl.h"
 #include "texture.h"
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
 #ifdef USE_GL_DEBUG
 #include <KHR/khrplatform.h>
 #endif
@@ -53,6 +68,11 @@ public:
                           const texture*                            tex,
                           const uint16_t* start_vertex_index,
                           size_t          num_vertexes) override;
+    void render_triangles(vertex_buffer<vertex3d_packed>* vertexes,
+                          index_buffer*                   indexes,
+                          const texture*                  tex,
+                          const uint16_t*                 start_vertex_index,
+                          size_t num_vertexes) override;
     void render_triangles(vertex_buffer<vertex2d_colored_textured>* vertexes,
                           index_buffer*                             indexes,
                           const texture*                            tex,
@@ -61,29 +81,115 @@ public:
 
     void swap_buffers() override;
 
-    texture* load_texture(uint32_t index, const char* path) override;
+    void  begin_scene() override;
+    void  end_scene() override;
+    float get_resolution_scale() const override;
+
+    std::shared_ptr<texture> load_texture(uint32_t    index,
+                                          const char* path) override;
+    texture_source           read_texture(const char* path) const override;
+    std::shared_ptr<texture> load_texture(uint32_t         index,
+                                          texture_source&& source) override;
+    resource_cache_stats     get_texture_cache_stats() const override;
+    bool                     reload_texture(texture_source&& source) override;
 
     void set_texture(uint32_t index) override;
-    void set_uniform(uniform& uni) override;
+    void set_uniform(const uniform& uni) override;
     void set_shader(shader* shader) override;
     void set_relative_mouse_mode(bool state) override;
+    void set_shader_features(uint32_t) override {}
 
-    void play_sound(const char* path, bool is_looped) override;
+    void play_sound(const char* path,
+                    bool        is_looped,
+                    uint8_t     priority) override;
+    void stop_sound(const char* path) override;
+    void set_sound_volume(const char* path, float volume) override;
+    void preload_sound(const char* path, bool is_looped) override;
+    audio_stats get_audio_stats() const override;
 
     void reload_uniform() override;
 
+    void capture_frame(const char* path) override;
+
+    void set_gpu_timing(bool state) override;
+    void begin_gpu_pass(gpu_pass pass) override;
+    void end_gpu_pass(gpu_pass pass) override;
+    bool get_gpu_pass_ms(gpu_pass pass, float& ms) const override;
+
+    size_t get_texture_bytes() const override;
+    bool   has_32bit_indexes() const override;
+    float  get_fence_wait_ms() const override;
+
 private:
-    SDL_Window*   window         = nullptr;
-    SDL_GLContext gl_context     = nullptr;
-    shader*       active_shader  = nullptr;
-    uniform*      uniforms_world = nullptr;
-
-    SDL_AudioDeviceID          audio_device;
-    SDL_AudioSpec              audio_device_spec;
-    std::vector<audio_buffer*> audio_output;
-
-    static void       audio_callback(void*    engine_ptr,
-                                     uint8_t* stream,
-                                     int      stream_size);
-    static std::mutex audio_mutex;
+    bool create_headless_context(config& cfg);
+    bool create_scene_target(const config& cfg);
+    void get_scene_size(GLsizei& width, GLsizei& height) const;
+    // Before any loader job, no SDL audio call
+    void create_audio_mixer();
+    // On the first play_sound() and friends, so SDL audio is initialized
+    // and the device opened on the render thread, off the first frame
+    void open_audio_device();
+    // config::audio, null audio when that fails
+    void open_audio_backend();
+    // SDL audio subsystem and the default device, false when either fails
+    bool open_audio_stream();
+    // Decoded sound for path, nullptr without audio or when it was never
+    // preloaded
+    const audio_buffer* get_sound(const char* path);
+    // Stream opened by a looped preload_sound(), else nullptr
+    music_stream* get_music(const char* path);
+    void save_framebuffer(const char* path);
+
+    SDL_Window*   window        = nullptr;
+    SDL_GLContext gl_context    = nullptr;
+    shader*       active_shader = nullptr;
+    uniform       uniforms_world;
+
+    // Headless mode has no window, everything goes to this framebuffer
+    bool        is_headless           = false;
+    GLuint      offscreen_framebuffer = 0;
+    GLuint      offscreen_color       = 0;
+    GLuint      offscreen_depth       = 0;
+    std::string capture_path;
+
+    gpu_timer_opengl gpu_timer;
+    bool             is_gpu_timing = false;
+
+    program_cache_opengl program_cache;
+    stream_buffer_opengl stream_buffer;
+
+    // Dynamic resolution, the scene is drawn here at a fraction of the
+    // window size and blitted up before ImGui. Off in headless runs, a
+    // capture must not depend on timing.
+    bool                  is_dynamic_resolution = false;
+    resolution_controller resolution;
+    GLuint                scene_framebuffer  = 0;
+    GLuint                scene_color        = 0;
+    GLuint                scene_depth        = 0;
+    GLuint                output_framebuffer = 0; // Window or headless FBO
+
+    std::chrono::steady_clock::time_point last_swap;
+
+    // The mixer is there from initialize(), its output from the first sound
+    std::atomic<bool>              is_audio_open{ false };
+    SDL_AudioDeviceID              audio_device = 0;
+    SDL_AudioSpec                  audio_device_spec;
+    std::unique_ptr<audio_mixer>   mixer;
+    std::unique_ptr<audio_offline> audio_output; // Offline and null
+    const char*                    audio_backend_name = "null";
+    // Decoded or streamed once per hash_asset_name() of the path and kept
+    // until uninitialize(), voices point into them. The audio thread never
+    // takes sounds_mutex.
+    std::unordered_map<uint64_t, audio_buffer*> sounds;
+    std::unordered_map<uint64_t, music_stream*> streams;
+    std::mutex                                  sounds_mutex;
+    std::unordered_set<uint64_t>                missing_sounds; // Render thread
+
+    bool has_etc2 = false; // Set once in initialize(), read by loader jobs
+
+    resource_cache<texture> textures;
+
+    static void audio_callback(void*    engine_ptr,
+                               uint8_t* stream,
+                               int      stream_size);
 };
@@ -0,0 +1,968 @@
+#include "engine_software.h"
+
+#include "core/png.h"
+#include "core/simd.h"
+#include "imgui/imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+struct vec4f
+{
+    float x, y, z, w;
+};
+
+// Same convention as the GLSL shaders: mat4 is built from four vec4 columns
+// and vertexes are multiplied from the left (v * m), so every column gives
+// one component of the result.
+struct mat4f
+{
+    vec4f c[4];
+};
+
+inline float dot4(const vec4f& a, const vec4f& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+inline vec4f mul(const vec4f& v, const mat4f& m)
+{
+    return {
+        dot4(v, m.c[0]), dot4(v, m.c[1]), dot4(v, m.c[2]), dot4(v, m.c[3])
+    };
+}
+
+// Returns matrix r such that mul(v, r) == mul(mul(v, a), b)
+mat4f compose(const mat4f& a, const mat4f& b)
+{
+    mat4f r;
+    for (int j = 0; j < 4; j++)
+    {
+        const float* bj = &b.c[j].x;
+        float*       rj = &r.c[j].x;
+        for (int k = 0; k < 4; k++)
+        {
+            rj[k] = bj[0] * (&a.c[0].x)[k] + bj[1] * (&a.c[1].x)[k] +
+                    bj[2] * (&a.c[2].x)[k] + bj[3] * (&a.c[3].x)[k];
+        }
+    }
+    return r;
+}
+
+mat4f rotate_matrix(float x, float y, float z)
+{
+    return { { { std::cos(x) * std::cos(y),
+                 std::sin(x) * std::cos(y),
+                 -std::sin(y),
+                 0.f },
+               { std::cos(x) * std::sin(y) * std::sin(z) -
+                     std::sin(x) * std::cos(z),
+                 std::sin(x) * std::sin(y) * std::sin(z) +
+                     std::cos(x) * std::cos(z),
+                 std::cos(y) * std::sin(z),
+                 0.f },
+               { std::cos(x) * std::sin(y) * std::cos(z) +
+                     std::sin(x) * std::sin(z),
+                 std::sin(x) * std::sin(y) * std::cos(z) -
+                     std::cos(x) * std::sin(z),
+                 std::cos(y) * std::cos(z),
+                 0.f },
+               { 0.f, 0.f, 0.f, 1.f } } };
+}
+
+mat4f translate_matrix(float x, float y, float z)
+{
+    return { { { 1.f, 0.f, 0.f, x },
+               { 0.f, 1.f, 0.f, y },
+               { 0.f, 0.f, 1.f, z },
+               { 0.f, 0.f, 0.f, 1.f } } };
+}
+
+mat4f scale_matrix(float x, float y, float z)
+{
+    return { { { x, 0.f, 0.f, 0.f },
+               { 0.f, y, 0.f, 0.f },
+               { 0.f, 0.f, z, 0.f },
+               { 0.f, 0.f, 0.f, 1.f } } };
+}
+
+// Constants of res/shaders/shader.vert and shader.frag
+constexpr float front            = 0.1f;
+constexpr float back             = 30.f;
+constexpr float fovy             = 3.14159f / 2.f;
+constexpr float ambient_strength  = 0.3f;
+constexpr float specular_strength = 0.9f;
+
+mat4f perspective_matrix(float aspect)
+{
+    const float t = std::tan(fovy / 2.f);
+    return { { { 1.f / (aspect * t), 0.f, 0.f, 0.f },
+               { 0.f, 1.f / t, 0.f, 0.f },
+               { 0.f,
+                 0.f,
+                 (back + front) / (back - front),
+                 -2.f * back * front / (back - front) },
+               { 0.f, 0.f, 1.f, 0.f } } };
+}
+
+vector2d get_uv(const vertex3d&)
+{
+    return vector2d(0.f, 0.f);
+}
+vector2d get_uv(const vertex3d_textured& v)
+{
+    return v.uv;
+}
+vector2d get_uv(const vertex3d_colored_textured& v)
+{
+    return v.uv;
+}
+
+template <class vertex_type>
+void transform_vertex(const vertex_type&              in,
+                      const mat4f&                    model,
+                      const mat4f&                    view_projection,
+                      engine_software::raster_vertex& out)
+{
+    const vec4f pos = mul({ in.pos.x, in.pos.y, in.pos.z, 1.f }, model);
+    vec4f normal = mul({ in.normal.x, in.normal.y, in.normal.z, 0.f }, model);
+
+    const float len = std::sqrt(normal.x * normal.x + normal.y * normal.y +
+                                normal.z * normal.z);
+    if (len > 0.f)
+    {
+        normal.x /= len;
+        normal.y /= len;
+        normal.z /= len;
+    }
+    const vec4f    clip = mul({ pos.x, pos.y, pos.z, 1.f }, view_projection);
+    const vector2d uv   = get_uv(in);
+
+    out.x           = clip.x;
+    out.y           = clip.y;
+    out.z           = clip.z;
+    out.w           = clip.w;
+    out.varyings[0] = pos.x;
+    out.varyings[1] = pos.y;
+    out.varyings[2] = pos.z;
+    out.varyings[3] = normal.x;
+    out.varyings[4] = normal.y;
+    out.varyings[5] = normal.z;
+    out.varyings[6] = uv.x;
+    out.varyings[7] = uv.y;
+}
+
+inline uint32_t pack_color(float r, float g, float b, float a)
+{
+    auto to_byte = [](float c)
+    {
+        c = std::min(std::max(c, 0.f), 1.f);
+        return static_cast<uint32_t>(c * 255.f + 0.5f);
+    };
+    return to_byte(r) | (to_byte(g) << 8) | (to_byte(b) << 16) |
+           (to_byte(a) << 24);
+}
+
+inline float channel(uint32_t color, int index)
+{
+    return static_cast<float>((color >> (index * 8)) & 0xFF) / 255.f;
+}
+} // namespace
+
+int engine_software::initialize(config& cfg)
+{
+    width   = static_cast<uint32_t>(cfg.width);
+    height  = static_cast<uint32_t>(cfg.height);
+    tiles_x = (static_cast<int>(width) + tile_size - 1) / tile_size;
+    tiles_y = (static_cast<int>(height) + tile_size - 1) / tile_size;
+
+    color_buffer.resize(static_cast<size_t>(width) * height);
+    depth_buffer.resize(static_cast<size_t>(width) * height);
+    front_buffer.resize(static_cast<size_t>(width) * height);
+    bins.resize(static_cast<size_t>(tiles_x) * tiles_y);
+
+    size_t num_threads = cfg.software_render_threads;
+    if (num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    // Calling thread takes part in every parallel_for
+    if (num_threads > 1)
+        workers = std::make_unique<thread_pool>(num_threads - 1);
+
+    std::cout << "software renderer: " << width << "x" << height << ", "
+              << num_threads << " threads" << std::endl;
+
+    _config          = cfg;
+    last_frame       = std::chrono::steady_clock::now();
+    allowed_features = shader_feature::get_allowed(cfg.quality);
+    shader_features  = allowed_features;
+
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGui::StyleColorsDark();
+
+    ImGuiIO& io            = ImGui::GetIO();
+    io.BackendPlatformName = "imgui_software";
+    io.DisplaySize         = ImVec2(cfg.width, cfg.height);
+
+    unsigned char* pixels      = nullptr;
+    int            font_width  = 0;
+    int            font_height = 0;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &font_width, &font_height);
+    font_texture    = new texture_software(pixels,
+                                        static_cast<size_t>(font_width),
+                                        static_cast<size_t>(font_height));
+    io.Fonts->TexID = font_texture;
+
+    clear();
+    return 1;
+}
+
+void engine_software::uninitialize()
+{
+    ImGui::DestroyContext();
+    delete font_texture;
+    font_texture = nullptr;
+    workers.reset();
+}
+
+bool engine_software::event_keyboard(event&)
+{
+    // No window, so there is nothing to poll
+    return false;
+}
+
+template <class vertex_type, class index_type>
+void engine_software::submit(const vertex_type* vertexes_in,
+                             const index_type*  indexes,
+                             size_t             num_indexes,
+                             const texture*     tex)
+{
+    draw_state state;
+    state.tex = static_cast<const texture_software*>(tex);
+
+    const size_t first = vertexes.size();
+
+    if constexpr (std::is_same_v<vertex_type, vertex2d_colored_textured>)
+    {
+        state.is_2d = true;
+
+        size_t num_vertexes = 0;
+        for (size_t i = 0; i < num_indexes; i++)
+            num_vertexes = std::max<size_t>(num_vertexes, indexes[i] + 1);
+        vertexes.resize(first + num_vertexes);
+
+        const float w = static_cast<float>(width);
+        const float h = static_cast<float>(height);
+        for (size_t i = 0; i < num_vertexes; i++)
+        {
+            const vertex_type& in  = vertexes_in[i];
+            raster_vertex&     out = vertexes[first + i];
+
+            out.x           = 2.f * in.pos.x / w - 1.f;
+            out.y           = 1.f - 2.f * in.pos.y / h;
+            out.z           = -1.f;
+            out.w           = 1.f;
+            out.varyings[0] = in.rgba.get_r();
+            out.varyings[1] = in.rgba.get_g();
+            out.varyings[2] = in.rgba.get_b();
+            out.varyings[3] = in.rgba.get_a();
+            out.varyings[4] = in.uv.x;
+            out.varyings[5] = in.uv.y;
+        }
+    }
+    else
+    {
+        const uniform& u = uniforms_world;
+        state.features   = shader_features;
+        state.camera_pos = vector3d(-u.translate_x_camera,
+                                    -u.translate_y_camera,
+                                    -u.translate_z_camera);
+
+        const mat4f model = compose(
+            compose(scale_matrix(u.scale_x_obj, u.scale_y_obj, u.scale_z_obj),
+                    translate_matrix(u.translate_x_obj,
+                                     u.translate_y_obj,
+                                     u.translate_z_obj)),
+            rotate_matrix(
+                u.rotate_alpha_obj, u.rotate_beta_obj, u.rotate_gamma_obj));
+        const mat4f view_projection =
+            compose(compose(translate_matrix(u.translate_x_camera,
+                                             u.translate_y_camera,
+                                             u.translate_z_camera),
+                            rotate_matrix(u.rotate_alpha_camera,
+                                          u.rotate_beta_camera,
+                                          u.rotate_gamma_camera)),
+                    perspective_matrix(u.width / u.height));
+
+        size_t num_vertexes = 0;
+        for (size_t i = 0; i < num_indexes; i++)
+            num_vertexes = std::max<size_t>(num_vertexes, indexes[i] + 1);
+        vertexes.resize(first + num_vertexes);
+
+        constexpr size_t chunk      = 1024;
+        const size_t     num_chunks = (num_vertexes + chunk - 1) / chunk;
+        parallel_for(num_chunks,
+                     [&](size_t c)
+                     {
+                         const size_t end =
+                             std::min(num_vertexes, (c + 1) * chunk);
+                         for (size_t i = c * chunk; i < end; i++)
+                             transform_vertex(vertexes_in[i],
+                                              model,
+                                              view_projection,
+                                              vertexes[first + i]);
+                     });
+    }
+
+    const auto state_index = static_cast<uint32_t>(states.size());
+    states.push_back(state);
+
+    for (size_t i = 0; i + 2 < num_indexes; i += 3)
+    {
+        // Copies, clip_and_add may grow vertexes
+        const raster_vertex a = vertexes[first + indexes[i + 0]];
+        const raster_vertex b = vertexes[first + indexes[i + 1]];
+        const raster_vertex c = vertexes[first + indexes[i + 2]];
+        clip_and_add(a, b, c, state_index);
+    }
+}
+
+void engine_software::clip_and_add(const raster_vertex& a,
+                                   const raster_vertex& b,
+                                   const raster_vertex& c,
+                                   uint32_t             state)
+{
+    // Only the near plane (z >= -w) has to be clipped, everything else is
+    // handled by the screen bounding box and the depth range test
+    auto distance = [](const raster_vertex& v) { return v.z + v.w; };
+
+    const raster_vertex* in[3] = { &a, &b, &c };
+    raster_vertex        out[4];
+    int                  num_out = 0;
+
+    for (int i = 0; i < 3; i++)
+    {
+        const raster_vertex& cur  = *in[i];
+        const raster_vertex& next = *in[(i + 1) % 3];
+        const float          d0   = distance(cur);
+        const float          d1   = distance(next);
+
+        if (d0 >= 0.f)
+            out[num_out++] = cur;
+        if ((d0 >= 0.f) != (d1 >= 0.f))
+        {
+            const float    t = d0 / (d0 - d1);
+            raster_vertex& v = out[num_out++];
+            v.x              = cur.x + (next.x - cur.x) * t;
+            v.y              = cur.y + (next.y - cur.y) * t;
+            v.z              = cur.z + (next.z - cur.z) * t;
+            v.w              = cur.w + (next.w - cur.w) * t;
+            for (int k = 0; k < 8; k++)
+                v.varyings[k] =
+                    cur.varyings[k] + (next.varyings[k] - cur.varyings[k]) * t;
+        }
+    }
+
+    for (int i = 1; i + 1 < num_out; i++)
+        add_triangle(out[0], out[i], out[i + 1], state);
+}
+
+void engine_software::add_triangle(const raster_vertex& a,
+                                   const raster_vertex& b,
+                                   const raster_vertex& c,
+                                   uint32_t             state)
+{
+    const raster_vertex* v[3] = { &a, &b, &c };
+    triangle_setup       t;
+
+    const float w = static_cast<float>(width);
+    const float h = static_cast<float>(height);
+    for (int i = 0; i < 3; i++)
+    {
+        if (v[i]->w <= 0.f)
+            return;
+        t.inv_w[i] = 1.f / v[i]->w;
+        t.x[i]     = (v[i]->x * t.inv_w[i] * 0.5f + 0.5f) * w;
+        t.y[i]     = (0.5f - v[i]->y * t.inv_w[i] * 0.5f) * h;
+        t.z[i]     = v[i]->z * t.inv_w[i] * 0.5f + 0.5f;
+    }
+
+    const float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) -
+                       (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+    if (area == 0.f || !std::isfinite(area))
+        return;
+
+    // Counter clockwise in GL window space (y up) is clockwise here
+    t.front_facing = area < 0.f;
+    t.inv_area     = 1.f / area;
+
+    t.min_x = std::max(0, static_cast<int>(std::floor(
+                              std::min({ t.x[0], t.x[1], t.x[2] }))));
+    t.min_y = std::max(0, static_cast<int>(std::floor(
+                              std::min({ t.y[0], t.y[1], t.y[2] }))));
+    t.max_x = std::min(static_cast<int>(width) - 1,
+                       static_cast<int>(std::ceil(
+                           std::max({ t.x[0], t.x[1], t.x[2] }))));
+    t.max_y = std::min(static_cast<int>(height) - 1,
+                       static_cast<int>(std::ceil(
+                           std::max({ t.y[0], t.y[1], t.y[2] }))));
+    if (t.min_x > t.max_x || t.min_y > t.max_y)
+        return;
+
+    const auto first = static_cast<uint32_t>(vertexes.size());
+    vertexes.push_back(a);
+    vertexes.push_back(b);
+    vertexes.push_back(c);
+    t.v[0]  = first;
+    t.v[1]  = first + 1;
+    t.v[2]  = first + 2;
+    t.state = state;
+
+    triangles.push_back(t);
+}
+
+void engine_software::rasterize_tile(size_t tile_index)
+{
+    const int tile_x0 = static_cast<int>(tile_index % tiles_x) * tile_size;
+    const int tile_y0 = static_cast<int>(tile_index / tiles_x) * tile_size;
+    const int tile_x1 = std::min(tile_x0 + tile_size, static_cast<int>(width));
+    const int tile_y1 =
+        std::min(tile_y0 + tile_size, static_cast<int>(height));
+
+    const float4 zero(0.f);
+    const float4 half(0.5f);
+    const float4 one(1.f);
+    const float4 tiny(1e-30f);
+    const float4 lane_offset(0.5f, 1.5f, 2.5f, 3.5f);
+
+    for (uint32_t index : bins[tile_index])
+    {
+        const triangle_setup& t     = triangles[index];
+        const draw_state&     state = states[t.state];
+        const raster_vertex*  v[3]  = { &vertexes[t.v[0]],
+                                        &vertexes[t.v[1]],
+                                        &vertexes[t.v[2]] };
+
+        const int x0 = std::max(t.min_x, tile_x0);
+        const int y0 = std::max(t.min_y, tile_y0);
+        const int x1 = std::min(t.max_x + 1, tile_x1);
+        const int y1 = std::min(t.max_y + 1, tile_y1);
+        if (x0 >= x1 || y0 >= y1)
+            continue;
+
+        // Edge functions scaled so that the inside of the triangle is
+        // positive whatever the winding is
+        const float sign = t.inv_area > 0.f ? 1.f : -1.f;
+        float       ea[3], eb[3], ec[3];
+        bool        top_left[3];
+        for (int i = 0; i < 3; i++)
+        {
+            const int j = (i + 1) % 3;
+            const int k = (i + 2) % 3;
+            ea[i]       = sign * (t.y[j] - t.y[k]);
+            eb[i]       = sign * (t.x[k] - t.x[j]);
+            ec[i]       = sign * (t.x[j] * t.y[k] - t.x[k] * t.y[j]);
+            top_left[i] = (ea[i] > 0.f) || (ea[i] == 0.f && eb[i] > 0.f);
+        }
+        const float inv_area = std::abs(t.inv_area);
+
+        const texture_software* tex = state.tex;
+
+        for (int y = y0; y < y1; y++)
+        {
+            const float py = static_cast<float>(y) + 0.5f;
+            for (int x = x0; x < x1; x += 4)
+            {
+                const float4 px = float4(static_cast<float>(x)) + lane_offset;
+
+                int    mask = (1 << std::min(4, x1 - x)) - 1;
+                float4 e[3];
+                for (int i = 0; i < 3; i++)
+                {
+                    e[i] = float4(ea[i]) * px + float4(eb[i] * py + ec[i]);
+                    mask &= top_left[i] ? mask_ge(e[i], zero)
+                                        : mask_lt(zero, e[i]);
+                }
+                if (mask == 0)
+                    continue;
+
+                // Lanes past x1 are never read or written, the next tile
+                // may belong to another thread
+                const int    lanes = std::min(4, x1 - x);
+                const size_t row   = static_cast<size_t>(y) * width + x;
+                const float4 b0    = e[0] * float4(inv_area);
+                const float4 b1    = e[1] * float4(inv_area);
+                const float4 b2    = e[2] * float4(inv_area);
+
+                if (!state.is_2d)
+                {
+                    const float4 z = b0 * float4(t.z[0]) +
+                                     b1 * float4(t.z[1]) +
+                                     b2 * float4(t.z[2]);
+                    float depth[4] = { 1.f, 1.f, 1.f, 1.f };
+                    for (int lane = 0; lane < lanes; lane++)
+                        depth[lane] = depth_buffer[row + lane];
+
+                    mask &= mask_ge(z, zero) & mask_ge(one, z) &
+                            mask_lt(z, float4::load(depth));
+                    if (mask == 0)
+                        continue;
+
+                    z.store(depth);
+                    for (int lane = 0; lane < lanes; lane++)
+                    {
+                        if (mask & (1 << lane))
+                            depth_buffer[row + lane] = depth[lane];
+                    }
+                }
+
+                // Perspective correct interpolation weights
+                float4       p0      = b0 * float4(t.inv_w[0]);
+                float4       p1      = b1 * float4(t.inv_w[1]);
+                float4       p2      = b2 * float4(t.inv_w[2]);
+                const float4 inv_sum = one / (p0 + p1 + p2);
+                p0                   = p0 * inv_sum;
+                p1                   = p1 * inv_sum;
+                p2                   = p2 * inv_sum;
+
+                float4 var[8];
+                for (int k = 0; k < 8; k++)
+                    var[k] = p0 * float4(v[0]->varyings[k]) +
+                             p1 * float4(v[1]->varyings[k]) +
+                             p2 * float4(v[2]->varyings[k]);
+
+                // Texture fetches stay per lane, the rest is 4 wide
+                const int u_index = state.is_2d ? 4 : 6;
+                float     tu[4], tv[4];
+                var[u_index].store(tu);
+                var[u_index + 1].store(tv);
+                float texel[4][4] = {};
+                float dst[4][4]   = {};
+                for (int lane = 0; lane < lanes; lane++)
+                {
+                    if ((mask & (1 << lane)) == 0)
+                        continue;
+                    const uint32_t c =
+                        tex ? tex->sample(tu[lane], tv[lane]) : 0xFFFFFFFFu;
+                    const uint32_t d = color_buffer[row + lane];
+                    for (int i = 0; i < 4; i++)
+                    {
+                        texel[i][lane] = channel(c, i);
+                        dst[i][lane]   = channel(d, i);
+                    }
+                }
+                const float4 tex_r = float4::load(texel[0]);
+                const float4 tex_g = float4::load(texel[1]);
+                const float4 tex_b = float4::load(texel[2]);
+                const float4 tex_a = float4::load(texel[3]);
+
+                float4 r, g, bl, a;
+                if (state.is_2d)
+                {
+                    r  = var[0] * tex_r;
+                    g  = var[1] * tex_g;
+                    bl = var[2] * tex_b;
+                    a  = var[3] * tex_a;
+                }
+                else if ((state.features & shader_feature::lighting) == 0)
+                {
+                    r  = tex_r;
+                    g  = tex_g;
+                    bl = tex_b;
+                    a  = tex_a;
+                }
+                else
+                {
+                    // res/shaders/shader.frag
+                    const float  flip = t.front_facing ? -1.f : 1.f;
+                    const float4 nx   = var[3] * float4(flip);
+                    const float4 ny   = var[4] * float4(flip);
+                    const float4 nz   = var[5] * float4(flip);
+
+                    const vector3d& light = state.camera_pos;
+                    const float4    lx    = float4(light.x) - var[0];
+                    const float4    ly    = float4(light.y) - var[1];
+                    const float4    lz    = float4(light.z) - var[2];
+                    const float4    dist  = sqrt(lx * lx + ly * ly + lz * lz);
+
+                    // A light on the surface leaves l zero, so no diffuse
+                    const float4 inv_dist = one / max(dist, tiny);
+                    const float4 n_dot_l =
+                        (nx * lx + ny * ly + nz * lz) * inv_dist;
+                    float4 light_factor =
+                        float4(ambient_strength) + max(n_dot_l, zero);
+
+                    if (state.features & shader_feature::specular)
+                    {
+                        // The light is at the camera, so the view direction
+                        // is l and dot(view, reflect(-l, n)) is
+                        // 2 dot(n, l)^2 - 1
+                        float4 spec = max(
+                            float4(2.f) * n_dot_l * n_dot_l - one, zero);
+                        for (int i = 0; i < 5; i++)
+                            spec = spec * spec; // pow(spec, 32)
+                        light_factor =
+                            light_factor + float4(specular_strength) * spec;
+                    }
+                    if (state.features & shader_feature::attenuation)
+                        light_factor =
+                            light_factor / max(one, sqrt(sqrt(dist)));
+
+                    r  = light_factor * tex_r;
+                    g  = light_factor * tex_g;
+                    bl = light_factor * tex_b;
+                    a  = tex_a;
+                }
+
+                // glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA), then
+                // rounded to bytes like pack_color()
+                a                 = min(max(a, zero), one);
+                const float4 keep = one - a;
+                float        out[4][4];
+                const float4 blended[4] = {
+                    r * a + float4::load(dst[0]) * keep,
+                    g * a + float4::load(dst[1]) * keep,
+                    bl * a + float4::load(dst[2]) * keep,
+                    a * a + float4::load(dst[3]) * keep
+                };
+                for (int i = 0; i < 4; i++)
+                    (min(max(blended[i], zero), one) * float4(255.f) + half)
+                        .store(out[i]);
+
+                for (int lane = 0; lane < lanes; lane++)
+                {
+                    if ((mask & (1 << lane)) == 0)
+                        continue;
+                    color_buffer[row + lane] =
+                        static_cast<uint32_t>(out[0][lane]) |
+                        (static_cast<uint32_t>(out[1][lane]) << 8) |
+                        (static_cast<uint32_t>(out[2][lane]) << 16) |
+                        (static_cast<uint32_t>(out[3][lane]) << 24);
+                }
+            }
+        }
+    }
+}
+
+void engine_software::flush()
+{
+    if (triangles.empty())
+        return;
+
+    for (std::vector<uint32_t>& bin : bins)
+        bin.clear();
+
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        const triangle_setup& t = triangles[i];
+        for (int ty = t.min_y / tile_size; ty <= t.max_y / tile_size; ty++)
+        {
+            for (int tx = t.min_x / tile_size; tx <= t.max_x / tile_size; tx++)
+            {
+                bins[static_cast<size_t>(ty) * tiles_x + tx].push_back(
+                    static_cast<uint32_t>(i));
+            }
+        }
+    }
+
+    parallel_for(bins.size(), [this](size_t i) { rasterize_tile(i); });
+
+    triangles_drawn += triangles.size();
+    triangles.clear();
+    vertexes.clear();
+    states.clear();
+}
+
+void engine_software::clear()
+{
+    const uint32_t clear_color =
+        pack_color(77. / 255., 143. / 255., 210. / 255., 1.);
+    std::fill(color_buffer.begin(), color_buffer.end(), clear_color);
+    std::fill(depth_buffer.begin(), depth_buffer.end(), 1.f);
+}
+
+void engine_software::parallel_for(size_t                             count,
+                                   const std::function<void(size_t)>& func)
+{
+    if (workers)
+    {
+        workers->parallel_for(count, func);
+        return;
+    }
+    for (size_t i = 0; i < count; i++)
+        func(i);
+}
+
+void engine_software::render_triangle(const triangle<vertex3d>& tr)
+{
+    static const uint16_t indexes[] = { 0, 1, 2 };
+    submit(tr.vertexes.data(), indexes, 3, nullptr);
+}
+
+void engine_software::render_triangle(const triangle<vertex3d_colored>& tr)
+{
+    static const uint16_t indexes[] = { 0, 1, 2 };
+    submit(tr.vertexes.data(), indexes, 3, nullptr);
+}
+
+void engine_software::render_triangle(const triangle<vertex3d_textured>& tr)
+{
+    static const uint16_t indexes[] = { 0, 1, 2 };
+    submit(tr.vertexes.data(), indexes, 3, nullptr);
+}
+
+void engine_software::render_triangle(
+    const triangle<vertex3d_colored_textured>& tr)
+{
+    static const uint16_t indexes[] = { 0, 1, 2 };
+    submit(tr.vertexes.data(), indexes, 3, nullptr);
+}
+
+// start_vertex_index follows glDrawElements: it is an offset into the index
+// buffer disguised as a pointer
+template <class vertex_type>
+void engine_software::submit_buffer(const vertex_type*  vertexes_in,
+                                    const index_buffer* indexes,
+                                    const uint16_t*     start_vertex_index,
+                                    size_t              num_indexes,
+                                    const texture*      tex)
+{
+    const size_t first = reinterpret_cast<uintptr_t>(start_vertex_index) /
+                         indexes->get_index_size();
+    if (indexes->is_32bit())
+        submit(vertexes_in, indexes->data32() + first, num_indexes, tex);
+    else
+        submit(vertexes_in, indexes->data() + first, num_indexes, tex);
+}
+
+void engine_software::render_triangles(vertex_buffer<vertex3d>* vertexes,
+                                       index_buffer*            indexes,
+                                       const std::uint16_t* start_vertex_index,
+                                       size_t               num_vertexes)
+{
+    submit_buffer(vertexes->data(),
+                  indexes,
+                  start_vertex_index,
+                  num_vertexes,
+                  nullptr);
+}
+
+void engine_software::render_triangles(
+    vertex_buffer<vertex3d_colored>* vertexes,
+    index_buffer*                    indexes,
+    const std::uint16_t*             start_vertex_index,
+    size_t                           num_vertexes)
+{
+    submit_buffer(vertexes->data(),
+                  indexes,
+                  start_vertex_index,
+                  num_vertexes,
+                  nullptr);
+}
+
+void engine_software::render_triangles(
+    vertex_buffer<vertex3d_textured>* vertexes,
+    index_buffer*                     indexes,
+    const texture*                    tex,
+    const uint16_t*                   start_vertex_index,
+    size_t                            num_vertexes)
+{
+    submit_buffer(vertexes->data(),
+                  indexes,
+                  start_vertex_index,
+                  num_vertexes,
+                  tex);
+}
+
+void engine_software::render_triangles(
+    vertex_buffer<vertex3d_colored_textured>* vertexes,
+    index_buffer*                             indexes,
+    const texture*                            tex,
+    const uint16_t*                           start_vertex_index,
+    size_t                                    num_vertexes)
+{
+    submit_buffer(vertexes->data(),
+                  indexes,
+                  start_vertex_index,
+                  num_vertexes,
+                  tex);
+}
+
+void engine_software::render_triangles(
+    vertex_buffer<vertex3d_packed>* vertexes,
+    index_buffer*                   indexes,
+    const texture*                  tex,
+    const uint16_t*                 start_vertex_index,
+    size_t                          num_vertexes)
+{
+    // Nothing to save on the CPU, decode into the float layout. submit()
+    // transforms them at once, so one scratch buffer serves every draw.
+    if (unpacked.size() < vertexes->size())
+        unpacked.resize(vertexes->size());
+    for (size_t i = 0; i < vertexes->size(); i++)
+        unpacked[i] =
+            vertexes->data()[i].unpack(uniforms_world.position_scale);
+
+    submit_buffer(unpacked.data(),
+                  indexes,
+                  start_vertex_index,
+                  num_vertexes,
+                  tex);
+}
+
+void engine_software::render_triangles(
+    vertex_buffer<vertex2d_colored_textured>* vertexes,
+    index_buffer*                             indexes,
+    const texture*                            tex,
+    const uint16_t*                           start_vertex_index,
+    size_t                                    num_vertexes)
+{
+    submit_buffer(vertexes->data(),
+                  indexes,
+                  start_vertex_index,
+                  num_vertexes,
+                  tex);
+}
+
+void engine_software::render_imgui()
+{
+    ImDrawData* draw_data = ImGui::GetDrawData();
+    if (draw_data == nullptr)
+        return;
+
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+
+        auto vertex_data = reinterpret_cast<const vertex2d_colored_textured*>(
+            cmd_list->VtxBuffer.Data);
+        const uint16_t* indexes = cmd_list->IdxBuffer.Data;
+
+        for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
+        {
+            const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
+
+            auto tex = static_cast<const texture_software*>(pcmd->TextureId);
+            submit(vertex_data, indexes, pcmd->ElemCount, tex);
+
+            indexes += pcmd->ElemCount;
+        }
+    }
+}
+
+void engine_software::swap_buffers()
+{
+    triangles_drawn = 0;
+
+    render_imgui();
+    flush();
+
+    front_buffer.swap(color_buffer);
+
+    if (!capture_path.empty())
+    {
+        save_frame(capture_path.c_str());
+        capture_path.clear();
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    ImGuiIO&   io  = ImGui::GetIO();
+    io.DisplaySize =
+        ImVec2(static_cast<float>(width), static_cast<float>(height));
+    io.DeltaTime = std::max(
+        std::chrono::duration<float>(now - last_frame).count(), 0.00001f);
+    last_frame = now;
+
+    clear();
+}
+
+std::shared_ptr<texture> engine_software::load_texture(uint32_t    index,
+                                                       const char* path)
+{
+    return textures.get(
+        path, [path]() { return std::make_shared<texture_software>(path); });
+}
+
+texture_source engine_software::read_texture(const char* path) const
+{
+    texture_source result;
+    result.path = path;
+
+    unsigned long w = 0;
+    unsigned long h = 0;
+    get_pixels_from_png(path, result.pixels, w, h);
+    result.width  = static_cast<uint32_t>(w);
+    result.height = static_cast<uint32_t>(h);
+    return result;
+}
+
+std::shared_ptr<texture> engine_software::load_texture(
+    uint32_t index, texture_source&& source)
+{
+    return textures.get(source.path.c_str(),
+                        [&source]()
+                        {
+                            return std::make_shared<texture_software>(
+                                source.pixels.data(),
+                                source.width,
+                                source.height);
+                        });
+}
+
+resource_cache_stats engine_software::get_texture_cache_stats() const
+{
+    return textures.get_stats();
+}
+
+bool engine_software::reload_texture(texture_source&& source)
+{
+    std::shared_ptr<texture> resident = textures.find(source.path.c_str());
+    if (!resident)
+        return false;
+
+    texture_software fresh(source.pixels.data(), source.width, source.height);
+    static_cast<texture_software&>(*resident).swap(fresh);
+    return true;
+}
+
+void engine_software::set_texture(uint32_t index) {}
+
+void engine_software::set_uniform(const uniform& uni)
+{
+    uniforms_world = uni;
+}
+
+void engine_software::set_shader(shader* shader)
+{
+    // Shading is fixed function and mirrors res/shaders, the permutation is
+    // picked with set_shader_features()
+    active_shader = shader;
+}
+
+void engine_software::set_shader_features(uint32_t features)
+{
+    shader_features = features & allowed_features;
+}
+
+void engine_software::set_relative_mouse_mode(bool state) {}
+
+void engine_software::play_sound(const char* path,
+                                 bool        is_looped,
+                                 uint8_t     priority)
+{
+}
+
+void engine_software::reload_uniform() {}
+
+void engine_software::capture_frame(const char* path)
+{
+    capture_path = path;
+}
+
+void engine_software::save_frame(const char* path) const
+{
+    write_png(path, front_buffer.data(), width, height);
+}
@@ -0,0 +1,191 @@
+#pragma once
+#include "core/thread_pool.h"
+#include "engine.h"
+#include "texture_software.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// engine implementation which rasterizes everything on the CPU into an in
+// memory framebuffer. Draw calls are transformed immediately, binned into
+// screen tiles and the tiles are shaded in parallel on swap_buffers().
+class engine_software : public engine
+{
+public:
+    int  initialize(config& _config) override;
+    void uninitialize() override;
+
+    bool event_keyboard(event&) override;
+
+    void render_triangle(const triangle<vertex3d>& tr) override;
+    void render_triangle(const triangle<vertex3d_colored>& tr) override;
+    void render_triangle(const triangle<vertex3d_textured>& tr) override;
+    void render_triangle(
+        const triangle<vertex3d_colored_textured>& tr) override;
+
+    void render_triangles(vertex_buffer<vertex3d>* vertexes,
+                          index_buffer*            indexes,
+                          const std::uint16_t*     start_vertex_index,
+                          size_t                   num_vertexes) override;
+    void render_triangles(vertex_buffer<vertex3d_colored>* vertexes,
+                          index_buffer*                    indexes,
+                          const std::uint16_t*             start_vertex_index,
+                          size_t num_vertexes) override;
+    void render_triangles(vertex_buffer<vertex3d_textured>* vertexes,
+                          index_buffer*                     indexes,
+                          const texture*                    tex,
+                          const uint16_t*                   start_vertex_index,
+                          size_t num_vertexes) override;
+    void render_triangles(vertex_buffer<vertex3d_colored_textured>* vertexes,
+                          index_buffer*                             indexes,
+                          const texture*                            tex,
+                          const uint16_t* start_vertex_index,
+                          size_t          num_vertexes) override;
+    void render_triangles(vertex_buffer<vertex3d_packed>* vertexes,
+                          index_buffer*                   indexes,
+                          const texture*                  tex,
+                          const uint16_t*                 start_vertex_index,
+                          size_t num_vertexes) override;
+    void render_triangles(vertex_buffer<vertex2d_colored_textured>* vertexes,
+                          index_buffer*                             indexes,
+                          const texture*                            tex,
+                          const std::uint16_t* start_vertex_index,
+                          size_t               num_vertexes) override;
+
+    void swap_buffers() override;
+
+    std::shared_ptr<texture> load_texture(uint32_t    index,
+                                          const char* path) override;
+    texture_source           read_texture(const char* path) const override;
+    std::shared_ptr<texture> load_texture(uint32_t         index,
+                                          texture_source&& source) override;
+    resource_cache_stats     get_texture_cache_stats() const override;
+    bool                     reload_texture(texture_source&& source) override;
+
+    void set_texture(uint32_t index) override;
+    void set_uniform(const uniform& uni) override;
+    void set_shader(shader* shader) override;
+    void set_relative_mouse_mode(bool state) override;
+    void set_shader_features(uint32_t features) override;
+
+    void play_sound(const char* path,
+                    bool        is_looped,
+                    uint8_t     priority) override;
+    void stop_sound(const char*) override {}
+    void set_sound_volume(const char*, float) override {}
+    void preload_sound(const char*, bool) override {}
+    audio_stats get_audio_stats() const override { return {}; }
+
+    void reload_uniform() override;
+
+    void capture_frame(const char* path) override;
+
+    // No GPU, passes are never timed
+    void set_gpu_timing(bool) override {}
+    void begin_gpu_pass(gpu_pass) override {}
+    void end_gpu_pass(gpu_pass) override {}
+    bool get_gpu_pass_ms(gpu_pass, float&) const override { return false; }
+
+    size_t get_texture_bytes() const override { return 0; }
+    bool   has_32bit_indexes() const override { return true; }
+    float  get_fence_wait_ms() const override { return 0.f; }
+
+    void  begin_scene() override {}
+    void  end_scene() override {}
+    float get_resolution_scale() const override { return 1.f; }
+
+    // Last completed frame, RGBA8 rows from top to bottom
+    const uint32_t* get_pixels() const { return front_buffer.data(); }
+    uint32_t        get_width() const { return width; }
+    uint32_t        get_height() const { return height; }
+    void            save_frame(const char* path) const;
+
+    // Triangles rasterized during the last completed frame
+    size_t get_triangles_drawn() const { return triangles_drawn; }
+
+    struct raster_vertex
+    {
+        float x, y, z, w;  // clip space
+        float varyings[8]; // 3d: world position, normal, uv; 2d: color, uv
+    };
+
+    struct draw_state
+    {
+        const texture_software* tex = nullptr;
+        vector3d                camera_pos;
+        uint32_t                features = 0; // shader_feature, 3D only
+        bool                    is_2d    = false;
+    };
+
+    struct triangle_setup
+    {
+        float    x[3], y[3]; // screen space
+        float    z[3];       // window depth
+        float    inv_w[3];
+        uint32_t v[3];
+        uint32_t state;
+        int      min_x, min_y, max_x, max_y;
+        float    inv_area;
+        bool     front_facing;
+    };
+
+private:
+    template <class vertex_type, class index_type>
+    void submit(const vertex_type* vertexes,
+                const index_type*  indexes,
+                size_t             num_indexes,
+                const texture*     tex);
+    template <class vertex_type>
+    void submit_buffer(const vertex_type*  vertexes,
+                       const index_buffer* indexes,
+                       const uint16_t*     start_vertex_index,
+                       size_t              num_indexes,
+                       const texture*      tex);
+
+    void clip_and_add(const raster_vertex& a,
+                      const raster_vertex& b,
+                      const raster_vertex& c,
+                      uint32_t             state);
+    void add_triangle(const raster_vertex& a,
+                      const raster_vertex& b,
+                      const raster_vertex& c,
+                      uint32_t             state);
+    void render_imgui();
+    void flush();
+    void rasterize_tile(size_t tile_index);
+    void clear();
+
+    void parallel_for(size_t count, const std::function<void(size_t)>& func);
+
+    static constexpr int tile_size = 64;
+
+    uint32_t width   = 0;
+    uint32_t height  = 0;
+    int      tiles_x = 0;
+    int      tiles_y = 0;
+
+    std::vector<uint32_t> color_buffer;
+    std::vector<float>    depth_buffer;
+    std::vector<uint32_t> front_buffer;
+
+    std::vector<raster_vertex>         vertexes;
+    std::vector<triangle_setup>        triangles;
+    std::vector<draw_state>            states;
+    std::vector<std::vector<uint32_t>> bins;
+    std::vector<vertex3d_textured>     unpacked; // Packed draws, grows only
+
+    size_t   triangles_drawn = 0;
+    uniform  uniforms_world;
+    shader*  active_shader    = nullptr;
+    uint32_t allowed_features = ~0u; // config::quality
+    uint32_t shader_features  = ~0u; // Capped by allowed_features
+
+    std::unique_ptr<thread_pool> workers;
+    texture_software*            font_texture = nullptr;
+    std::string                  capture_path;
+    resource_cache<texture>      textures;
+
+    std::chrono::steady_clock::time_point last_frame;
+};
@@ -0,0 +1,125 @@
+#include "gpu_timer_opengl.h"
+
+#include <cstring>
+#include <iostream>
+
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+static bool has_extension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        auto extension = reinterpret_cast<const char*>(
+            glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension != nullptr && std::strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool gpu_timer_opengl::initialize(load_func load)
+{
+    supported = false;
+    if (!has_extension("GL_EXT_disjoint_timer_query"))
+    {
+        std::cout << "gpu timer: GL_EXT_disjoint_timer_query is not supported"
+                  << std::endl;
+        return false;
+    }
+
+    get_query_result = reinterpret_cast<get_query_object_ui64v>(
+        load("glGetQueryObjectui64vEXT"));
+    if (get_query_result == nullptr)
+        return false;
+
+    for (auto& frame_queries : queries)
+        for (query& q : frame_queries)
+            glGenQueries(1, &q.id);
+
+    supported = true;
+    return true;
+}
+
+void gpu_timer_opengl::uninitialize()
+{
+    if (!supported)
+        return;
+
+    for (auto& frame_queries : queries)
+        for (query& q : frame_queries)
+            glDeleteQueries(1, &q.id);
+    supported = false;
+}
+
+void gpu_timer_opengl::read_result(query& q, size_t pass)
+{
+    GLuint available = 0;
+    glGetQueryObjectuiv(q.id, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return;
+
+    GLuint64 nanoseconds = 0;
+    get_query_result(q.id, GL_QUERY_RESULT, &nanoseconds);
+
+    pass_ms[pass]    = static_cast<float>(nanoseconds) / 1e6f;
+    has_result[pass] = true;
+    q.is_pending     = false;
+}
+
+void gpu_timer_opengl::begin(gpu_pass pass)
+{
+    const auto p = static_cast<size_t>(pass);
+    query&     q = queries[frame % latency][p];
+
+    if (q.is_pending)
+        read_result(q, p);
+    // Still in flight, skip this frame instead of waiting for it
+    if (q.is_pending)
+        return;
+
+    glBeginQuery(GL_TIME_ELAPSED_EXT, q.id);
+    q.is_pending = true;
+    is_active[p] = true;
+}
+
+void gpu_timer_opengl::end(gpu_pass pass)
+{
+    const auto p = static_cast<size_t>(pass);
+    if (!is_active[p])
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED_EXT);
+    is_active[p] = false;
+}
+
+void gpu_timer_opengl::next_frame()
+{
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (disjoint)
+    {
+        // Timings of every query in flight are meaningless now
+        for (auto& frame_queries : queries)
+            for (query& q : frame_queries)
+                q.is_pending = false;
+        has_result.fill(false);
+    }
+    frame++;
+}
+
+bool gpu_timer_opengl::get_ms(gpu_pass pass, float& ms) const
+{
+    const auto p = static_cast<size_t>(pass);
+    if (!supported || !has_result[p])
+        return false;
+
+    ms = pass_ms[p];
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "engine.h"
+
+#include <glad/glad.h>
+
+#include <array>
+
+// Pass timings through GL_EXT_disjoint_timer_query. glad is generated without
+// the extension, so its 64 bit query getter is loaded here. Queries are read
+// back latency frames later to never stall the pipeline.
+class gpu_timer_opengl
+{
+public:
+    using load_func = void* (*)(const char* name);
+
+    bool initialize(load_func load);
+    void uninitialize();
+    bool is_supported() const { return supported; }
+
+    void begin(gpu_pass pass);
+    void end(gpu_pass pass);
+    // Call after swap, drops the results if the GPU reported a disjoint
+    void next_frame();
+
+    bool get_ms(gpu_pass pass, float& ms) const;
+
+private:
+    static constexpr size_t latency = 3;
+    static constexpr size_t passes  = static_cast<size_t>(gpu_pass::count);
+
+    struct query
+    {
+        GLuint id         = 0;
+        bool   is_pending = false;
+    };
+
+    void read_result(query& q, size_t pass);
+
+    using get_query_object_ui64v = void(APIENTRYP)(GLuint, GLenum, GLuint64*);
+    get_query_object_ui64v get_query_result = nullptr;
+
+    bool supported = false;
+
+    std::array<std::array<query, passes>, latency> queries;
+    std::array<float, passes>                      pass_ms{};
+    std::array<bool, passes>                       has_result{};
+    std::array<bool, passes>                       is_active{};
+    size_t                                         frame = 0;
+};
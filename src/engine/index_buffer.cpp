@@ -1,21 +1,52 @@
 #include "index_buffer.h"
 #include "glad/glad.h"
+#include "stream_buffer_opengl.h"
 
-index_buffer::index_buffer(const uint16_t* i, size_t n)
-    : count(n)
+static void upload(std::uint32_t& gl_handle, const void* i, size_t bytes)
 {
     glGenBuffers(1, &gl_handle);
     GL_CHECK_ERRORS();
 
-    bind();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gl_handle);
+    GL_CHECK_ERRORS();
 
-    GLsizeiptr size_in_bytes = n * sizeof(std::uint16_t);
+    GLsizeiptr size_in_bytes = static_cast<GLsizeiptr>(bytes);
 
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, size_in_bytes, i, GL_STATIC_DRAW);
     GL_CHECK_ERRORS();
 }
+
+static bool push_stream(buffer_usage   usage,
+                        const void*    i,
+                        size_t         bytes,
+                        std::uint32_t& gl_handle,
+                        size_t&        offset)
+{
+    stream_buffer_opengl* stream = stream_buffer_opengl::get_current();
+    return usage == buffer_usage::stream && stream != nullptr &&
+           stream->push_indexes(i, bytes, gl_handle, offset);
+}
+
+index_buffer::index_buffer(const uint16_t* i, size_t n, buffer_usage usage)
+    : count(static_cast<std::uint32_t>(n))
+    , index_size(sizeof(std::uint16_t))
+{
+    is_owner = !push_stream(usage, i, n * index_size, gl_handle, offset);
+    if (is_owner)
+        upload(gl_handle, i, n * index_size);
+}
+index_buffer::index_buffer(const uint32_t* i, size_t n, buffer_usage usage)
+    : count(static_cast<std::uint32_t>(n))
+    , index_size(sizeof(std::uint32_t))
+{
+    is_owner = !push_stream(usage, i, n * index_size, gl_handle, offset);
+    if (is_owner)
+        upload(gl_handle, i, n * index_size);
+}
 index_buffer::~index_buffer()
 {
+    if (!is_owner)
+        return;
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     GL_CHECK_ERRORS()
     glDeleteBuffers(1, &gl_handle);
@@ -27,7 +58,7 @@ void index_buffer::bind() const
     GL_CHECK_ERRORS();
 }
 
-std::uint16_t index_buffer::size() const
+std::uint32_t index_buffer::size() const
 {
     return count;
 }
@@ -1,17 +1,40 @@
+#pragma once
 #include "core/types.h"
 
 #include <cassert>
 #include <iostream>
+#include <vector>
 
 class index_buffer
 {
 public:
-    index_buffer(const uint16_t* i, size_t n);
+    index_buffer(const uint16_t* i,
+                 size_t          n,
+                 buffer_usage    usage = buffer_usage::static_draw);
+    // Needs engine::has_32bit_indexes()
+    index_buffer(const uint32_t* i,
+                 size_t          n,
+                 buffer_usage    usage = buffer_usage::static_draw);
     ~index_buffer();
     void          bind() const;
-    std::uint16_t size() const;
+    std::uint32_t size() const;
+
+    bool   is_32bit() const { return index_size == sizeof(std::uint32_t); }
+    size_t get_index_size() const { return index_size; }
+    // Byte offset of the first index in the bound GL buffer
+    size_t get_offset() const { return offset; }
+
+    // System memory copies, only kept by the software backend
+    const std::uint16_t* data() const { return indexes.data(); }
+    const std::uint32_t* data32() const { return indexes32.data(); }
 
 private:
     std::uint32_t gl_handle;
-    std::uint16_t count;
+    std::uint32_t count;
+    size_t        index_size;
+    size_t        offset   = 0;
+    bool          is_owner = true;
+
+    std::vector<std::uint16_t> indexes;
+    std::vector<std::uint32_t> indexes32;
 };
@@ -0,0 +1,29 @@
+#include "index_buffer.h"
+
+// Software backend counterpart of index_buffer.cpp, keeps indexes in system
+// memory instead of a GL buffer object
+
+index_buffer::index_buffer(const uint16_t* i, size_t n, buffer_usage)
+    : gl_handle(0)
+    , count(static_cast<std::uint32_t>(n))
+    , index_size(sizeof(std::uint16_t))
+    , indexes(i, i + n)
+{
+}
+
+index_buffer::index_buffer(const uint32_t* i, size_t n, buffer_usage)
+    : gl_handle(0)
+    , count(static_cast<std::uint32_t>(n))
+    , index_size(sizeof(std::uint32_t))
+    , indexes32(i, i + n)
+{
+}
+
+index_buffer::~index_buffer() {}
+
+void index_buffer::bind() const {}
+
+std::uint32_t index_buffer::size() const
+{
+    return count;
+}
@@ -0,0 +1,224 @@
+#include "music_stream.h"
+#include "core/asset_pack.h"
+#include "core/trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// Source frames per chunk, about 85 ms at 48 kHz
+static constexpr uint32_t chunk_frames = 4096;
+
+music_stream::music_stream(const char*          path,
+                           const SDL_AudioSpec& output_spec,
+                           bool                 is_looped)
+    : output(output_spec)
+    , output_frame_bytes(SDL_AUDIO_BITSIZE(output_spec.format) / 8 *
+                         output_spec.channels)
+    , is_looped(is_looped)
+{
+    file = open_asset(path);
+    if (file == nullptr)
+        throw std::runtime_error(std::string("can't open audio file: ") + path);
+
+    try
+    {
+        parse_header(path);
+    }
+    catch (...)
+    {
+        file->close(file);
+        throw;
+    }
+
+    chunk.resize(size_t(chunk_frames) * source.frame_bytes);
+    std::cout << "music: streaming " << path << ", " << source.freq
+              << " Hz, " << int(source.channels) << " channels, "
+              << data_size / 1024 << " KiB of data through a "
+              << ring_bytes / 1024 << " KiB ring" << std::endl;
+
+    decoder = std::thread(&music_stream::run, this);
+}
+
+music_stream::~music_stream()
+{
+    is_running = false;
+    decoder.join();
+    file->close(file);
+}
+
+void music_stream::parse_header(const char* path)
+{
+    auto read_exact = [this, path](void* dst, size_t size)
+    {
+        if (file->read(file, dst, size) != size)
+            throw std::runtime_error(std::string("truncated wav: ") + path);
+    };
+
+    char riff[12];
+    read_exact(riff, sizeof(riff));
+    if (std::memcmp(riff, "RIFF", 4) != 0 ||
+        std::memcmp(riff + 8, "WAVE", 4) != 0)
+        throw std::runtime_error(std::string("not a wav: ") + path);
+
+    // Chunks other than "fmt " and "data" are skipped
+    uint32_t position = sizeof(riff);
+    for (;;)
+    {
+        char     id[4];
+        uint32_t size = 0;
+        read_exact(id, sizeof(id));
+        read_exact(&size, sizeof(size));
+        position += 8;
+
+        if (std::memcmp(id, "fmt ", 4) == 0)
+        {
+            uint8_t fmt[16];
+            if (size < sizeof(fmt))
+                throw std::runtime_error(std::string("bad wav: ") + path);
+            read_exact(fmt, sizeof(fmt));
+
+            uint16_t tag      = 0;
+            uint16_t channels = 0;
+            uint32_t freq     = 0;
+            uint16_t bits     = 0;
+            std::memcpy(&tag, fmt, 2);
+            std::memcpy(&channels, fmt + 2, 2);
+            std::memcpy(&freq, fmt + 4, 4);
+            std::memcpy(&bits, fmt + 14, 2);
+
+            constexpr uint16_t pcm = 1;
+            constexpr uint16_t ieee_float = 3;
+            if (tag == pcm && bits == 8)
+                source.format = SDL_AUDIO_U8;
+            else if (tag == pcm && bits == 16)
+                source.format = SDL_AUDIO_S16LSB;
+            else if (tag == pcm && bits == 32)
+                source.format = SDL_AUDIO_S32LSB;
+            else if (tag == ieee_float && bits == 32)
+                source.format = SDL_AUDIO_F32LSB;
+            else
+                throw std::runtime_error(
+                    std::string("unsupported wav format: ") + path);
+
+            source.channels    = static_cast<uint8_t>(channels);
+            source.freq        = static_cast<int>(freq);
+            source.frame_bytes = bits / 8u * channels;
+        }
+        else if (std::memcmp(id, "data", 4) == 0)
+        {
+            if (source.frame_bytes == 0)
+                throw std::runtime_error(std::string("bad wav: ") + path);
+            data_offset = position;
+            data_size   = size / source.frame_bytes * source.frame_bytes;
+            return;
+        }
+
+        position += size + (size & 1);
+        if (file->seek(file, position, SDL_RW_SEEK_SET) < 0)
+            throw std::runtime_error(std::string("truncated wav: ") + path);
+    }
+}
+
+// Reads and converts the next chunk into pending, false at the end of a
+// track that does not loop
+bool music_stream::decode_chunk()
+{
+    if (data_read == data_size)
+    {
+        if (!is_looped || data_size == 0)
+            return false;
+        data_read = 0;
+    }
+    if (data_read == 0 && file->seek(file, data_offset, SDL_RW_SEEK_SET) < 0)
+        throw std::runtime_error("can't seek in music");
+
+    const uint32_t size =
+        std::min(static_cast<uint32_t>(chunk.size()), data_size - data_read);
+    uint32_t got = static_cast<uint32_t>(file->read(file, chunk.data(), size));
+    got          = got / source.frame_bytes * source.frame_bytes;
+    if (got < size)
+        data_size = data_read + got; // Shorter than its header says
+    data_read += got;
+
+    pending_offset = 0;
+    if (source.format == output.format && source.channels == output.channels &&
+        source.freq == output.freq)
+    {
+        pending.assign(chunk.begin(), chunk.begin() + got);
+        return true;
+    }
+
+    // Chunks are converted on their own. Exact for format and channel
+    // changes, a resampled track may click at chunk edges.
+    Uint8* converted      = nullptr;
+    int    converted_size = 0;
+    if (SDL_ConvertAudioSamples(source.format,
+                                source.channels,
+                                source.freq,
+                                chunk.data(),
+                                static_cast<int>(got),
+                                output.format,
+                                output.channels,
+                                output.freq,
+                                &converted,
+                                &converted_size) != 0)
+    {
+        throw std::runtime_error(std::string("can't convert music: ") +
+                                 SDL_GetError());
+    }
+    pending.assign(converted, converted + converted_size);
+    SDL_free(converted);
+    return true;
+}
+
+void music_stream::run()
+{
+    TRACE_THREAD_NAME("music");
+    try
+    {
+        while (is_running)
+        {
+            if (pending_offset == pending.size())
+            {
+                if (!decode_chunk())
+                    break;
+                continue;
+            }
+
+            // Whole frames only, read() takes whole frames too
+            const size_t room =
+                (ring_bytes - ring.size()) / output_frame_bytes *
+                output_frame_bytes;
+            const size_t count =
+                std::min(room, pending.size() - pending_offset);
+            if (count == 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                continue;
+            }
+            pending_offset += ring.push(pending.data() + pending_offset, count);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "music: " << e.what() << std::endl;
+    }
+    is_decoded = true;
+}
+
+uint32_t music_stream::read(uint8_t* out, uint32_t size)
+{
+    const size_t wanted    = size / output_frame_bytes * output_frame_bytes;
+    const size_t available = ring.size() / output_frame_bytes *
+                             output_frame_bytes;
+    return static_cast<uint32_t>(ring.pop(out, std::min(wanted, available)));
+}
+
+bool music_stream::is_finished() const
+{
+    return is_decoded && ring.empty();
+}
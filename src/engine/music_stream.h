@@ -0,0 +1,73 @@
+#pragma once
+#include "core/spsc_queue.h"
+
+#include "SDL3/SDL.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// A wav track decoded while it plays. A thread of its own reads and
+// converts it chunk by chunk into a fixed ring that the mixer pulls from,
+// so the resident size does not depend on the track length. Looping rereads
+// the data from its start with no gap in the ring.
+class music_stream
+{
+public:
+    // Mixer format bytes, about 0.7 s of 48 kHz float stereo
+    static constexpr size_t ring_bytes = 256 * 1024;
+
+    // Throws when the file is missing or not a PCM/float wav
+    music_stream(const char*          path,
+                 const SDL_AudioSpec& output_spec,
+                 bool                 is_looped);
+    ~music_stream();
+
+    music_stream(const music_stream&)            = delete;
+    music_stream& operator=(const music_stream&) = delete;
+
+    // Audio thread: copies whole frames, up to size bytes, and returns the
+    // count. Fewer than asked means the track ended or the decoder fell
+    // behind.
+    uint32_t read(uint8_t* out, uint32_t size);
+
+    // Played to the end, never for a looped track
+    bool is_finished() const;
+    // Share of the ring decoded ahead, 0 to 1
+    float get_fill() const { return float(ring.size()) / ring_bytes; }
+
+private:
+    struct source_format
+    {
+        SDL_AudioFormat format      = 0;
+        uint8_t         channels    = 0;
+        int             freq        = 0;
+        uint32_t        frame_bytes = 0;
+    };
+
+    void parse_header(const char* path);
+    bool decode_chunk();
+    void run();
+
+    SDL_RWops*    file = nullptr;
+    source_format source;
+    uint32_t      data_offset = 0; // The "data" chunk
+    uint32_t      data_size   = 0;
+    uint32_t      data_read   = 0;
+
+    SDL_AudioSpec output;
+    uint32_t      output_frame_bytes = 0;
+    bool          is_looped          = false;
+
+    // Decoder thread only
+    std::vector<uint8_t> chunk;
+    std::vector<uint8_t> pending;
+    size_t               pending_offset = 0;
+
+    spsc_queue<uint8_t, ring_bytes> ring;
+    std::atomic<bool>               is_running{ true };
+    std::atomic<bool>               is_decoded{ false };
+    std::thread                     decoder;
+};
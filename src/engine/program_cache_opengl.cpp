@@ -0,0 +1,194 @@
+#include "program_cache_opengl.h"
+#include "core/trace.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+constexpr uint32_t cache_magic = 0x50443354; // "T3DP"
+
+struct cache_header
+{
+    uint32_t magic  = cache_magic;
+    uint32_t format = 0;
+    uint64_t key    = 0;
+    uint32_t size   = 0;
+    uint32_t unused = 0;
+};
+
+// FNV-1a, stable across runs and platforms unlike std::hash
+uint64_t hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t hash_string(uint64_t hash, const char* str)
+{
+    if (str == nullptr)
+        return hash;
+    // Keep the terminator so "ab" + "c" differs from "a" + "bc"
+    return hash_bytes(hash, str, std::char_traits<char>::length(str) + 1);
+}
+} // namespace
+
+bool program_cache_opengl::initialize(const char* _directory)
+{
+    enabled = false;
+    if (_directory == nullptr || !GLAD_GL_ES_VERSION_3_0)
+        return false;
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0)
+    {
+        std::cout << "program cache: driver has no program binary formats"
+                  << std::endl;
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(_directory, error);
+    if (error)
+    {
+        std::cerr << "program cache: can't create " << _directory << ": "
+                  << error.message() << std::endl;
+        return false;
+    }
+
+    driver_hash = 0xcbf29ce484222325ull;
+    for (GLenum name :
+         { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION })
+    {
+        driver_hash = hash_string(
+            driver_hash, reinterpret_cast<const char*>(glGetString(name)));
+    }
+
+    directory = _directory;
+    enabled   = true;
+    return true;
+}
+
+uint64_t program_cache_opengl::make_key(
+    const std::string& vertex_source, const std::string& fragment_source) const
+{
+    uint64_t key = driver_hash;
+    key          = hash_string(key, vertex_source.c_str());
+    key          = hash_string(key, fragment_source.c_str());
+    return key;
+}
+
+void program_cache_opengl::prepare(GLuint program) const
+{
+    if (!enabled)
+        return;
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+bool program_cache_opengl::load(GLuint program, uint64_t key)
+{
+    if (!enabled)
+        return false;
+
+    TRACE_ZONE("program_cache_opengl::load");
+
+    const std::string path = get_path(key);
+    std::ifstream     file(path, std::ios::binary);
+    cache_header      header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != cache_magic || header.key != key)
+    {
+        misses++;
+        return false;
+    }
+
+    std::vector<char> binary(header.size);
+    if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size())))
+    {
+        misses++;
+        return false;
+    }
+
+    glProgramBinary(program,
+                    header.format,
+                    binary.data(),
+                    static_cast<GLsizei>(binary.size()));
+    // A stale format raises GL_INVALID_ENUM, that is an ordinary miss here
+    while (glGetError() != GL_NO_ERROR)
+    {
+    }
+
+    GLint is_linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &is_linked);
+    if (is_linked == GL_FALSE)
+    {
+        std::cout << "program cache: driver rejected " << path << std::endl;
+        std::remove(path.c_str());
+        misses++;
+        return false;
+    }
+
+    hits++;
+    return true;
+}
+
+void program_cache_opengl::save(GLuint program, uint64_t key) const
+{
+    if (!enabled)
+        return;
+
+    TRACE_ZONE("program_cache_opengl::save");
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum            format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+    if (glGetError() != GL_NO_ERROR || length <= 0)
+        return;
+
+    cache_header header;
+    header.format = format;
+    header.key    = key;
+    header.size   = static_cast<uint32_t>(length);
+
+    // Written aside and renamed, a crash never leaves a torn entry behind
+    const std::string path = get_path(key);
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        if (!file)
+        {
+            std::cerr << "program cache: can't write " << temp << std::endl;
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    if (error)
+        std::filesystem::remove(temp, error);
+}
+
+std::string program_cache_opengl::get_path(uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name,
+                  sizeof(name),
+                  "%016llx.bin",
+                  static_cast<unsigned long long>(key));
+    return (std::filesystem::path(directory) / name).string();
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+
+// Linked programs kept on disk through glGetProgramBinary. The key hashes
+// both shader sources and the driver strings, so an edited shader or a
+// driver update misses the cache and the program is built from source.
+class program_cache_opengl
+{
+public:
+    // nullptr directory or no binary formats leave the cache disabled
+    bool initialize(const char* directory);
+    bool is_enabled() const { return enabled; }
+
+    uint64_t make_key(const std::string& vertex_source,
+                      const std::string& fragment_source) const;
+
+    // Call before glLinkProgram so the driver keeps the binary around
+    void prepare(GLuint program) const;
+    // False on a miss or when the driver rejects the stored binary
+    bool load(GLuint program, uint64_t key);
+    void save(GLuint program, uint64_t key) const;
+
+    size_t get_hits() const { return hits; }
+    size_t get_misses() const { return misses; }
+
+private:
+    std::string get_path(uint64_t key) const;
+
+    std::string directory;
+    uint64_t    driver_hash = 0;
+    bool        enabled     = false;
+    size_t      hits        = 0;
+    size_t      misses      = 0;
+};
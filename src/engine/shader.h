@@ -1,4 +1,33 @@
 #pragma once
+#include "core/config.h"
+
+#include <cstdint>
+
+// Bits of a scene shader permutation, each one is a #define of the source
+namespace shader_feature
+{
+constexpr uint32_t lighting    = 1u << 0; // LIGHTING, unlit without it
+constexpr uint32_t attenuation = 1u << 1; // ATTENUATION by light distance
+constexpr uint32_t specular    = 1u << 2; // SPECULAR highlight
+constexpr uint32_t count       = 3;
+
+// What config::quality leaves of the features a material asks for
+inline uint32_t get_allowed(shader_quality quality)
+{
+    switch (quality)
+    {
+        case shader_quality::low:
+            return 0;
+        case shader_quality::medium:
+            return lighting;
+        case shader_quality::high:
+            return lighting | attenuation;
+        case shader_quality::ultra:
+            break;
+    }
+    return ~0u;
+}
+} // namespace shader_feature
 
 class shader
 {
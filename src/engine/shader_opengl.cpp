@@ -1,42 +1,57 @@
 #include "shader_opengl.h"
+#include "core/asset_pack.h"
+#include "core/trace.h"
 #include "glad/glad.h"
+#include "program_cache_opengl.h"
 
 #include <cassert>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
-shader_opengl::shader_opengl(const char* path_to_vertex,
-                             const char* path_to_fragment)
-{
-    this->path_to_vertex   = path_to_vertex;
-    this->path_to_fragment = path_to_fragment;
+static program_cache_opengl* program_cache = nullptr;
 
-    program = glCreateProgram();
-    GL_CHECK_ERRORS()
-
-    load(path_to_vertex, GL_VERTEX_SHADER);
-    load(path_to_fragment, GL_FRAGMENT_SHADER);
+static std::string read_file(const char* path)
+{
+    membuff          storage;
+    const asset_view file = load_asset(path, storage);
+    return std::string(reinterpret_cast<const char*>(file.data), file.size);
+}
 
-    glLinkProgram(program);
-    GL_CHECK_ERRORS()
+shader_opengl::source shader_opengl::read_source(const char* path_to_vertex,
+                                                 const char* path_to_fragment)
+{
+    TRACE_ZONE("shader_opengl::read_source");
+    return { read_file(path_to_vertex), read_file(path_to_fragment) };
+}
 
-    GLint isLinked = 0;
-    glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
-    if (isLinked == GL_FALSE)
-    {
-        GLint maxLength = 0;
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
+void shader_opengl::set_program_cache(program_cache_opengl* cache)
+{
+    program_cache = cache;
+}
 
-        std::vector<GLchar> infoLog(maxLength);
-        glGetProgramInfoLog(program, maxLength, &maxLength, &infoLog[0]);
+shader_opengl::shader_opengl(const char* path_to_vertex,
+                             const char* path_to_fragment)
+    : shader_opengl(path_to_vertex,
+                    path_to_fragment,
+                    read_source(path_to_vertex, path_to_fragment))
+{
+}
 
-        glDeleteProgram(program);
+shader_opengl::shader_opengl(const char*        path_to_vertex,
+                             const char*        path_to_fragment,
+                             const source&      src,
+                             const std::string& defines)
+{
+    this->path_to_vertex   = path_to_vertex;
+    this->path_to_fragment = path_to_fragment;
+    this->defines          = defines;
 
-        throw std::runtime_error(infoLog.data());
-    }
+    build(src);
 
     glBindAttribLocation(program, 0, "i_position");
     GL_CHECK_ERRORS()
@@ -62,25 +77,110 @@ void shader_opengl::use() const
 
 void shader_opengl::reload()
 {
-    glDeleteProgram(program);
+    reload(read_source(path_to_vertex, path_to_fragment));
+}
+
+void shader_opengl::reload(const source& src)
+{
+    // Built aside, a source that fails to compile keeps the old program
+    const GLuint previous = program;
+    try
+    {
+        build(src);
+    }
+    catch (...)
+    {
+        program = previous;
+        throw;
+    }
+    glDeleteProgram(previous);
     GL_CHECK_ERRORS()
 
+    use();
+}
+
+void shader_opengl::swap_program(shader_opengl& other)
+{
+    std::swap(program, other.program);
+}
+
+std::string shader_opengl::add_defines(const std::string& src,
+                                       const std::string& defines)
+{
+    if (defines.empty())
+        return src;
+
+    // GLSL wants #version first, everything else goes after it
+    size_t position = 0;
+    if (src.compare(0, 8, "#version") == 0)
+    {
+        position = src.find('\n');
+        position = position == std::string::npos ? src.size() : position + 1;
+    }
+    std::string result = src.substr(0, position);
+    if (!result.empty() && result.back() != '\n')
+        result += '\n';
+    return result + defines + src.substr(position);
+}
+
+void shader_opengl::build(const source& original)
+{
+    TRACE_ZONE("shader_opengl::build");
+
+    const source src = { add_defines(original.vertex, defines),
+                         add_defines(original.fragment, defines) };
+
     program = glCreateProgram();
     GL_CHECK_ERRORS()
 
-    load(path_to_vertex, GL_VERTEX_SHADER);
-    load(path_to_fragment, GL_FRAGMENT_SHADER);
+    uint64_t key = 0;
+    if (program_cache != nullptr)
+    {
+        key = program_cache->make_key(src.vertex, src.fragment);
+        if (program_cache->load(program, key))
+            return;
+        program_cache->prepare(program);
+    }
 
-    glLinkProgram(program);
-    GL_CHECK_ERRORS()
+    try
+    {
+        compile(src.vertex, GL_VERTEX_SHADER);
+        compile(src.fragment, GL_FRAGMENT_SHADER);
 
-    use();
+        glLinkProgram(program);
+        GL_CHECK_ERRORS()
+
+        GLint isLinked = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+        if (isLinked == GL_FALSE)
+        {
+            GLint maxLength = 0;
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
+
+            std::vector<GLchar> infoLog(maxLength);
+            glGetProgramInfoLog(program, maxLength, &maxLength, &infoLog[0]);
+
+            throw std::runtime_error(infoLog.data());
+        }
+    }
+    catch (...)
+    {
+        glDeleteProgram(program);
+        throw;
+    }
+
+    if (program_cache != nullptr)
+        program_cache->save(program, key);
 }
 
 void shader_opengl::load(const char* path, int type)
 {
-    membuff*    file     = load_file_to_memory(path);
-    const char* c_buffer = file->ptr.get();
+    compile(read_file(path), type);
+}
+
+void shader_opengl::compile(const std::string& src, int type)
+{
+    const char* c_buffer = src.c_str();
 
     GLuint shader = glCreateShader(type);
     GL_CHECK_ERRORS()
@@ -106,8 +206,6 @@ void shader_opengl::load(const char* path, int type)
         glDeleteShader(shader);
         GL_CHECK_ERRORS()
 
-        //delete file;
-
         throw std::runtime_error(log.data());
     }
     glAttachShader(program, shader);
@@ -115,8 +213,6 @@ void shader_opengl::load(const char* path, int type)
 
     glDeleteShader(shader);
     GL_CHECK_ERRORS()
-
-    //delete file;
 }
 
 void shader_opengl::set_uniform1(const char* name, int value)
@@ -2,16 +2,43 @@
 #include "core/types.h"
 #include "shader.h"
 
+#include <string>
+
+class program_cache_opengl;
+
 class shader_opengl : public shader
 {
 public:
+    struct source
+    {
+        std::string vertex;
+        std::string fragment;
+    };
+
+    // No GL calls, safe to run on a loader thread while the context is busy
+    static source read_source(const char* path_to_vertex,
+                              const char* path_to_fragment);
+    // Programs are looked up here before compiling, nullptr disables it
+    static void set_program_cache(program_cache_opengl* cache);
+
     shader_opengl(const char* path_to_vertex, const char* path_to_fragment);
+    // defines, e.g. "#define LIGHTING\n", go right after the #version line
+    // of both stages and are kept for reload()
+    shader_opengl(const char*        path_to_vertex,
+                  const char*        path_to_fragment,
+                  const source&      src,
+                  const std::string& defines = "");
     ~shader_opengl();
 
     uint32_t get_program_id() const;
 
     void use() const override;
     void reload() override;
+    // Rebuilds from src with the same defines, throws and keeps the current
+    // program when it does not compile
+    void reload(const source& src);
+    // For all-or-nothing reloads of several programs
+    void swap_program(shader_opengl& other);
 
     void set_uniform1(const char* name, int value) override;
     void set_uniform1(const char* name, uint32_t value) override;
@@ -83,9 +110,15 @@ public:
 
 private:
     void load(const char* path, int type) override;
+    void compile(const std::string& src, int type);
+    void build(const source& src);
+
+    static std::string add_defines(const std::string& src,
+                                   const std::string& defines);
 
     const char* path_to_vertex;
     const char* path_to_fragment;
+    std::string defines;
 
     uint32_t program;
 };
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "shader_permutations_opengl.h"
+#include "core/trace.h"
+
+#include <iostream>
+#include <memory>
+
+shader_permutations_opengl::shader_permutations_opengl(
+    const char*                  path_to_vertex,
+    const char*                  path_to_fragment,
+    const shader_opengl::source& src)
+    : path_to_vertex(path_to_vertex)
+    , path_to_fragment(path_to_fragment)
+    , source(src)
+{
+}
+
+shader_permutations_opengl::~shader_permutations_opengl()
+{
+    for (shader_opengl* program : programs)
+        delete program;
+}
+
+void shader_permutations_opengl::set_quality(shader_quality quality)
+{
+    allowed = shader_feature::get_allowed(quality);
+}
+
+shader* shader_permutations_opengl::get(uint32_t features)
+{
+    const uint32_t key = normalize(features & allowed);
+    if (programs[key] == nullptr)
+    {
+        TRACE_ZONE("shader_permutations_opengl::build");
+        programs[key] = new shader_opengl(
+            path_to_vertex, path_to_fragment, source, make_defines(key));
+    }
+    return programs[key];
+}
+
+void shader_permutations_opengl::prewarm()
+{
+    TRACE_ZONE("shader_permutations_opengl::prewarm");
+
+    // All of them, not only the allowed ones, so a quality change in game
+    // does not stall either
+    size_t built = 0;
+    for (uint32_t features = 0; features < permutations; features++)
+    {
+        if (normalize(features) != features || programs[features] != nullptr)
+            continue;
+        programs[features] = new shader_opengl(
+            path_to_vertex, path_to_fragment, source, make_defines(features));
+        built++;
+    }
+    std::cout << "shader permutations: prewarmed " << built << " of "
+              << path_to_fragment << std::endl;
+}
+
+void shader_permutations_opengl::reload()
+{
+    reload(shader_opengl::read_source(path_to_vertex, path_to_fragment));
+}
+
+void shader_permutations_opengl::reload(const shader_opengl::source& src)
+{
+    TRACE_ZONE("shader_permutations_opengl::reload");
+
+    std::array<std::unique_ptr<shader_opengl>, permutations> rebuilt;
+    for (uint32_t features = 0; features < permutations; features++)
+    {
+        if (programs[features] != nullptr)
+            rebuilt[features] = std::make_unique<shader_opengl>(
+                path_to_vertex, path_to_fragment, src, make_defines(features));
+    }
+
+    // Every one compiled, the old programs leave with rebuilt
+    for (uint32_t features = 0; features < permutations; features++)
+    {
+        if (rebuilt[features])
+            programs[features]->swap_program(*rebuilt[features]);
+    }
+    source = src;
+}
+
+uint32_t shader_permutations_opengl::normalize(uint32_t features)
+{
+    // Attenuation and specular only modulate lighting
+    if ((features & shader_feature::lighting) == 0)
+        return 0;
+    return features;
+}
+
+std::string shader_permutations_opengl::make_defines(uint32_t features)
+{
+    std::string defines;
+    if (features & shader_feature::lighting)
+        defines += "#define LIGHTING\n";
+    if (features & shader_feature::attenuation)
+        defines += "#define ATTENUATION\n";
+    if (features & shader_feature::specular)
+        defines += "#define SPECULAR\n";
+    return defines;
+}
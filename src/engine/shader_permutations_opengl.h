@@ -0,0 +1,46 @@
+#pragma once
+#include "core/config.h"
+#include "shader_opengl.h"
+
+#include <array>
+
+// Every feature combination of one vertex/fragment pair, built from a single
+// source with shader_feature defines. A material asks for the features it
+// needs and gets the cheapest program the quality level allows.
+class shader_permutations_opengl
+{
+public:
+    shader_permutations_opengl(const char*                  path_to_vertex,
+                               const char*                  path_to_fragment,
+                               const shader_opengl::source& src);
+    ~shader_permutations_opengl();
+
+    shader_permutations_opengl(const shader_permutations_opengl&) = delete;
+    shader_permutations_opengl& operator=(const shader_permutations_opengl&) =
+        delete;
+
+    void     set_quality(shader_quality quality);
+    uint32_t get_allowed_features() const { return allowed; }
+
+    // Builds on first use, call prewarm() at load to keep that out of frames
+    shader* get(uint32_t features);
+    void    prewarm();
+    void    reload();
+    // Rebuilds every built permutation from src, all or none: a compile
+    // error throws and leaves them as they were. shader pointers handed out
+    // by get() stay valid.
+    void reload(const shader_opengl::source& src);
+
+private:
+    static constexpr size_t permutations = 1u << shader_feature::count;
+
+    static uint32_t    normalize(uint32_t features);
+    static std::string make_defines(uint32_t features);
+
+    const char*           path_to_vertex;
+    const char*           path_to_fragment;
+    shader_opengl::source source;
+    uint32_t              allowed = ~0u;
+
+    std::array<shader_opengl*, permutations> programs{};
+};
@@ -0,0 +1,168 @@
+#include "stream_buffer_opengl.h"
+#include "core/trace.h"
+#include "core/types.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+stream_buffer_opengl* stream_buffer_opengl::current = nullptr;
+
+bool stream_buffer_opengl::initialize(size_t   vertex_bytes,
+                                      size_t   index_bytes,
+                                      uint32_t frames_in_flight)
+{
+    // Fences and unsynchronized mapping are ES 3.0
+    if (!GLAD_GL_ES_VERSION_3_0 || frames_in_flight == 0)
+    {
+        std::cout << "stream buffer: disabled, buffers are created per draw"
+                  << std::endl;
+        return false;
+    }
+
+    fences.assign(frames_in_flight, nullptr);
+    region         = 0;
+    is_region_free = true;
+
+    // 16 keeps every vertex attribute type aligned
+    vertexes = { GL_ARRAY_BUFFER, 0, vertex_bytes, 0, 16 };
+    indexes  = { GL_ELEMENT_ARRAY_BUFFER, 0, index_bytes, 0, 4 };
+    for (stream* s : { &vertexes, &indexes })
+    {
+        glGenBuffers(1, &s->handle);
+        GL_CHECK_ERRORS()
+        glBindBuffer(s->target, s->handle);
+        GL_CHECK_ERRORS()
+        glBufferData(s->target,
+                     static_cast<GLsizeiptr>(s->region_size * fences.size()),
+                     nullptr,
+                     GL_DYNAMIC_DRAW);
+        GL_CHECK_ERRORS()
+        glBindBuffer(s->target, 0);
+        GL_CHECK_ERRORS()
+    }
+
+    std::cout << "stream buffer: " << frames_in_flight
+              << " frames in flight, " << (vertex_bytes + index_bytes) / 1024
+              << " KiB per frame" << std::endl;
+    return true;
+}
+
+void stream_buffer_opengl::uninitialize()
+{
+    for (GLsync& fence : fences)
+    {
+        if (fence != nullptr)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    for (stream* s : { &vertexes, &indexes })
+    {
+        if (s->handle != 0)
+            glDeleteBuffers(1, &s->handle);
+        s->handle = 0;
+    }
+    if (current == this)
+        current = nullptr;
+}
+
+void stream_buffer_opengl::next_frame()
+{
+    if (fences.empty())
+        return;
+
+    GLsync& fence = fences[region];
+    if (fence != nullptr)
+        glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    region         = (region + 1) % fences.size();
+    is_region_free = false;
+    vertexes.used  = 0;
+    indexes.used   = 0;
+    wait_ms        = 0.f;
+}
+
+void stream_buffer_opengl::wait_for_region()
+{
+    is_region_free = true;
+
+    GLsync& fence = fences[region];
+    if (fence == nullptr)
+        return;
+
+    const auto start = std::chrono::steady_clock::now();
+    // The first poll flushes, so the fence is guaranteed to signal
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+    {
+        wait_count++;
+        constexpr GLuint64 timeout_ns = 1000000;
+        do
+        {
+            result = glClientWaitSync(fence, 0, timeout_ns);
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+
+    using ms = std::chrono::duration<float, std::milli>;
+    wait_ms  = ms(std::chrono::steady_clock::now() - start).count();
+    TRACE_COUNTER("fence wait ms", wait_ms);
+}
+
+bool stream_buffer_opengl::push(stream&     s,
+                                const void* data,
+                                size_t      size,
+                                uint32_t&   handle,
+                                size_t&     offset)
+{
+    const size_t start = (s.used + s.alignment - 1) / s.alignment * s.alignment;
+    if (fences.empty() || start + size > s.region_size)
+        return false;
+
+    if (!is_region_free)
+        wait_for_region();
+
+    // Nothing is handed out before the map succeeded, the caller falls back
+    // to a buffer of its own otherwise
+    const size_t position = region * s.region_size + start;
+    if (size != 0)
+    {
+        // The fence already guarantees the GPU is done with this range
+        glBindBuffer(s.target, s.handle);
+        GL_CHECK_ERRORS()
+        void* dst = glMapBufferRange(
+            s.target,
+            static_cast<GLintptr>(position),
+            static_cast<GLsizeiptr>(size),
+            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                GL_MAP_INVALIDATE_RANGE_BIT);
+        if (dst == nullptr)
+            return false;
+        std::memcpy(dst, data, size);
+        glUnmapBuffer(s.target);
+        GL_CHECK_ERRORS()
+    }
+
+    offset = position;
+    handle = s.handle;
+    s.used = start + size;
+    return true;
+}
+
+bool stream_buffer_opengl::push_vertexes(const void* data,
+                                         size_t      size,
+                                         uint32_t&   handle,
+                                         size_t&     offset)
+{
+    return push(vertexes, data, size, handle, offset);
+}
+
+bool stream_buffer_opengl::push_indexes(const void* data,
+                                        size_t      size,
+                                        uint32_t&   handle,
+                                        size_t&     offset)
+{
+    return push(indexes, data, size, handle, offset);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Memory for vertex and index data that lives for one frame, used by
+// buffer_usage::stream buffers instead of creating a GL buffer per draw.
+// Both buffers are split into frames_in_flight regions. A region is fenced
+// when its frame is submitted and rewritten only after the fence signalled,
+// so the CPU fills frame N + 1 while the GPU still reads frame N.
+class stream_buffer_opengl
+{
+public:
+    bool initialize(size_t   vertex_bytes,
+                    size_t   index_bytes,
+                    uint32_t frames_in_flight);
+    void uninitialize();
+
+    // Fences the current region and moves to the next one. The wait for
+    // the GPU happens lazily on the first push of the new frame.
+    void next_frame();
+
+    // Copy into the current region, false when it is full
+    bool push_vertexes(const void* data,
+                       size_t      size,
+                       uint32_t&   handle,
+                       size_t&     offset);
+    bool push_indexes(const void* data,
+                      size_t      size,
+                      uint32_t&   handle,
+                      size_t&     offset);
+
+    // Time the last frame blocked on its fence, and frames that blocked
+    float    get_wait_ms() const { return wait_ms; }
+    uint64_t get_wait_count() const { return wait_count; }
+
+    // Buffers created with buffer_usage::stream go here, nullptr falls
+    // back to a GL buffer per buffer object
+    static stream_buffer_opengl* get_current() { return current; }
+    static void set_current(stream_buffer_opengl* s) { current = s; }
+
+private:
+    struct stream
+    {
+        GLenum target      = 0;
+        GLuint handle      = 0;
+        size_t region_size = 0;
+        size_t used        = 0;
+        size_t alignment   = 0;
+    };
+
+    bool push(stream& s,
+              const void* data,
+              size_t      size,
+              uint32_t&   handle,
+              size_t&     offset);
+    void wait_for_region();
+
+    stream vertexes;
+    stream indexes;
+
+    std::vector<GLsync> fences;
+    size_t              region         = 0;
+    bool                is_region_free = true;
+
+    float    wait_ms    = 0.f;
+    uint64_t wait_count = 0;
+
+    static stream_buffer_opengl* current;
+};
@@ -1,11 +1,30 @@
 #pragma once
+#include "core/texture_container.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
 
 class texture
 {
 public:
     virtual ~texture() = default;
 
-    virtual void     bind() const       = 0;
-    virtual uint32_t get_width() const  = 0;
-    virtual uint32_t get_height() const = 0;
-};
\ No newline at end of file
+    virtual void     bind() const               = 0;
+    virtual uint32_t get_width() const          = 0;
+    virtual uint32_t get_height() const         = 0;
+    virtual size_t   get_resident_bytes() const = 0;
+};
+
+// A texture file decoded in system memory, ready for upload. Holds the
+// converted container when one was found, RGBA8 pixels otherwise.
+struct texture_source
+{
+    std::string            path;
+    bool                   has_container = false;
+    texture_container      container;
+    std::vector<std::byte> pixels;
+    uint32_t               width  = 0;
+    uint32_t               height = 0;
+};
@@ -1,48 +1,118 @@
 #include "texture_opengl.h"
-#include "core/picopng.hxx"
+#include "core/asset_pack.h"
+#include "core/texture_container.h"
+#include "core/trace.h"
 #include "glad/glad.h"
 
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
+#include <iostream>
+#include <string>
 
-void get_pixels_from_png(const char*             path,
-                         std::vector<std::byte>& image,
-                         unsigned long&          w,
-                         unsigned long&          h)
+std::atomic<size_t> texture_opengl::total_bytes{ 0 };
+
+// ETC2 is core in GLES 3, but desktop GL through the ES profile may leave it
+// out of the compressed format list
+bool texture_opengl::is_etc2_supported()
+{
+    static const bool supported = []
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+        std::vector<GLint> formats(static_cast<size_t>(std::max(count, 0)));
+        if (!formats.empty())
+            glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+        return std::find(formats.begin(),
+                         formats.end(),
+                         GL_COMPRESSED_RGB8_ETC2) != formats.end();
+    }();
+    return supported;
+}
+
+// A png saved after its last conversion (hot reload, art iteration) wins
+// over the container. Packed files have no times and are never stale.
+static bool is_container_stale(const char* png, const std::string& container)
 {
-    std::vector<std::byte> png_file_in_memory;
-    membuff*               file = load_file_to_memory(path);
-    png_file_in_memory.resize(file->size);
+    namespace fs = std::filesystem;
+    if (asset_pack::get_current() != nullptr)
+        return false;
+
+    std::error_code ec;
+    const fs::file_time_type png_time = fs::last_write_time(png, ec);
+    if (ec)
+        return false;
+    const fs::file_time_type container_time =
+        fs::last_write_time(container, ec);
+    return !ec && png_time > container_time;
+}
 
-    std::copy(reinterpret_cast<std::byte*>(file->ptr.get()),
-              reinterpret_cast<std::byte*>(file->ptr.get() + file->size),
-              png_file_in_memory.begin());
+texture_source texture_opengl::read_source(const char* path, bool compressed)
+{
+    TRACE_ZONE("texture_opengl::read_source");
 
-    int error = decodePNG(
-        image, w, h, &png_file_in_memory[0], png_file_in_memory.size(), true);
+    // Converted by tools/texture_converter
+    texture_source result;
+    result.path = path;
 
-    if (error != 0)
+    const std::string container_path = get_texture_container_path(path);
+    if (!is_container_stale(path, container_path) &&
+        read_texture_container(
+            container_path.c_str(), compressed, result.container))
     {
-        std::cerr << "error: " << error << std::endl;
-        throw std::runtime_error("can't load texture");
+        result.has_container = true;
+        return result;
     }
+
+    unsigned long w = 0;
+    unsigned long h = 0;
+    get_pixels_from_png(path, result.pixels, w, h);
+    result.width  = static_cast<uint32_t>(w);
+    result.height = static_cast<uint32_t>(h);
+    return result;
 }
+
 texture_opengl::texture_opengl(const char* path)
-    : file_path(path)
+    : texture_opengl(read_source(path, is_etc2_supported()))
 {
+    file_path = path;
+}
 
-    std::vector<std::byte> img;
-    unsigned long          w = 0;
-    unsigned long          h = 0;
-    get_pixels_from_png(path, img, w, h);
+texture_opengl::texture_opengl(texture_source&& source)
+{
+    TRACE_ZONE("texture_opengl::load");
 
-    gen_texture_from_pixels(img.data(), w, h);
-    // delete file;
+    // Uploaded level by level
+    if (source.has_container)
+    {
+        const texture_container& container = source.container;
+        upload_levels(container);
+        std::cout << "texture: "
+                  << get_texture_container_path(source.path.c_str())
+                  << ", "
+                  << (container.chain_format ==
+                              texture_container::format::rgba8
+                          ? "rgba8"
+                          : "etc2")
+                  << ", " << container.levels.size() << " levels, "
+                  << resident_bytes / 1024 << " KiB" << std::endl;
+        return;
+    }
+
+    gen_texture_from_pixels(source.pixels.data(), source.width, source.height);
+
+    // No container, let the driver build the chain
+    glGenerateMipmap(GL_TEXTURE_2D);
+    GL_CHECK_ERRORS()
+    set_mipmap_filtering();
+    track_bytes(resident_bytes / 3); // Chain adds a third of level 0
 }
 
 texture_opengl::texture_opengl(const void*  pixels,
                                const size_t width,
                                const size_t height)
 {
+    TRACE_ZONE("texture_opengl::upload");
     gen_texture_from_pixels(pixels, width, height);
 }
 
@@ -50,6 +120,15 @@ texture_opengl::~texture_opengl()
 {
     glDeleteTextures(1, &handle);
     GL_CHECK_ERRORS()
+    total_bytes -= resident_bytes;
+}
+
+void texture_opengl::swap(texture_opengl& other)
+{
+    std::swap(handle, other.handle);
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(resident_bytes, other.resident_bytes);
 }
 
 void texture_opengl::bind() const
@@ -86,4 +165,86 @@ void texture_opengl::gen_texture_from_pixels(const void*  pixels,
     GL_CHECK_ERRORS()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     GL_CHECK_ERRORS()
+
+    this->width  = static_cast<uint32_t>(width);
+    this->height = static_cast<uint32_t>(height);
+    track_bytes(width * height * 4);
+}
+
+void texture_opengl::upload_levels(const texture_container& container)
+{
+    TRACE_ZONE("texture_opengl::upload_levels");
+
+    glGenTextures(1, &handle);
+    GL_CHECK_ERRORS()
+    glBindTexture(GL_TEXTURE_2D, handle);
+    GL_CHECK_ERRORS()
+
+    GLenum compressed_format = 0;
+    switch (container.chain_format)
+    {
+        case texture_container::format::etc2_rgb8:
+            compressed_format = GL_COMPRESSED_RGB8_ETC2;
+            break;
+        case texture_container::format::etc2_rgba8:
+            compressed_format = GL_COMPRESSED_RGBA8_ETC2_EAC;
+            break;
+        default:
+            break;
+    }
+
+    for (size_t i = 0; i < container.levels.size(); i++)
+    {
+        const texture_container::level& level = container.levels[i];
+        const GLint                     index = static_cast<GLint>(i);
+        if (compressed_format == 0)
+        {
+            glTexImage2D(GL_TEXTURE_2D,
+                         index,
+                         GL_RGBA,
+                         static_cast<GLsizei>(level.width),
+                         static_cast<GLsizei>(level.height),
+                         0,
+                         GL_RGBA,
+                         GL_UNSIGNED_BYTE,
+                         level.data.data());
+        }
+        else
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D,
+                                   index,
+                                   compressed_format,
+                                   static_cast<GLsizei>(level.width),
+                                   static_cast<GLsizei>(level.height),
+                                   0,
+                                   static_cast<GLsizei>(level.data.size()),
+                                   level.data.data());
+        }
+        GL_CHECK_ERRORS()
+        track_bytes(level.data.size());
+    }
+
+    glTexParameteri(GL_TEXTURE_2D,
+                    GL_TEXTURE_MAX_LEVEL,
+                    static_cast<GLint>(container.levels.size() - 1));
+    GL_CHECK_ERRORS()
+    set_mipmap_filtering();
+
+    width  = container.levels[0].width;
+    height = container.levels[0].height;
+}
+
+void texture_opengl::set_mipmap_filtering()
+{
+    glTexParameteri(
+        GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    GL_CHECK_ERRORS()
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    GL_CHECK_ERRORS()
+}
+
+void texture_opengl::track_bytes(size_t bytes)
+{
+    resident_bytes += bytes;
+    total_bytes += bytes;
 }
@@ -1,33 +1,52 @@
 #pragma once
+#include "core/png.h"
 #include "core/types.h"
 #include "texture.h"
 
+#include <atomic>
 #include <vector>
 
-void get_pixels_from_png(const char*             path,
-                         std::vector<std::byte>& image,
-                         unsigned long&          w,
-                         unsigned long&          h);
+struct texture_container;
 
 class texture_opengl : public texture
 {
 public:
     texture_opengl(const char* path);
+    explicit texture_opengl(texture_source&& source);
     texture_opengl(const void* pixels, const size_t width, const size_t height);
     ~texture_opengl() override;
 
+    // Exchanges the GL textures, the path each was loaded by stays
+    void swap(texture_opengl& other);
+
     void bind() const override;
 
     uint32_t get_width() const override { return width; }
     uint32_t get_height() const override { return height; }
+    size_t   get_resident_bytes() const override { return resident_bytes; }
+
+    // GPU memory of all live textures, mip levels included
+    static size_t get_total_bytes() { return total_bytes; }
+
+    // Reads the converted container, ETC2 chain when compressed is set, or
+    // decodes the png without one. No GL calls, safe on any thread.
+    static texture_source read_source(const char* path, bool compressed);
+    // Needs the context, call on the render thread
+    static bool is_etc2_supported();
 
 private:
     void gen_texture_from_pixels(const void*  pixels,
                                  const size_t width,
                                  const size_t height);
+    void upload_levels(const texture_container& container);
+    void set_mipmap_filtering();
+    void track_bytes(size_t bytes);
+
+    const char* file_path      = nullptr;
+    uint32_t    handle         = 0;
+    uint32_t    width          = 0;
+    uint32_t    height         = 0;
+    size_t      resident_bytes = 0;
 
-    const char* file_path;
-    uint32_t    handle = 0;
-    uint32_t    width  = 0;
-    uint32_t    height = 0;
+    static std::atomic<size_t> total_bytes;
 };
\ No newline at end of file
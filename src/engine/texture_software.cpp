@@ -0,0 +1,38 @@
+#include "texture_software.h"
+#include "core/asset_pack.h"
+#include "core/png.h"
+#include "core/trace.h"
+
+#include <cstring>
+#include <string>
+
+texture_software::texture_software(const char* path)
+{
+    TRACE_ZONE("texture_software::load");
+
+    membuff          storage;
+    const asset_view file = load_asset(path, storage);
+
+    png_info info;
+    if (!read_png_info(file.data, file.size, info))
+        throw std::runtime_error("not a png: " + std::string(path));
+
+    // Decoded straight into the texel storage
+    width  = info.width;
+    height = info.height;
+    pixels.resize(static_cast<size_t>(width) * height);
+    decode_png(file.data,
+               file.size,
+               reinterpret_cast<std::byte*>(pixels.data()),
+               pixels.size() * sizeof(uint32_t));
+}
+
+texture_software::texture_software(const void*  pixels_,
+                                   const size_t width_,
+                                   const size_t height_)
+    : width(static_cast<uint32_t>(width_))
+    , height(static_cast<uint32_t>(height_))
+{
+    pixels.resize(static_cast<size_t>(width) * height);
+    std::memcpy(pixels.data(), pixels_, pixels.size() * sizeof(uint32_t));
+}
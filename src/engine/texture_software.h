@@ -0,0 +1,52 @@
+#pragma once
+#include "core/types.h"
+#include "texture.h"
+
+#include <utility>
+#include <vector>
+
+// RGBA8 texture kept in system memory for engine_software
+class texture_software : public texture
+{
+public:
+    texture_software(const char* path);
+    texture_software(const void*  pixels,
+                     const size_t width,
+                     const size_t height);
+
+    // Exchanges the texels, for reloads in place
+    void swap(texture_software& other)
+    {
+        pixels.swap(other.pixels);
+        std::swap(width, other.width);
+        std::swap(height, other.height);
+    }
+
+    void bind() const override {}
+
+    uint32_t get_width() const override { return width; }
+    uint32_t get_height() const override { return height; }
+    size_t   get_resident_bytes() const override
+    {
+        return pixels.size() * sizeof(uint32_t);
+    }
+
+    // Nearest sampling with GL_REPEAT wrapping, returns packed RGBA8
+    uint32_t sample(float u, float v) const
+    {
+        float fu = u - std::floor(u);
+        float fv = v - std::floor(v);
+        auto  x  = static_cast<uint32_t>(fu * width);
+        auto  y  = static_cast<uint32_t>(fv * height);
+        if (x >= width)
+            x = width - 1;
+        if (y >= height)
+            y = height - 1;
+        return pixels[y * width + x];
+    }
+
+private:
+    std::vector<uint32_t> pixels;
+    uint32_t              width  = 0;
+    uint32_t              height = 0;
+};
@@ -1,5 +1,6 @@
 #include "vertex_buffer.h"
 #include "glad/glad.h"
+#include "stream_buffer_opengl.h"
 
 template <class vertex_type>
 vertex_buffer<vertex_type>::vertex_buffer(const triangle<vertex_type>* tri,
@@ -21,9 +22,18 @@ vertex_buffer<vertex_type>::vertex_buffer(const triangle<vertex_type>* tri,
 
 template <class vertex_type>
 vertex_buffer<vertex_type>::vertex_buffer(const vertex_type* vert,
-                                          std::size_t        n)
+                                          std::size_t        n,
+                                          buffer_usage       usage)
     : count(n)
 {
+    stream_buffer_opengl* stream = stream_buffer_opengl::get_current();
+    if (usage == buffer_usage::stream && stream != nullptr &&
+        stream->push_vertexes(vert, n * sizeof(vertex_type), gl_handle, offset))
+    {
+        is_owner = false;
+        return;
+    }
+
     glGenBuffers(1, &gl_handle);
     GL_CHECK_ERRORS()
 
@@ -38,6 +48,8 @@ vertex_buffer<vertex_type>::vertex_buffer(const vertex_type* vert,
 template <class vertex_type>
 vertex_buffer<vertex_type>::~vertex_buffer()
 {
+    if (!is_owner)
+        return;
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     GL_CHECK_ERRORS()
     glDeleteBuffers(1, &gl_handle);
@@ -61,4 +73,5 @@ template class vertex_buffer<vertex3d>;
 template class vertex_buffer<vertex3d_colored>;
 template class vertex_buffer<vertex3d_textured>;
 template class vertex_buffer<vertex3d_colored_textured>;
-template class vertex_buffer<vertex2d_colored_textured>;
\ No newline at end of file
+template class vertex_buffer<vertex2d_colored_textured>;
+template class vertex_buffer<vertex3d_packed>;
\ No newline at end of file
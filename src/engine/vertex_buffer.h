@@ -2,19 +2,31 @@
 #include "core/types.h"
 
 #include <iostream>
+#include <vector>
 
 template <class vertex_type>
 class vertex_buffer
 {
 public:
     vertex_buffer(const triangle<vertex_type>* tri, std::size_t n);
-    vertex_buffer(const vertex_type* vert, std::size_t n);
+    vertex_buffer(const vertex_type* vert,
+                  std::size_t        n,
+                  buffer_usage       usage = buffer_usage::static_draw);
     ~vertex_buffer();
 
     void     bind() const;
     uint32_t size() const;
+    // Byte offset of the first vertex in the bound GL buffer
+    size_t get_offset() const { return offset; }
+
+    // System memory copy, only kept by the software backend
+    const vertex_type* data() const { return vertexes.data(); }
 
 private:
     uint32_t gl_handle{ 0 };
     uint32_t count{ 0 };
+    size_t   offset{ 0 };
+    bool     is_owner{ true };
+
+    std::vector<vertex_type> vertexes;
 };
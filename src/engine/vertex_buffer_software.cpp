@@ -0,0 +1,47 @@
+#include "vertex_buffer.h"
+
+// Software backend counterpart of vertex_buffer.cpp, keeps vertexes in system
+// memory instead of a GL buffer object
+
+template <class vertex_type>
+vertex_buffer<vertex_type>::vertex_buffer(const triangle<vertex_type>* tri,
+                                          std::size_t                  n)
+    : count(static_cast<uint32_t>(n * 3))
+{
+    vertexes.reserve(n * 3);
+    for (std::size_t i = 0; i < n; i++)
+        vertexes.insert(
+            vertexes.end(), tri[i].vertexes.begin(), tri[i].vertexes.end());
+}
+
+template <class vertex_type>
+vertex_buffer<vertex_type>::vertex_buffer(const vertex_type* vert,
+                                          std::size_t        n,
+                                          buffer_usage)
+    : count(static_cast<uint32_t>(n))
+    , vertexes(vert, vert + n)
+{
+}
+
+template <class vertex_type>
+vertex_buffer<vertex_type>::~vertex_buffer()
+{
+}
+
+template <class vertex_type>
+void vertex_buffer<vertex_type>::bind() const
+{
+}
+
+template <class vertex_type>
+uint32_t vertex_buffer<vertex_type>::size() const
+{
+    return count;
+}
+
+template class vertex_buffer<vertex3d>;
+template class vertex_buffer<vertex3d_colored>;
+template class vertex_buffer<vertex3d_textured>;
+template class vertex_buffer<vertex3d_colored_textured>;
+template class vertex_buffer<vertex2d_colored_textured>;
+template class vertex_buffer<vertex3d_packed>;
@@ -1,45 +1,325 @@
 #include "game.h"
+#include "core/mesh_blob.h"
+#include "core/texture_container.h"
 #include "objects/model.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+
 game_tetris::game_tetris()
 {
     state.is_started = 0;
     state.is_restart = 0;
-    state.is_quit    = 0;
-    state.is_rotated = 0;
-    state.is_moving  = 0;
+    input.is_quit    = 0;
+    input.is_rotated = 0;
+    input.is_moving  = 0;
+}
+
+game_tetris::~game_tetris()
+{
+    loader.reset();
+
+    is_simulating = false;
+    if (simulation_thread.joinable())
+        simulation_thread.join();
+
+    set_tracing(false);
+    asset_pack::set_current(nullptr);
+    startup_timeline::set_current(nullptr);
+}
+
+// Runs load() on the loader pool, the upload it returns is queued for the
+// render thread. Errors are rethrown there too.
+template <class F>
+void game_tetris::load_async(std::string name, F&& load)
+{
+    loads_pending++;
+    loader->submit(
+        [this, name = std::move(name), load = std::forward<F>(load)]() mutable
+        {
+            TRACE_THREAD_NAME("loader");
+            std::function<void()> upload;
+            try
+            {
+                startup_timeline::scope s(timeline, name);
+                upload = load();
+            }
+            catch (...)
+            {
+                std::exception_ptr error = std::current_exception();
+                uploads.push([error]() { std::rethrow_exception(error); });
+                return;
+            }
+            uploads.push(
+                [this, name, upload = std::move(upload)]()
+                {
+                    {
+                        startup_timeline::scope s(timeline, "upload " + name);
+                        upload();
+                    }
+                    loads_pending--;
+                });
+        });
+}
+
+void game_tetris::load_texture_async(std::shared_ptr<texture>& slot,
+                                     const char*               path,
+                                     uint32_t                  index)
+{
+    load_async(path,
+               [this, &slot, path, index]()
+               {
+                   texture_source source = my_engine->read_texture(path);
+                   return [this, &slot, index, source]() mutable
+                   {
+                       slot = my_engine->load_texture(index,
+                                                      std::move(source));
+                   };
+               });
+}
+
+// Runs the queued uploads, the game assets are complete once none is left
+void game_tetris::pump_uploads(float budget_ms)
+{
+    uploads.run(budget_ms);
+    if (loads_pending > 0 || is_loaded)
+        return;
+
+    add_figure(figure_board, texture_board.get());
+    is_loaded = true;
+    if (!cfg.hot_reload)
+        loader.reset();
+    timeline.mark("game assets ready");
+}
+
+// Like load_async(), but a failed reload is only logged and the asset keeps
+// its current version. When the same asset is reloaded again before the
+// upload ran, only the newest upload is applied.
+template <class F>
+void game_tetris::reload_async(const std::string& asset, F&& load)
+{
+    const uint64_t generation = ++reload_generations[asset];
+    const auto     start      = steady_clock::now();
+    loader->submit(
+        [this, asset, generation, start, load = std::forward<F>(load)]()
+        {
+            TRACE_THREAD_NAME("loader");
+            std::function<void()> upload;
+            try
+            {
+                upload = load();
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "hot reload: " << asset << ": " << e.what()
+                          << std::endl;
+                return;
+            }
+            uploads.push(
+                [this, asset, generation, start, upload = std::move(upload)]()
+                {
+                    if (reload_generations[asset] != generation)
+                        return;
+                    try
+                    {
+                        upload();
+                    }
+                    catch (const std::exception& e)
+                    {
+                        std::cerr << "hot reload: " << asset << ": "
+                                  << e.what() << std::endl;
+                        return;
+                    }
+                    using ms = duration<double, std::milli>;
+                    std::cout << "hot reload: " << asset << " in "
+                              << ms(steady_clock::now() - start).count()
+                              << " ms" << std::endl;
+                });
+        });
+}
+
+void game_tetris::watch_assets()
+{
+    auto watch = [this](std::initializer_list<std::string> files,
+                        const std::string&                 asset,
+                        reload_job                         job)
+    {
+        for (const std::string& file : files)
+            reload_dependants[file] = asset;
+        reload_jobs[asset] = std::move(job);
+    };
+
+    // Swapped in place, every pointer handed out stays valid
+    watch({ cfg.shader_vertex, cfg.shader_fragment },
+          "scene shaders",
+          [this]() -> std::function<void()>
+          {
+              auto source = shader_opengl::read_source(cfg.shader_vertex,
+                                                       cfg.shader_fragment);
+              return [this, source]() { scene_shaders->reload(source); };
+          });
+
+    for (const char* path : { cfg.texture_board,
+                              cfg.texture_block_1,
+                              cfg.texture_block_2,
+                              cfg.texture_block_3,
+                              cfg.texture_block_4 })
+    {
+        watch({ path, get_texture_container_path(path) },
+              path,
+              [this, path]() -> std::function<void()>
+              {
+                  texture_source source = my_engine->read_texture(path);
+                  return [this, source]() mutable
+                  { my_engine->reload_texture(std::move(source)); };
+              });
+    }
+
+    for (const char* path : { cfg.model_board, cfg.model_cube })
+    {
+        watch({ path, get_mesh_blob_path(path) },
+              path,
+              [this, path]() -> std::function<void()>
+              {
+                  std::shared_ptr<figure> fresh(model(path).get_figure());
+                  return [this, path, fresh]()
+                  {
+                      fresh->upload(cfg.compact_vertices,
+                                    my_engine->has_32bit_indexes());
+                      if (std::shared_ptr<figure> resident = find_figure(path))
+                          resident->swap_geometry(*fresh);
+                  };
+              });
+    }
 
-    figure_board = model(cfg.model_board).get_figure();
-    figure_cube  = model(cfg.model_cube).get_figure();
+    std::vector<std::string> directories;
+    for (const auto& [file, asset] : reload_dependants)
+    {
+        const std::string directory =
+            std::filesystem::path(file).parent_path().generic_string();
+        if (std::find(directories.begin(), directories.end(), directory) ==
+            directories.end())
+            directories.push_back(directory);
+    }
+    watcher = std::make_unique<file_watcher>(directories);
+}
+
+// Starts one reload per changed asset, a shader saved with both stages or a
+// png converted again is still one
+void game_tetris::poll_hot_reload()
+{
+    std::vector<std::string> assets;
+    for (const std::string& file : watcher->get_changes())
+    {
+        auto it = reload_dependants.find(file);
+        if (it == reload_dependants.end() ||
+            std::find(assets.begin(), assets.end(), it->second) !=
+                assets.end())
+            continue;
+        assets.push_back(it->second);
+    }
+    for (const std::string& asset : assets)
+        reload_async(asset, reload_jobs.at(asset));
 }
 
 int game_tetris::initialize(config _cfg)
 {
     cfg = _cfg;
 
+    // The engine adds its own stages, audio init among them
+    startup_timeline::set_current(&timeline);
+
+    {
+        // Hot reload watches the loose files
+        startup_timeline::scope s(timeline, "asset pack");
+        if (cfg.asset_pack_path != nullptr && !cfg.hot_reload &&
+            assets.open(cfg.asset_pack_path))
+        {
+            asset_pack::set_current(&assets);
+        }
+    }
+
+    // Files are read and decoded on the loader pool while the window and the
+    // context are created, only GL uploads come back to this thread. The
+    // menu is drawn while they are pending.
+    loader = std::make_unique<thread_pool>();
+
+    load_async("scene shader source",
+               [this]()
+               {
+                   auto source = shader_opengl::read_source(
+                       cfg.shader_vertex, cfg.shader_fragment);
+                   return [this, source]()
+                   {
+                       scene_shaders = new shader_permutations_opengl(
+                           cfg.shader_vertex, cfg.shader_fragment, source);
+                       scene_shaders->set_quality(cfg.quality);
+                       scene_shaders->prewarm();
+                   };
+               });
+    for (std::shared_ptr<figure>* slot : { &figure_board, &figure_cube })
+    {
+        const char* path =
+            slot == &figure_board ? cfg.model_board : cfg.model_cube;
+        load_async(path,
+                   [this, slot, path]()
+                   {
+                       std::shared_ptr<figure> fig = load_figure(path);
+                       return [this, slot, fig]()
+                       {
+                           fig->upload(cfg.compact_vertices,
+                                       my_engine->has_32bit_indexes());
+                           *slot = fig;
+                       };
+                   });
+    }
+
     cam = new camera(cfg.camera_speed);
-    cam->uniform_link(uniforms);
 
     my_engine = new engine_opengl();
 
-    my_engine->set_uniform(uniforms);
-    if (!my_engine->initialize(cfg))
-        return -1;
+    {
+        startup_timeline::scope s(timeline, "engine initialize");
+        if (!my_engine->initialize(cfg))
+            return -1;
+    }
 
     uniforms.width  = cfg.width;
     uniforms.height = cfg.height;
 
-    shader_scene = new shader_opengl(cfg.shader_vertex, cfg.shader_fragment);
-    my_engine->set_shader(shader_scene);
-
-    texture_board = my_engine->load_texture(1, cfg.texture_board);
-    textures_block.push_back(my_engine->load_texture(2, cfg.texture_block_1));
-    textures_block.push_back(my_engine->load_texture(3, cfg.texture_block_2));
-    textures_block.push_back(my_engine->load_texture(4, cfg.texture_block_3));
-    textures_block.push_back(my_engine->load_texture(5, cfg.texture_block_4));
-
-    add_figure(figure_board, texture_board);
-    my_engine->play_sound(cfg.sound_background_music, true);
+    // Texture decoding needs the context to pick the ETC2 or RGBA8 chain.
+    // Slots are sized up front, the simulation only reads the count.
+    const char* block_paths[] = { cfg.texture_block_1,
+                                  cfg.texture_block_2,
+                                  cfg.texture_block_3,
+                                  cfg.texture_block_4 };
+    textures_block.assign(std::size(block_paths), nullptr);
+    load_texture_async(texture_board, cfg.texture_board, 1);
+    for (size_t i = 0; i < textures_block.size(); i++)
+        load_texture_async(textures_block[i], block_paths[i], uint32_t(i + 2));
+
+    load_async(cfg.sound_collision,
+               [this]()
+               {
+                   my_engine->preload_sound(cfg.sound_collision, false);
+                   return []() {};
+               });
+    load_async(cfg.sound_background_music,
+               [this]()
+               {
+                   my_engine->preload_sound(cfg.sound_background_music, true);
+                   return [this]()
+                   {
+                       my_engine->play_sound(cfg.sound_background_music,
+                                             true,
+                                             sound_priority_music);
+                   };
+               });
 
     window_score_width  = 0.1f * cfg.width;
     window_score_height = 0.06f * cfg.height;
@@ -55,11 +335,48 @@ int game_tetris::initialize(config _cfg)
     window_rotate_x       = 0.8f * cfg.width - 10;
     window_rotate_y       = 10;
 
+    if (cfg.replay_path)
+    {
+        script = std::make_unique<replay>(cfg.replay_path);
+        std::srand(script->get_seed());
+    }
+    if (cfg.frame_times_path)
+    {
+        frame_times.open(cfg.frame_times_path);
+        frame_times << "frame,update_ms,render_ms,total_ms\n";
+    }
+
+    set_profiler_enabled(cfg.show_profiler);
+    if (cfg.trace_path)
+        set_tracing(true);
+    if (cfg.hot_reload)
+        watch_assets();
+
+    // Replays must not depend on load timing
+    if (script)
+    {
+        while (!is_loaded)
+        {
+            uploads.wait();
+            pump_uploads(std::numeric_limits<float>::infinity());
+        }
+    }
+
+    publish_snapshot();
+    if (!script)
+    {
+        is_simulating     = true;
+        simulation_thread = std::thread(&game_tetris::simulate, this);
+    }
+
     return 1;
 };
 
 bool game_tetris::event_listener(event& e)
 {
+    profiler.begin_frame();
+    profiler.begin(frame_profiler::stage::events);
+
     e.clear();
     if (my_engine->event_keyboard(e))
     {
@@ -68,75 +385,86 @@ bool game_tetris::event_listener(event& e)
         {
             return false;
         }
+        if (e.keyboard.f1_clicked)
+        {
+            set_profiler_enabled(!profiler.is_enabled());
+        }
+        if (e.keyboard.f2_clicked)
+        {
+            set_tracing(!trace::is_recording);
+        }
         // Only game buttons
-        if (state.is_started)
+        if (snapshots.read_buffer().is_started)
         {
+            game_command cmd;
             if (e.mouse.left_clicked)
             {
-                state.is_rotated = true;
-                state.is_moving  = true;
+                input.is_rotated = true;
+                input.is_moving  = true;
             }
             if (e.mouse.left_released)
             {
-                state.is_rotated = false;
-                state.is_moving  = false;
+                input.is_rotated = false;
+                input.is_moving  = false;
             }
 #ifdef __ANDROID__
             if (e.motion.x > window_control_width &&
                 e.motion.x < window_rotate_x && !e.mouse.left_clicked)
 #endif
             {
-                if (e.motion.x_rel && state.is_rotated)
+                if ((e.motion.x_rel || e.motion.y_rel) && input.is_rotated)
                 {
 
                     if (abs(e.motion.x_rel) > cfg.max_camera_speed_swipe)
                         e.motion.x_rel = std::copysign(
                             cfg.max_camera_speed_swipe, e.motion.x_rel);
-
-                    camera_angle += e.motion.x_rel * M_PI / 300;
-                }
-                if (e.motion.y_rel && state.is_rotated)
-                {
-
                     if (abs(e.motion.y_rel) > cfg.max_camera_speed_swipe)
                         e.motion.y_rel = std::copysign(
                             cfg.max_camera_speed_swipe, e.motion.y_rel);
 
-                    view_height += e.motion.y_rel / 50;
-                    if (view_height < min_view_height)
-                        view_height = min_view_height;
-                    if (view_height > max_view_height)
-                        view_height = max_view_height;
+                    cmd.kind = game_command::type::orbit_camera;
+                    cmd.dx   = e.motion.x_rel;
+                    cmd.dy   = e.motion.y_rel;
+                    push_command(cmd);
                 }
             }
 
+            cmd.kind = game_command::type::move;
             if (e.keyboard.w_clicked)
             {
-                move_active_cells(direction::forward);
+                cmd.dir = direction::forward;
+                push_command(cmd);
             }
             if (e.keyboard.s_clicked)
             {
-                move_active_cells(direction::backward);
+                cmd.dir = direction::backward;
+                push_command(cmd);
             }
             if (e.keyboard.a_clicked)
             {
-                move_active_cells(direction::left);
+                cmd.dir = direction::left;
+                push_command(cmd);
             }
             if (e.keyboard.d_clicked)
             {
-                move_active_cells(direction::right);
+                cmd.dir = direction::right;
+                push_command(cmd);
             }
+            cmd.kind = game_command::type::rotate;
             if (e.keyboard.left_clicked)
             {
-                rotate_around(axis::x);
+                cmd.ax = axis::x;
+                push_command(cmd);
             }
             if (e.keyboard.down_clicked)
             {
-                rotate_around(axis::y);
+                cmd.ax = axis::y;
+                push_command(cmd);
             }
             if (e.keyboard.right_clicked)
             {
-                rotate_around(axis::z);
+                cmd.ax = axis::z;
+                push_command(cmd);
             }
             // Free Camera
             // if (e.motion.x || e.motion.y)
@@ -163,13 +491,20 @@ bool game_tetris::event_listener(event& e)
             //     cam->set_move_right(false);
         }
     }
+    profiler.end(frame_profiler::stage::events);
     return true;
 };
 
 void game_tetris::update()
 {
-    static std::chrono::steady_clock timer;
-    static auto                      last_time_update = timer.now();
+    TRACE_ZONE("update");
+
+    using clock = std::chrono::steady_clock;
+
+    const bool measure = is_profiling.load(std::memory_order_relaxed);
+    const auto start   = measure ? clock::now() : clock::time_point();
+
+    process_commands();
 
     cam->update();
     cam->set_rotate(
@@ -178,13 +513,111 @@ void game_tetris::update()
                        -view_height,
                        -sqrt(view_height) * std::sin(camera_angle));
 
-    if ((timer.now() - last_time_update).count() < delay * 1e9 ||
-        !state.is_started)
-        return;
-    last_time_update = timer.now();
+    ticks++;
+    if (state.is_started &&
+        ticks - last_drop_tick >= delay * cfg.simulation_rate)
+    {
+        last_drop_tick = ticks;
+        drop_active_cells();
+    }
+
+    publish_snapshot();
+    TRACE_COUNTER("cells", cells.size());
+
+    if (measure)
+        update_ms.store(
+            duration<float, std::milli>(clock::now() - start).count(),
+            std::memory_order_relaxed);
+}
+
+void game_tetris::simulate()
+{
+    TRACE_THREAD_NAME("simulation");
+
+    using clock = std::chrono::steady_clock;
+
+    const auto tick = duration_cast<clock::duration>(
+        duration<double>(1. / cfg.simulation_rate));
+    auto next_tick = clock::now();
+
+    while (is_simulating)
+    {
+        update();
+
+        next_tick += tick;
+        // Don't try to catch up after a long stall (debugger, suspend)
+        if (clock::now() - next_tick > 5 * tick)
+            next_tick = clock::now();
+        std::this_thread::sleep_until(next_tick);
+    }
+}
+
+void game_tetris::process_commands()
+{
+    game_command cmd;
+    while (commands.pop(cmd))
+    {
+        switch (cmd.kind)
+        {
+            case game_command::type::start:
+                if (!state.is_started)
+                    start_game();
+                break;
+            case game_command::type::move:
+                if (state.is_started)
+                    move_active_cells(cmd.dir);
+                break;
+            case game_command::type::rotate:
+                if (state.is_started)
+                    rotate_around(cmd.ax);
+                break;
+            case game_command::type::orbit_camera:
+                camera_angle += cmd.dx * M_PI / 300;
+                view_height += cmd.dy / 50;
+                if (view_height < min_view_height)
+                    view_height = min_view_height;
+                if (view_height > max_view_height)
+                    view_height = max_view_height;
+                break;
+        }
+    }
+}
+
+void game_tetris::publish_snapshot()
+{
+    frame_snapshot& snapshot = snapshots.write_buffer();
+
+    cam->fill_uniform(snapshot.view);
+
+    snapshot.cells_count = std::min<size_t>(cells.size(), cells_capacity);
+    for (size_t i = 0; i < snapshot.cells_count; i++)
+    {
+        cell::position pos = cells[i]->get_position();
+
+        snapshot.cells[i].translate =
+            vector3d(-1. / 2. + (pos.x + 0.5) / cells_max,
+                     (pos.z + 0.5) / cells_max,
+                     -1. / 2. + (pos.y + 0.5) / cells_max);
+        snapshot.cells[i].texture_index = cells[i]->get_texture_index();
+    }
+
+    snapshot.score      = score;
+    snapshot.tick       = ticks;
+    snapshot.collisions = collisions;
+    snapshot.is_started = state.is_started;
+    snapshot.is_restart = state.is_restart;
+
+    snapshots.publish();
+}
+
+void game_tetris::push_command(const game_command& cmd)
+{
+    if (!commands.push(cmd))
+        std::cerr << "game command queue is full, input dropped" << std::endl;
+}
 
-    // check moving
-    bool is_collision = false;
+void game_tetris::drop_active_cells()
+{
     for (cell* c : cells)
     {
         if (!c->get_moving())
@@ -201,12 +634,7 @@ void game_tetris::update()
             c->get_position().z == 0)
             return;
     }
-    // if (is_collision)
-    //{
-    //     collision();
-    //     return;
-    // }
-    //  moving
+
     for (cell* c : cells)
     {
         if (!c->get_moving())
@@ -221,31 +649,169 @@ void game_tetris::update()
 
 void game_tetris::render()
 {
+    TRACE_ZONE("render");
+
+    using clock = std::chrono::steady_clock;
+
+    const auto frame_start = clock::now();
+    if (script)
+    {
+        play_replay_steps();
+        update();
+    }
+    const auto update_end = clock::now();
+    profiler.set_stage_ms(frame_profiler::stage::update,
+                          update_ms.load(std::memory_order_relaxed));
+
+    if (watcher && is_loaded)
+        poll_hot_reload();
+    if (!is_loaded || watcher)
+        pump_uploads(cfg.upload_budget_ms);
+
+    snapshots.update();
+    const frame_snapshot& snapshot = snapshots.read_buffer();
+
+    // One command per landing into the mixer ring, the sound was decoded
+    // at load
+    if (snapshot.collisions != collisions_heard)
+    {
+        const uint64_t landed = std::min(
+            snapshot.collisions - collisions_heard, collision_voices);
+        for (uint64_t i = 0; is_loaded && i < landed; i++)
+            my_engine->play_sound(
+                cfg.sound_collision, false, sound_priority_effect);
+        collisions_heard = snapshot.collisions;
+    }
+
     // ImGui::PushFont(font);
     ImGui::NewFrame();
 
-    if (!state.is_started && !state.is_restart)
+    if (!snapshot.is_started && !snapshot.is_restart)
     {
+        profiler.begin(frame_profiler::stage::ui);
         draw_menu();
     }
-    else if (!state.is_started && state.is_restart)
+    else if (!snapshot.is_started && snapshot.is_restart)
     {
-        draw_restart_menu();
+        profiler.begin(frame_profiler::stage::ui);
+        draw_restart_menu(snapshot);
     }
     else
     {
-        shader_scene->use();
-        render_scene();
-        draw_ui();
+        profiler.begin(frame_profiler::stage::scene);
+        my_engine->begin_scene();
+        my_engine->begin_gpu_pass(gpu_pass::scene);
+        render_scene(snapshot);
+        my_engine->end_gpu_pass(gpu_pass::scene);
+        my_engine->end_scene();
+        profiler.end(frame_profiler::stage::scene);
+
+        profiler.begin(frame_profiler::stage::ui);
+        draw_ui(snapshot);
     }
     ImGui::Render();
+    profiler.end(frame_profiler::stage::ui);
     // ImGui::PopFont();
+
+    profiler.begin(frame_profiler::stage::swap);
     my_engine->swap_buffers();
+    profiler.end(frame_profiler::stage::swap);
+
+    if (frame == 0)
+    {
+        using ms = duration<double, std::milli>;
+        const double first_frame_ms = ms(clock::now() - startup_time).count();
+        std::cout << "startup first_frame_ms=" << first_frame_ms
+                  << " budget_ms=" << cfg.startup_budget_ms << " status="
+                  << (first_frame_ms > cfg.startup_budget_ms ? "over" : "ok")
+                  << std::endl;
+        timeline.mark("first frame");
+    }
+    if (is_loaded && !is_startup_reported)
+    {
+        timeline.print(std::cout);
+        startup_timeline::set_current(nullptr);
+        is_startup_reported = true;
+    }
+
+    if (frame_times.is_open())
+    {
+        using ms = duration<double, std::milli>;
+
+        const auto frame_end = clock::now();
+        frame_times << frame << ',' << ms(update_end - frame_start).count()
+                    << ',' << ms(frame_end - update_end).count() << ','
+                    << ms(frame_end - frame_start).count() << '\n';
+    }
+    frame++;
 };
-void game_tetris::add_figure(figure* fig, texture* tex)
+
+void game_tetris::play_replay_steps()
 {
-    fig->set_texture(tex);
-    figures.push_back(fig);
+    static const std::map<std::string, direction> directions = {
+        { "forward", direction::forward },
+        { "backward", direction::backward },
+        { "left", direction::left },
+        { "right", direction::right },
+    };
+    static const std::map<std::string, axis> axes = {
+        { "x", axis::x },
+        { "y", axis::y },
+        { "z", axis::z },
+    };
+
+    replay::step step;
+    while (script->next(frame, step))
+    {
+        const std::string arg = step.args.empty() ? "" : step.args[0];
+
+        game_command cmd;
+        if (step.action == "start")
+        {
+            cmd.kind = game_command::type::start;
+            push_command(cmd);
+        }
+        else if (step.action == "move" && directions.count(arg))
+        {
+            cmd.kind = game_command::type::move;
+            cmd.dir  = directions.at(arg);
+            push_command(cmd);
+        }
+        else if (step.action == "rotate" && axes.count(arg))
+        {
+            cmd.kind = game_command::type::rotate;
+            cmd.ax   = axes.at(arg);
+            push_command(cmd);
+        }
+        else if (step.action == "orbit" && step.args.size() == 2)
+        {
+            cmd.kind = game_command::type::orbit_camera;
+            cmd.dx   = std::stof(step.args[0]);
+            cmd.dy   = std::stof(step.args[1]);
+            push_command(cmd);
+        }
+        else if (step.action == "capture" && !arg.empty())
+        {
+            my_engine->capture_frame(arg.c_str());
+        }
+        else if (step.action == "quit")
+        {
+            input.is_quit = true;
+        }
+        else
+        {
+            std::cerr << "replay: bad step '" << step.action << "' at frame "
+                      << frame << std::endl;
+        }
+    }
+
+    // Nothing left to play, finish after this frame
+    if (script->is_finished())
+        input.is_quit = true;
+}
+void game_tetris::add_figure(std::shared_ptr<figure> fig, texture* tex)
+{
+    figures.emplace_back(std::move(fig), tex);
 }
 void game_tetris::draw_menu()
 {
@@ -265,22 +831,25 @@ void game_tetris::draw_menu()
                      ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoScrollbar);
     ImGui::SetWindowFontScale(4);
 
-    if (ImGui::Button("Start", button_size))
+    // Shown before the game assets finished loading
+    ImGui::BeginDisabled(!is_loaded);
+    if (ImGui::Button(is_loaded ? "Start" : "Loading", button_size))
     {
-        start_game();
+        push_command(game_command{ game_command::type::start });
     }
+    ImGui::EndDisabled();
     // if (ImGui::Button("Settings", ImVec2(0.15 * cfg.width, 0.05 *
     // cfg.height)))
     // {
     // }
     if (ImGui::Button("Quit", button_size))
     {
-        state.is_quit = true;
+        input.is_quit = true;
     }
 
     ImGui::End();
 }
-void game_tetris::draw_restart_menu()
+void game_tetris::draw_restart_menu(const frame_snapshot& snapshot)
 {
     static const float window_width  = 0.2f * cfg.width;
     static const float window_height = 0.2f * cfg.height;
@@ -296,11 +865,11 @@ void game_tetris::draw_restart_menu()
                      ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoScrollbar);
     ImGui::SetWindowFontScale(2.1);
 
-    ImGui::LabelText("", "Score: %d", score);
+    ImGui::LabelText("", "Score: %zu", snapshot.score);
 
     if (ImGui::Button("Restart", ImVec2(window_width - 15, 0.05 * cfg.height)))
     {
-        start_game();
+        push_command(game_command{ game_command::type::start });
     }
     // if (ImGui::Button("Settings", ImVec2(0.15 * cfg.width, 0.05 *
     // cfg.height)))
@@ -308,13 +877,13 @@ void game_tetris::draw_restart_menu()
     // }
     if (ImGui::Button("Quit", ImVec2(window_width - 15, 0.05 * cfg.height)))
     {
-        state.is_quit = true;
+        input.is_quit = true;
     }
 
     ImGui::End();
 }
 
-void game_tetris::draw_ui()
+void game_tetris::draw_ui(const frame_snapshot& snapshot)
 {
     ImGui::SetNextWindowSize(ImVec2(window_score_width, window_score_height));
     ImGui::SetNextWindowPos(ImVec2(window_score_x, window_score_y));
@@ -325,11 +894,14 @@ void game_tetris::draw_ui()
                      ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoScrollbar);
     ImGui::SetWindowFontScale(2);
 
-    ImGui::Text("Score: %zu", score);
+    ImGui::Text("Score: %zu", snapshot.score);
 
     ImGui::End();
 
+    draw_profiler();
+
 #ifdef __ANDROID__
+    game_command        cmd;
     static const ImVec2 button_rotate_size =
         ImVec2(window_rotate_width - 20, window_rotate_height / 3 - 10);
     static const ImVec2 button_control_size =
@@ -349,22 +921,30 @@ void game_tetris::draw_ui()
 
     if (ImGui::Button("Forvard", button_control_size))
     {
-        move_active_cells(direction::forward);
+        cmd.kind = game_command::type::move;
+        cmd.dir  = direction::forward;
+        push_command(cmd);
     }
     ImGui::SetCursorPos(ImVec2(7, button_control_size.y + 15));
     if (ImGui::Button("Left", button_control_size))
     {
-        move_active_cells(direction::left);
+        cmd.kind = game_command::type::move;
+        cmd.dir  = direction::left;
+        push_command(cmd);
     }
     ImGui::SameLine();
     if (ImGui::Button("Backward", button_control_size))
     {
-        move_active_cells(direction::backward);
+        cmd.kind = game_command::type::move;
+        cmd.dir  = direction::backward;
+        push_command(cmd);
     }
     ImGui::SameLine();
     if (ImGui::Button("Right", button_control_size))
     {
-        move_active_cells(direction::right);
+        cmd.kind = game_command::type::move;
+        cmd.dir  = direction::right;
+        push_command(cmd);
     }
 
     ImGui::End();
@@ -380,63 +960,227 @@ void game_tetris::draw_ui()
     ImGui::SetWindowFontScale(4);
     if (ImGui::Button("Rotate X \naxis", button_rotate_size))
     {
-        rotate_around(axis::x);
+        cmd.kind = game_command::type::rotate;
+        cmd.ax   = axis::x;
+        push_command(cmd);
     }
     if (ImGui::Button("Rotate Y \naxis", button_rotate_size))
     {
-        rotate_around(axis::y);
+        cmd.kind = game_command::type::rotate;
+        cmd.ax   = axis::y;
+        push_command(cmd);
     }
     if (ImGui::Button("Rotate Z \naxis", button_rotate_size))
     {
-        rotate_around(axis::z);
+        cmd.kind = game_command::type::rotate;
+        cmd.ax   = axis::z;
+        push_command(cmd);
     }
     ImGui::End();
 #endif
 }
-void game_tetris::render_scene()
+void game_tetris::set_tracing(bool state)
 {
+    if (state == trace::is_recording)
+        return;
 
-    for (figure* fig : figures)
+    if (state)
     {
-        fig->uniform_link(uniforms);
+        std::cout << "trace: recording" << std::endl;
+        trace::start();
+        return;
+    }
+    trace::stop();
+    trace::save(cfg.trace_path ? cfg.trace_path : "trace.json");
+}
+
+void game_tetris::set_profiler_enabled(bool state)
+{
+    profiler.set_enabled(state);
+    is_profiling = state;
+    my_engine->set_gpu_timing(state);
+}
+
+void game_tetris::draw_profiler()
+{
+    if (!profiler.is_enabled())
+        return;
 
-        vertex_buffer<vertex3d_textured>* vertex_buff = new vertex_buffer(
-            fig->get_vertexes().data(), fig->get_vertexes().size());
-        index_buffer* index_buff = new index_buffer(fig->get_indexes().data(),
-                                                    fig->get_indexes().size());
-        my_engine->reload_uniform();
-        my_engine->render_triangles(
-            vertex_buff, index_buff, fig->get_texture(), 0, index_buff->size());
+    ImGui::SetNextWindowPos(ImVec2(window_score_x,
+                                   window_score_y + window_score_height + 10),
+                            ImGuiCond_FirstUseEver);
+    ImGui::Begin("Profiler",
+                 nullptr,
+                 ImGuiWindowFlags_AlwaysAutoResize |
+                     ImGuiWindowFlags_NoFocusOnAppearing);
 
-        delete vertex_buff;
-        delete index_buff;
+    ImGui::Text("CPU");
+    for (size_t i = 0; i < static_cast<size_t>(frame_profiler::stage::count);
+         i++)
+    {
+        const auto s = static_cast<frame_profiler::stage>(i);
+        ImGui::Text("  %-7s %6.2f ms",
+                    frame_profiler::get_stage_name(s),
+                    profiler.get_stage_ms(s));
     }
-    vertex_buffer<vertex3d_textured>* vertex_buff = new vertex_buffer(
-        figure_cube->get_vertexes().data(), figure_cube->get_vertexes().size());
-    index_buffer* index_buff = new index_buffer(
-        figure_cube->get_indexes().data(), figure_cube->get_indexes().size());
 
-    // render
+    // Passes without a result (no timer queries) are left out
+    static const char* pass_names[] = { "scene", "ui" };
+    float              gpu_ms       = 0.f;
+    bool               has_gpu      = false;
+    for (size_t i = 0; i < static_cast<size_t>(gpu_pass::count); i++)
+    {
+        if (!my_engine->get_gpu_pass_ms(static_cast<gpu_pass>(i), gpu_ms))
+            continue;
+        if (!has_gpu)
+            ImGui::Text("GPU");
+        has_gpu = true;
+        ImGui::Text("  %-7s %6.2f ms", pass_names[i], gpu_ms);
+    }
 
-    for (cell* c : cells)
+    float p50, p95, p99;
+    profiler.get_percentiles(p50, p95, p99);
+    ImGui::Text("frame p50 %.2f  p95 %.2f  p99 %.2f ms", p50, p95, p99);
+    ImGui::Text("textures %.1f MiB",
+                my_engine->get_texture_bytes() / (1024.f * 1024.f));
+    auto show_cache = [](const char* name, const resource_cache_stats& s)
     {
-        figure_cube->set_scale(8. / cells_max, 8. / cells_max, 8. / cells_max);
-        figure_cube->set_translate(
-            vector3d(-1. / 2. + (c->get_position().x + 0.5) / cells_max,
-                     (c->get_position().z + 0.5) / cells_max,
-                     -1. / 2. + (c->get_position().y + 0.5) / cells_max));
-        figure_cube->set_texture(textures_block[c->get_texture_index()]);
-        figure_cube->uniform_link(uniforms);
+        ImGui::Text("%-7s cache %zu resident %.1f MiB, %zu hits %zu misses",
+                    name,
+                    s.resident,
+                    s.resident_bytes / (1024.f * 1024.f),
+                    s.hits,
+                    s.misses);
+    };
+    show_cache("texture", my_engine->get_texture_cache_stats());
+    show_cache("figure", get_figure_cache_stats());
+    ImGui::Text("fence wait %.2f ms", my_engine->get_fence_wait_ms());
 
-        my_engine->reload_uniform();
-        my_engine->render_triangles(vertex_buff,
-                                    index_buff,
-                                    figure_cube->get_texture(),
-                                    0,
-                                    index_buff->size());
+    const audio_stats audio = my_engine->get_audio_stats();
+    if (audio.callbacks == 0)
+    {
+        ImGui::Text("audio %s", audio.backend);
+    }
+    else
+    {
+        ImGui::Text("audio %s, %u frames (%.1f ms)",
+                    audio.backend,
+                    audio.buffer_frames,
+                    audio.budget_ms);
+        ImGui::Text("  mix %.3f ms, max %.3f ms, %u over budget",
+                    audio.callback_ms,
+                    audio.max_callback_ms,
+                    audio.over_budget);
+        if (audio.music_fill >= 0.f)
+            ImGui::Text("  music ring %.0f%% low, %u underruns",
+                        audio.music_fill * 100.f,
+                        audio.underruns);
+    }
+    const float scale = my_engine->get_resolution_scale();
+    ImGui::Text("scene scale %.2f (%dx%d)",
+                scale,
+                static_cast<int>(cfg.width * scale),
+                static_cast<int>(cfg.height * scale));
+
+    ImGui::PlotLines("##frame_times",
+                     profiler.get_history(),
+                     static_cast<int>(profiler.get_history_count()),
+                     static_cast<int>(profiler.get_history_offset()),
+                     nullptr,
+                     0.f,
+                     std::max(33.3f, p99 * 1.2f),
+                     ImVec2(300, 80));
+
+    ImGui::End();
+}
+
+// Draws the static buffers count times, set_instance(i) fills the uniforms
+// of instance i and returns its texture
+template <class vertex_type>
+static void render_instances(
+    engine*                                      eng,
+    vertex_buffer<vertex_type>*                  vertexes,
+    index_buffer*                                indexes,
+    uniform&                                     uniforms,
+    size_t                                       count,
+    const std::function<const texture*(size_t)>& set_instance)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const texture* tex = set_instance(i);
+        eng->set_uniform(uniforms);
+        eng->render_triangles(vertexes, indexes, tex, 0, indexes->size());
     }
-    delete vertex_buff;
-    delete index_buff;
+}
+
+// One pass over the instances per part, a part is the whole figure unless
+// it was split into meshlets
+void game_tetris::render_figure(
+    const figure&                                fig,
+    size_t                                       count,
+    const std::function<const texture*(size_t)>& set_instance)
+{
+    for (const figure_buffers& part : fig.get_buffers())
+    {
+        if (part.packed_vertexes != nullptr)
+        {
+            uniforms.position_scale = fig.get_position_scale();
+            render_instances(my_engine,
+                             part.packed_vertexes.get(),
+                             part.indexes.get(),
+                             uniforms,
+                             count,
+                             set_instance);
+        }
+        else
+        {
+            uniforms.position_scale = 1.f;
+            render_instances(my_engine,
+                             part.vertexes.get(),
+                             part.indexes.get(),
+                             uniforms,
+                             count,
+                             set_instance);
+        }
+    }
+}
+
+void game_tetris::render_scene(const frame_snapshot& snapshot)
+{
+    TRACE_ZONE("render_scene");
+    uniforms        = snapshot.view;
+    uniforms.width  = cfg.width;
+    uniforms.height = cfg.height;
+
+    my_engine->set_shader(scene_shaders->get(material_board));
+    my_engine->set_shader_features(material_board);
+    for (const figure_instance& fig : figures)
+        render_figure(fig.get_figure(),
+                      1,
+                      [&](size_t)
+                      {
+                          fig.fill_uniform(uniforms);
+                          return fig.get_texture();
+                      });
+
+    // One instance moved from cell to cell, the shared figure is only read
+    figure_instance cube(figure_cube);
+    cube.set_scale(8. / cells_max, 8. / cells_max, 8. / cells_max);
+
+    my_engine->set_shader(scene_shaders->get(material_block));
+    my_engine->set_shader_features(material_block);
+    render_figure(*figure_cube,
+                  snapshot.cells_count,
+                  [&](size_t i)
+                  {
+                      const frame_snapshot::cell_instance& c =
+                          snapshot.cells[i];
+
+                      cube.set_translate(c.translate);
+                      cube.set_texture(textures_block[c.texture_index].get());
+                      cube.fill_uniform(uniforms);
+                      return cube.get_texture();
+                  });
 }
 void game_tetris::start_game()
 {
@@ -722,6 +1466,7 @@ bool game_tetris::check_moving(cell*               c,
 
 void game_tetris::find_near(cell* c)
 {
+    TRACE_ZONE("find_near");
     for (int dir = 0; dir != static_cast<int>(direction::last); dir++)
         c->set_cell_near(static_cast<direction>(dir), nullptr);
     cell::position cur_pos = c->get_position();
@@ -748,6 +1493,7 @@ void game_tetris::find_near(cell* c)
 
 void game_tetris::collision()
 {
+    collisions++;
 
     for (cell* c : cells)
     {
@@ -760,6 +1506,7 @@ void game_tetris::collision()
 
 void game_tetris::check_layer()
 {
+    TRACE_ZONE("check_layer");
     std::array<uint8_t, cells_max_z> count{ 0 };
     std::vector<uint8_t>             z_to_delete;
     for (cell* c : cells)
@@ -794,5 +1541,5 @@ void game_tetris::check_layer()
 
 bool game_tetris::get_quit_state() const
 {
-    return state.is_quit;
+    return input.is_quit;
 }
@@ -1,15 +1,32 @@
 #pragma once
+#include "core/asset_pack.h"
 #include "core/event.h"
+#include "core/file_watcher.h"
+#include "core/frame_profiler.h"
+#include "core/replay.h"
+#include "core/trace.h"
+#include "core/spsc_queue.h"
+#include "core/startup_timeline.h"
+#include "core/thread_pool.h"
+#include "core/triple_buffer.h"
 #include "core/types.h"
+#include "core/upload_queue.h"
 #include "engine/engine_opengl.h"
+#include "engine/shader_permutations_opengl.h"
 #include "objects/camera.h"
+#include "objects/figure_instance.h"
 
 #include <array>
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
 
 using namespace std::chrono;
 
-constexpr uint32_t fps = 60;
-
 enum class direction
 {
     left,
@@ -113,9 +130,50 @@ private:
     bool      is_active = true;
 };
 
-constexpr int cells_max    = 5;
-constexpr int cells_max_z  = 14;
-constexpr int cells_z_lose = 10;
+constexpr int cells_max      = 5;
+constexpr int cells_max_z    = 14;
+constexpr int cells_z_lose   = 10;
+constexpr int cells_capacity = cells_max * cells_max * cells_max_z + 4;
+
+// Input sent from the render thread to the simulation thread
+struct game_command
+{
+    enum class type : uint8_t
+    {
+        start,
+        move,
+        rotate,
+        orbit_camera
+    };
+
+    type      kind = type::start;
+    direction dir  = direction::left;
+    axis      ax   = axis::x;
+    float     dx   = 0.f;
+    float     dy   = 0.f;
+};
+
+// Immutable state of one simulation tick, everything the render thread needs
+// to draw a frame
+struct frame_snapshot
+{
+    struct cell_instance
+    {
+        vector3d translate;
+        uint8_t  texture_index = 0;
+    };
+
+    uniform view; // Camera part of uniforms
+
+    std::array<cell_instance, cells_capacity> cells;
+    size_t                                    cells_count = 0;
+
+    size_t   score      = 0;
+    uint64_t tick       = 0;
+    uint64_t collisions = 0; // Landed primitives so far
+    bool     is_started = false;
+    bool     is_restart = false;
+};
 
 class game
 {
@@ -135,21 +193,47 @@ class game_tetris : public game
 {
 public:
     game_tetris();
+    ~game_tetris() override;
 
     int  initialize(config) override;
     bool event_listener(event&) override;
     void update() override;
     void render() override;
 
-    void add_figure(figure* fig, texture* texture);
+    void add_figure(std::shared_ptr<figure> fig, texture* texture);
 
     bool get_quit_state() const;
 
 private:
     void draw_menu();
-    void draw_restart_menu();
-    void draw_ui();
-    void render_scene();
+    void draw_restart_menu(const frame_snapshot& snapshot);
+    void draw_ui(const frame_snapshot& snapshot);
+    void draw_profiler();
+    void set_profiler_enabled(bool state);
+    void set_tracing(bool state);
+    void render_scene(const frame_snapshot& snapshot);
+
+    template <class F>
+    void load_async(std::string name, F&& load);
+    void load_texture_async(std::shared_ptr<texture>& slot,
+                            const char*               path,
+                            uint32_t                  index);
+    void pump_uploads(float budget_ms);
+    void watch_assets();
+    void poll_hot_reload();
+    template <class F>
+    void reload_async(const std::string& asset, F&& load);
+    void render_figure(
+        const figure&                                fig,
+        size_t                                       count,
+        const std::function<const texture*(size_t)>& set_instance);
+
+    void simulate();
+    void process_commands();
+    void publish_snapshot();
+    void push_command(const game_command& cmd);
+    void play_replay_steps();
+    void drop_active_cells();
 
     void               start_game();
     void               lose_game();
@@ -166,36 +250,99 @@ private:
     void collision();
     void check_layer();
 
-    config cfg;
-    size_t score = 0;
-    float  delay = 0.6; // Seconds
+    config   cfg;
+    size_t   score          = 0;
+    float    delay          = 0.6; // Seconds
+    uint64_t ticks          = 0;
+    uint64_t last_drop_tick = 0;
+    uint64_t collisions     = 0;
+
+    std::thread                   simulation_thread;
+    std::atomic<bool>             is_simulating{ false };
+    spsc_queue<game_command, 64>  commands;
+    triple_buffer<frame_snapshot> snapshots;
+
+    // Replay runs the simulation in lockstep, one tick per rendered frame
+    std::unique_ptr<replay> script;
+    uint64_t                frame = 0;
+    std::ofstream           frame_times;
+
+    steady_clock::time_point startup_time = steady_clock::now();
+
+    // Mapped res/ when tools/asset_packer was run, else loose files
+    asset_pack assets;
+
+    // Loader jobs read and decode on the pool, their uploads run on this
+    // thread between frames. The loader is released once all are done,
+    // unless hot reload keeps using it.
+    startup_timeline             timeline{ startup_time };
+    upload_queue                 uploads;
+    std::unique_ptr<thread_pool> loader;
+    size_t                       loads_pending       = 0;
+    bool                         is_loaded           = false;
+    bool                         is_startup_reported = false;
+
+    // Hot reload: a written file maps to the asset built from it, keyed by
+    // the path it was loaded by. Its job rereads it on the loader pool and
+    // returns the swap that runs between frames.
+    using reload_job = std::function<std::function<void()>()>;
+    std::unique_ptr<file_watcher>                watcher;
+    std::unordered_map<std::string, std::string> reload_dependants;
+    std::unordered_map<std::string, reload_job>  reload_jobs;
+    std::unordered_map<std::string, uint64_t>    reload_generations;
+
+    frame_profiler     profiler;
+    std::atomic<bool>  is_profiling{ false }; // Read by the simulation thread
+    std::atomic<float> update_ms{ 0.f };
 
-    uniform              uniforms;
-    figure*              figure_board;
-    figure*              figure_cube;
-    std::vector<figure*> figures;
+    uniform uniforms;
+    // Shared with the figure cache (objects/model.h)
+    std::shared_ptr<figure>      figure_board;
+    std::shared_ptr<figure>      figure_cube;
+    std::vector<figure_instance> figures;
 
     primitive*         active_primitive = nullptr;
     std::vector<cell*> cells;
 
-    shader*               shader_scene  = nullptr;
-    texture*              texture_board = nullptr;
-    std::vector<texture*> textures_block;
+    // Features each material asks for, the quality setting may drop some
+    static constexpr uint32_t material_board =
+        shader_feature::lighting | shader_feature::attenuation;
+    static constexpr uint32_t material_block =
+        material_board | shader_feature::specular;
+
+    // Music keeps its voice when collision sounds pile up
+    static constexpr uint8_t sound_priority_effect = 0;
+    static constexpr uint8_t sound_priority_music  = 1;
+    // Landings in one frame get a voice each up to this many, one more
+    // would only be louder and take voices from the rest
+    static constexpr uint64_t collision_voices = 4;
+    uint64_t                  collisions_heard = 0; // Render thread
+
+    shader_permutations_opengl*           scene_shaders = nullptr;
+    std::shared_ptr<texture>              texture_board;
+    std::vector<std::shared_ptr<texture>> textures_block;
 
     float camera_angle    = -M_PI / 2.f;
     float view_height     = 1.f;
     float min_view_height = 1.f;
     float max_view_height = 1.6f * 8.f / cells_max;
 
+    // Owned by the simulation thread
     struct flags
     {
         uint8_t is_started : 1;
         uint8_t is_restart : 1;
+
+    } state;
+
+    // Owned by the render thread
+    struct input_flags
+    {
         uint8_t is_quit : 1;
         uint8_t is_rotated : 1;
         uint8_t is_moving : 1;
 
-    } state;
+    } input;
 
     float window_score_width;
     float window_score_height;
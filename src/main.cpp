@@ -4,17 +4,37 @@
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
+#include <mutex>
+#include <string>
 
 class android_redirected_buf : public std::streambuf
 {
 public:
-    android_redirected_buf() = default;
+    // Takes over cout, cerr and clog until it is destroyed, the streams
+    // flush once more at exit and must not reach a dead buffer
+    android_redirected_buf()
+        : cout_buf(std::cout.rdbuf(this))
+        , cerr_buf(std::cerr.rdbuf(this))
+        , clog_buf(std::clog.rdbuf(this))
+    {
+    }
+
+    ~android_redirected_buf() override
+    {
+        std::cout.rdbuf(cout_buf);
+        std::cerr.rdbuf(cerr_buf);
+        std::clog.rdbuf(clog_buf);
+    }
 
 private:
     // This android_redirected_buf buffer has no buffer. So every character
-    // "overflows" and can be put directly into the teed buffers.
+    // "overflows" and can be put directly into the teed buffers. Loaders,
+    // the music decoder and the main thread log at once, so every thread
+    // collects its own line and a whole line is written at a time.
     int overflow(int c) override
     {
+        thread_local std::string message;
+
         if (c == EOF)
         {
             return !EOF;
@@ -23,6 +43,7 @@ private:
         {
             if (c == '\n')
             {
+                std::lock_guard<std::mutex> lock(output_mutex);
 #ifdef __ANDROID__
                 // android log function add '\n' on every print itself
                 __android_log_print(
@@ -42,18 +63,90 @@ private:
 
     int sync() override { return 0; }
 
-    std::string message;
+    std::streambuf* cout_buf;
+    std::streambuf* cerr_buf;
+    std::streambuf* clog_buf;
+    std::mutex      output_mutex;
 };
 
 int main(int argc, char* argv[])
 {
     android_redirected_buf logcat;
 
-    std::cout.rdbuf(&logcat);
-    std::cerr.rdbuf(&logcat);
-    std::clog.rdbuf(&logcat);
+    config cfg;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--headless")
+        {
+            cfg.is_headless = true;
+        }
+        else if (arg == "--size" && i + 2 < argc)
+        {
+            cfg.width          = std::atof(argv[++i]);
+            cfg.height         = std::atof(argv[++i]);
+            cfg.is_full_screen = false;
+        }
+        else if (arg == "--hot-reload")
+        {
+            cfg.hot_reload = true;
+        }
+        else if (arg == "--replay" && i + 1 < argc)
+        {
+            cfg.replay_path = argv[++i];
+        }
+        else if (arg == "--frame-times" && i + 1 < argc)
+        {
+            cfg.frame_times_path = argv[++i];
+        }
+        else if (arg == "--trace" && i + 1 < argc)
+        {
+            cfg.trace_path = argv[++i];
+        }
+        else if (arg == "--audio" && i + 1 < argc)
+        {
+            const std::string backend = argv[++i];
+            if (backend == "device")
+                cfg.audio = audio_backend::device;
+            else if (backend == "null")
+                cfg.audio = audio_backend::null;
+            else if (backend == "offline")
+                cfg.audio = audio_backend::offline;
+            else
+                std::cerr << "unknown audio backend: " << backend << std::endl;
+        }
+        else if (arg == "--audio-wav" && i + 1 < argc)
+        {
+            cfg.audio              = audio_backend::offline;
+            cfg.audio_offline_path = argv[++i];
+        }
+        else if (arg == "--audio-buffer" && i + 1 < argc)
+        {
+            cfg.audio_buffer_frames =
+                static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (arg == "--quality" && i + 1 < argc)
+        {
+            const std::string level = argv[++i];
+            if (level == "low")
+                cfg.quality = shader_quality::low;
+            else if (level == "medium")
+                cfg.quality = shader_quality::medium;
+            else if (level == "high")
+                cfg.quality = shader_quality::high;
+            else if (level == "ultra")
+                cfg.quality = shader_quality::ultra;
+            else
+                std::cerr << "unknown quality: " << level << std::endl;
+        }
+        else
+        {
+            std::cerr << "unknown argument: " << arg << std::endl;
+        }
+    }
+
+    TRACE_THREAD_NAME("render");
 
-    config      cfg;
     game_tetris my_game;
 
     if (!my_game.initialize(cfg))
@@ -61,16 +154,11 @@ int main(int argc, char* argv[])
 
     event e{};
 
-    auto time_last = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+    // Game logic ticks on its own thread, this one only polls input and
+    // draws the latest published frame
     while (my_game.event_listener(e) && !my_game.get_quit_state())
     {
-
-        auto time_now = std::chrono::steady_clock::now();
-        if ((time_now - time_last).count() > 1.e9 / fps)
-        {
-            my_game.update();
-            my_game.render();
-        }
+        my_game.render();
     }
 
     return EXIT_SUCCESS;
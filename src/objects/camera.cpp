@@ -9,15 +9,15 @@ camera::camera(float speed)
     this->speed = speed;
 }
 
-void camera::uniform_link(uniform& uni)
+void camera::fill_uniform(uniform& uni) const
 {
-    uni.rotate_alpha_camera = &alpha;
-    uni.rotate_beta_camera  = &beta;
-    uni.rotate_gamma_camera = &gamma;
+    uni.rotate_alpha_camera = alpha;
+    uni.rotate_beta_camera  = beta;
+    uni.rotate_gamma_camera = gamma;
 
-    uni.translate_x_camera = &dx;
-    uni.translate_y_camera = &dy;
-    uni.translate_z_camera = &dz;
+    uni.translate_x_camera = dx;
+    uni.translate_y_camera = dy;
+    uni.translate_z_camera = dz;
 }
 
 void camera::move(float dx, float dy, float dz)
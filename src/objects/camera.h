@@ -6,7 +6,7 @@ class camera : public object
 public:
     camera(float speed);
 
-    void uniform_link(uniform& uni) override;
+    void fill_uniform(uniform& uni) const override;
 
     void move(float dx, float dy, float dz);
     void move_forward(float distance);
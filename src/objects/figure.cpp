@@ -1,29 +1,184 @@
 #include "figure.h"
 
-figure::figure(vector3d start_pos)
-    : physics(start_pos)
-{
-    set_scale(1, 1, 1);
-    set_rotate(0, 0, 0);
-    set_translate(0, 0, 0);
-}
-
-figure::figure()
-    : figure(vector3d(0, 0, 0))
-{
-}
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
 
 void figure::add_figure(const figure& fig)
 {
+    if (vertexes.size() + fig.vertexes.size() > UINT32_MAX)
+    {
+        throw std::runtime_error("can't add figure: more than 2^32 vertexes");
+    }
+
+    const auto base = static_cast<uint32_t>(vertexes.size());
     for (auto ind : fig.indexes)
-        this->indexes.push_back(vertexes.size() + ind);
+        this->indexes.push_back(base + ind);
     for (auto vert : fig.vertexes)
         this->vertexes.push_back(vert);
     count = indexes.size() / 3;
+
+    update_short_indexes();
+
+    // The merged vertexes share one position scale, so repack all of them.
+    // Into an empty figure the packed vertexes are taken as they are.
+    if (base == 0)
+    {
+        packed_vertexes = fig.packed_vertexes;
+        position_scale  = fig.position_scale;
+    }
+    else if (!fig.packed_vertexes.empty() || !packed_vertexes.empty())
+    {
+        pack_vertexes();
+    }
+}
+
+bool figure::pack_vertexes()
+{
+    packed_vertexes.clear();
+
+    float max_coord = 0.f;
+    for (const vertex3d_textured& v : vertexes)
+    {
+        if (v.uv.x < 0.f || v.uv.x > 1.f || v.uv.y < 0.f || v.uv.y > 1.f)
+            return false;
+        max_coord = std::max({ max_coord,
+                               std::abs(v.pos.x),
+                               std::abs(v.pos.y),
+                               std::abs(v.pos.z) });
+    }
+    position_scale = max_coord > 0.f ? max_coord : 1.f;
+
+    packed_vertexes.reserve(vertexes.size());
+    for (const vertex3d_textured& v : vertexes)
+        packed_vertexes.emplace_back(v, position_scale);
+    return true;
+}
+
+size_t figure::get_resident_bytes() const
+{
+    size_t bytes = vertexes.capacity() * sizeof(vertex3d_textured) +
+                   indexes.capacity() * sizeof(uint32_t) +
+                   short_indexes.capacity() * sizeof(uint16_t) +
+                   packed_vertexes.capacity() * sizeof(vertex3d_packed);
+    for (const meshlet& m : meshlets)
+    {
+        bytes += m.vertexes.capacity() * sizeof(vertex3d_textured) +
+                 m.packed_vertexes.capacity() * sizeof(vertex3d_packed) +
+                 m.indexes.capacity() * sizeof(uint16_t);
+    }
+    return bytes;
+}
+
+void figure::swap_geometry(figure& other)
+{
+    vertexes.swap(other.vertexes);
+    indexes.swap(other.indexes);
+    short_indexes.swap(other.short_indexes);
+    packed_vertexes.swap(other.packed_vertexes);
+    meshlets.swap(other.meshlets);
+    buffers.swap(other.buffers);
+    std::swap(position_scale, other.position_scale);
+    std::swap(count, other.count);
+}
+
+template <class index_type>
+static figure_buffers create_buffers(
+    const std::vector<vertex3d_textured>& vertexes,
+    const std::vector<vertex3d_packed>&   packed_vertexes,
+    const std::vector<index_type>&        indexes,
+    bool                                  is_packed)
+{
+    figure_buffers result;
+    if (is_packed)
+        result.packed_vertexes =
+            std::make_unique<vertex_buffer<vertex3d_packed>>(
+                packed_vertexes.data(), packed_vertexes.size());
+    else
+        result.vertexes = std::make_unique<vertex_buffer<vertex3d_textured>>(
+            vertexes.data(), vertexes.size());
+    result.indexes =
+        std::make_unique<index_buffer>(indexes.data(), indexes.size());
+    return result;
+}
+
+void figure::upload(bool is_packed, bool has_32bit_indexes)
+{
+    if (!buffers.empty())
+        return;
+
+    is_packed = is_packed && !packed_vertexes.empty();
+    if (!short_indexes.empty())
+    {
+        buffers.push_back(create_buffers(
+            vertexes, packed_vertexes, short_indexes, is_packed));
+    }
+    else if (has_32bit_indexes)
+    {
+        buffers.push_back(
+            create_buffers(vertexes, packed_vertexes, indexes, is_packed));
+    }
+    else
+    {
+        split_meshlets();
+        for (const meshlet& m : meshlets)
+            buffers.push_back(create_buffers(
+                m.vertexes, m.packed_vertexes, m.indexes, is_packed));
+    }
 }
 
-void figure::update()
+void figure::update_short_indexes()
 {
-    vector3d pos = get_position();
-    set_translate(pos);
+    short_indexes.clear();
+    if (vertexes.size() > UINT16_MAX + 1)
+        return;
+    short_indexes.assign(indexes.begin(), indexes.end());
+}
+
+void figure::split_meshlets()
+{
+    meshlets.clear();
+    if (!short_indexes.empty())
+        return;
+
+    constexpr size_t   max_vertexes = UINT16_MAX + 1;
+    constexpr uint32_t unused       = UINT32_MAX;
+
+    // Figure vertex -> index in the current meshlet
+    std::vector<uint32_t> remap(vertexes.size(), unused);
+    std::vector<uint32_t> used;
+    meshlet               current;
+
+    for (size_t i = 0; i + 2 < indexes.size(); i += 3)
+    {
+        size_t added = 0;
+        for (size_t k = 0; k < 3; k++)
+            added += remap[indexes[i + k]] == unused;
+
+        if (current.vertexes.size() + added > max_vertexes)
+        {
+            meshlets.push_back(std::move(current));
+            current = meshlet();
+            for (uint32_t v : used)
+                remap[v] = unused;
+            used.clear();
+        }
+
+        for (size_t k = 0; k < 3; k++)
+        {
+            const uint32_t v = indexes[i + k];
+            if (remap[v] == unused)
+            {
+                remap[v] = static_cast<uint32_t>(current.vertexes.size());
+                current.vertexes.push_back(vertexes[v]);
+                if (!packed_vertexes.empty())
+                    current.packed_vertexes.push_back(packed_vertexes[v]);
+                used.push_back(v);
+            }
+            current.indexes.push_back(static_cast<uint16_t>(remap[v]));
+        }
+    }
+    if (!current.indexes.empty())
+        meshlets.push_back(std::move(current));
 }
@@ -1,14 +1,33 @@
 #pragma once
-#include "core/physics.h"
-#include "engine/texture.h"
-#include "engine/texture_opengl.h"
-#include "object.h"
+#include "core/types.h"
+#include "engine/index_buffer.h"
+#include "engine/vertex_buffer.h"
 
-class figure : public object, public physics
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Part of a figure addressable with 16 bit indexes
+struct meshlet
+{
+    std::vector<vertex3d_textured> vertexes;
+    std::vector<vertex3d_packed>   packed_vertexes; // As in the figure
+    std::vector<uint16_t>          indexes;
+};
+
+// Static buffers of a figure or of one of its meshlets, holding only the
+// vertex format picked by figure::upload()
+struct figure_buffers
+{
+    std::unique_ptr<vertex_buffer<vertex3d_textured>> vertexes;
+    std::unique_ptr<vertex_buffer<vertex3d_packed>>   packed_vertexes;
+    std::unique_ptr<index_buffer>                     indexes;
+};
+
+// Geometry only, shared by every figure_instance drawn with it
+class figure
 {
 public:
-    figure();
-    figure(vector3d start_pos);
     auto get_triangle(size_t index)
     {
         return triangle(vertexes[indexes[3 * index + 0]],
@@ -20,37 +39,54 @@ public:
     {
         return vertexes;
     }
-    virtual const std::vector<uint16_t>& get_indexes() const { return indexes; }
-
-    void uniform_link(uniform& uni) override
+    virtual const std::vector<uint32_t>& get_indexes() const { return indexes; }
+    // Empty when a vertex is past the 16 bit range
+    const std::vector<uint16_t>& get_short_indexes() const
     {
-
-        uni.rotate_alpha_obj = &alpha;
-        uni.rotate_beta_obj  = &beta;
-        uni.rotate_gamma_obj = &gamma;
-
-        uni.translate_x_obj = &dx;
-        uni.translate_y_obj = &dy;
-        uni.translate_z_obj = &dz;
-
-        uni.scale_x_obj = &scale_x;
-        uni.scale_y_obj = &scale_y;
-        uni.scale_z_obj = &scale_z;
+        return short_indexes;
     }
-
-    void     set_texture(texture* texture) { tex = texture; }
-    texture* get_texture() { return tex; }
+    // Empty until split_meshlets()
+    const std::vector<meshlet>& get_meshlets() const { return meshlets; }
+    // Empty unless pack_vertexes() succeeded
+    const std::vector<vertex3d_packed>& get_packed_vertexes() const
+    {
+        return packed_vertexes;
+    }
+    float get_position_scale() const { return position_scale; }
+    // System memory held by the geometry
+    size_t get_resident_bytes() const;
 
     virtual void add_figure(const figure& fig);
+    // Builds the vertex3d_packed copy, false when uv leaves [0, 1]
+    bool pack_vertexes();
+    // For engines without 32 bit indexes, no-op when short indexes exist.
+    // Call after pack_vertexes(), meshlets copy the packed vertexes.
+    void split_meshlets();
+    // For reloads of a figure that is in use, its instances draw the new
+    // geometry from then on. The buffers are exchanged too.
+    void swap_geometry(figure& other);
 
-    void update();
+    // Creates the static buffers once, render thread only. Packed vertexes
+    // when is_packed and pack_vertexes() succeeded. 16 bit indexes when they
+    // reach every vertex, else 32 bit ones or meshlets without
+    // has_32bit_indexes. Does nothing when the buffers exist.
+    void upload(bool is_packed, bool has_32bit_indexes);
+    // Empty until upload()
+    const std::vector<figure_buffers>& get_buffers() const { return buffers; }
 
 protected:
     std::vector<vertex3d_textured> vertexes;
-    std::vector<uint16_t>          indexes;
+    std::vector<uint32_t>          indexes;
+    std::vector<uint16_t>          short_indexes;
+
+    std::vector<vertex3d_packed> packed_vertexes;
+    float                        position_scale = 1.f;
+
+    size_t count = 0;
 
-    size_t count;
+    void update_short_indexes();
 
 private:
-    texture* tex = nullptr;
+    std::vector<meshlet>        meshlets;
+    std::vector<figure_buffers> buffers;
 };
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include "figure_instance.h"
+
+#include <utility>
+
+figure_instance::figure_instance(std::shared_ptr<const figure> fig,
+                                 texture*                      tex)
+    : physics(vector3d(0, 0, 0))
+    , fig(std::move(fig))
+    , tex(tex)
+{
+    set_scale(1, 1, 1);
+    set_rotate(0, 0, 0);
+    set_translate(0, 0, 0);
+}
+
+void figure_instance::fill_uniform(uniform& uni) const
+{
+    uni.rotate_alpha_obj = alpha;
+    uni.rotate_beta_obj  = beta;
+    uni.rotate_gamma_obj = gamma;
+
+    uni.translate_x_obj = dx;
+    uni.translate_y_obj = dy;
+    uni.translate_z_obj = dz;
+
+    uni.scale_x_obj = scale_x;
+    uni.scale_y_obj = scale_y;
+    uni.scale_z_obj = scale_z;
+}
+
+void figure_instance::update()
+{
+    vector3d pos = get_position();
+    set_translate(pos);
+}
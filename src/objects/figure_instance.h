@@ -0,0 +1,29 @@
+#pragma once
+#include "core/physics.h"
+#include "engine/texture.h"
+#include "figure.h"
+#include "object.h"
+
+#include <memory>
+
+// One placement of a shared figure: transform, texture and physics. Cheap
+// to make, the geometry is only pointed to.
+class figure_instance : public object, public physics
+{
+public:
+    explicit figure_instance(std::shared_ptr<const figure> fig,
+                             texture*                      tex = nullptr);
+
+    const figure& get_figure() const { return *fig; }
+
+    void fill_uniform(uniform& uni) const override;
+
+    void     set_texture(texture* texture) { tex = texture; }
+    texture* get_texture() const { return tex; }
+
+    void update();
+
+private:
+    std::shared_ptr<const figure> fig;
+    texture*                      tex = nullptr;
+};
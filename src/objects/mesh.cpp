@@ -1,14 +1,30 @@
 #include "mesh.h"
 
+#include <utility>
+
 mesh::mesh(std::vector<vertex3d_textured> vertexes,
-           std::vector<uint16_t>          indexes)
+           std::vector<uint32_t>          indexes)
 {
-    set_translate(0, 0, 0);
-    set_rotate(0, 0, 0);
-    set_scale(1, 1, 1);
-
     this->vertexes = vertexes;
     this->indexes  = indexes;
 
     count = indexes.size() / 3;
+
+    update_short_indexes();
+}
+
+mesh::mesh(std::vector<vertex3d_packed> packed_vertexes,
+           float                        position_scale,
+           std::vector<uint32_t>        indexes)
+    : mesh(std::vector<vertex3d_textured>(), std::move(indexes))
+{
+    this->packed_vertexes = std::move(packed_vertexes);
+    this->position_scale  = position_scale;
+
+    vertexes.reserve(this->packed_vertexes.size());
+    for (const vertex3d_packed& v : this->packed_vertexes)
+        vertexes.push_back(v.unpack(position_scale));
+
+    // The delegated constructor saw no vertexes yet
+    update_short_indexes();
 }
\ No newline at end of file
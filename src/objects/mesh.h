@@ -4,5 +4,9 @@ class mesh : public figure
 {
 public:
     mesh(std::vector<vertex3d_textured> vertexes,
-         std::vector<uint16_t>          indexes);
+         std::vector<uint32_t>          indexes);
+    // Keeps the packed vertexes as they are, the float ones are unpacked
+    mesh(std::vector<vertex3d_packed> packed_vertexes,
+         float                        position_scale,
+         std::vector<uint32_t>        indexes);
 };
\ No newline at end of file
@@ -1,10 +1,41 @@
 #include "model.h"
-#include <SDL3/SDL.h>
+#include "core/mesh_blob.h"
+#include "core/trace.h"
+
+#ifdef USE_ASSIMP
+#include "model_import.h"
+#endif
+
+#include <iostream>
 #include <stdexcept>
+#include <string>
+
+static resource_cache<figure>& get_figure_cache()
+{
+    static resource_cache<figure> cache;
+    return cache;
+}
 
 model::model(const char* path)
 {
-    load_model(path);
+    TRACE_ZONE("model::model");
+
+    if (load_baked(path))
+        return;
+
+#ifdef USE_ASSIMP
+    std::vector<vertex3d_textured> vertexes;
+    std::vector<uint32_t>          indexes;
+    import_model(path, vertexes, indexes);
+
+    meshes.emplace_back(vertexes, indexes);
+    if (!meshes.back().pack_vertexes())
+        std::cout << path << ": uv outside [0, 1], keeping float vertexes"
+                  << std::endl;
+#else
+    throw std::runtime_error("no baked mesh for " + std::string(path) +
+                             ", build the bake_meshes target");
+#endif
 }
 
 std::vector<mesh>& model::get_meshes()
@@ -15,93 +46,46 @@ std::vector<mesh>& model::get_meshes()
 figure* model::get_figure()
 {
     figure* fig = new figure();
-    for (auto mesh : meshes)
+    for (const mesh& m : meshes)
     {
-        fig->add_figure(mesh);
+        fig->add_figure(m);
     }
     return fig;
 }
 
-void model::load_model(const char* path)
+bool model::load_baked(const char* path)
 {
-    Assimp::Importer import;
-    // const aiScene*   scene =
-    //     import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
-    membuff*       file = load_file_to_memory(path);
-    const aiScene* scene =
-        import.ReadFileFromMemory(static_cast<void*>(file->ptr.get()),
-                                  file->size,
-                                  aiProcess_Triangulate | aiProcess_FlipUVs);
-
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
-        !scene->mRootNode)
-    {
-        throw std::runtime_error("ERROR::ASSIMP::" +
-                                 std::string(import.GetErrorString()));
-    }
+    const std::string blob_path = get_mesh_blob_path(path);
 
-    process_node(scene->mRootNode, scene);
+    mesh_blob blob;
+    if (!read_mesh_blob(blob_path.c_str(), blob))
+        return false;
 
-    //delete file;
+    if (blob.format == mesh_blob::vertex_format::packed)
+        meshes.emplace_back(std::move(blob.packed_vertexes),
+                            blob.position_scale,
+                            std::move(blob.indexes));
+    else
+        meshes.emplace_back(std::move(blob.vertexes), std::move(blob.indexes));
+    return true;
 }
 
-void model::process_node(aiNode* node, const aiScene* scene)
+std::shared_ptr<figure> load_figure(const char* path)
 {
-    for (unsigned int i = 0; i < node->mNumMeshes; i++)
-    {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(process_mesh(mesh, scene));
-    }
-
-    for (unsigned int i = 0; i < node->mNumChildren; i++)
-    {
-        process_node(node->mChildren[i], scene);
-    }
+    return get_figure_cache().get(path,
+                                  [path]()
+                                  {
+                                      return std::shared_ptr<figure>(
+                                          model(path).get_figure());
+                                  });
 }
 
-mesh model::process_mesh(aiMesh* m, const aiScene* scene)
+std::shared_ptr<figure> find_figure(const char* path)
 {
-    std::vector<vertex3d_textured> vertixes;
-    std::vector<uint16_t>          indexes;
-    // vector<texture>      textures;
-
-    for (unsigned int i = 0; i < m->mNumVertices; i++)
-    {
-        vertex3d_textured v;
-        if (m->mTextureCoords[0])
-        {
-            v = vertex3d_textured(
-                vertex3d(
-                    m->mVertices[i].x, m->mVertices[i].y, m->mVertices[i].z),
-                vector2d(m->mTextureCoords[0][i].x, m->mTextureCoords[0][i].y));
-        }
-        else
-        {
-            v = vertex3d_textured(vertex3d(m->mVertices[i].x,
-                                           m->mVertices[i].y,
-                                           m->mVertices[i].z),
-                                  vector2d(0, 0));
-        }
-        // if (m->mNormals)
-        // {
-        v.normal.x = m->mNormals[i].x;
-        v.normal.y = m->mNormals[i].y;
-        v.normal.z = m->mNormals[i].z;
-        // }
-
-        vertixes.push_back(v);
-    }
-
-    for (unsigned int i = 0; i < m->mNumFaces; i++)
-    {
-        aiFace face = m->mFaces[i];
-        for (unsigned int j = 0; j < face.mNumIndices; j++)
-            indexes.push_back(static_cast<uint32_t>(face.mIndices[j]));
-    }
-
-    // if (m->mMaterialIndex >= 0)
-    // {
-    // }
+    return get_figure_cache().find(path);
+}
 
-    return mesh(vertixes, indexes);
+resource_cache_stats get_figure_cache_stats()
+{
+    return get_figure_cache().get_stats();
 }
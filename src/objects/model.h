@@ -1,13 +1,14 @@
+#include "core/resource_cache.h"
 #include "objects/mesh.h"
 
-#include <assimp/Importer.hpp>
-#include <assimp/postprocess.h>
-#include <assimp/scene.h>
+#include <memory>
 
 class model
 {
 public:
-    model(const char* path);
+    // Loads the mesh blob baked by tools/mesh_baker next to path. Without
+    // one, builds with USE_ASSIMP import the model itself, others throw.
+    explicit model(const char* path);
 
     std::vector<mesh>& get_meshes();
     figure*            get_figure();
@@ -15,10 +16,12 @@ public:
 private:
     std::vector<mesh> meshes;
 
-    void load_model(const char* path);
-    void process_node(aiNode* node, const aiScene* scene);
-    mesh process_mesh(aiMesh* mesh, const aiScene* scene);
-    // std::vector<Texture> load_material_textures(aiMaterial*   mat,
-    //                                             aiTextureType type,
-    //                                             string        typeName);
-};
\ No newline at end of file
+    bool load_baked(const char* path);
+};
+
+// Figure of the model at path, shared while any handle to it is alive. It
+// is geometry only, a figure_instance per placement adds the transform.
+std::shared_ptr<figure> load_figure(const char* path);
+// The resident figure for path or nullptr, never loads
+std::shared_ptr<figure> find_figure(const char* path);
+resource_cache_stats    get_figure_cache_stats();
@@ -0,0 +1,87 @@
+#include "model_import.h"
+#include "core/asset_pack.h"
+#include "core/trace.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <stdexcept>
+#include <string>
+
+static void process_mesh(const aiMesh*                   m,
+                         std::vector<vertex3d_textured>& vertexes,
+                         std::vector<uint32_t>&          indexes)
+{
+    TRACE_ZONE("process_mesh");
+
+    const auto base = static_cast<uint32_t>(vertexes.size());
+    for (unsigned int i = 0; i < m->mNumVertices; i++)
+    {
+        vertex3d_textured v;
+        if (m->mTextureCoords[0])
+        {
+            v = vertex3d_textured(
+                vertex3d(
+                    m->mVertices[i].x, m->mVertices[i].y, m->mVertices[i].z),
+                vector2d(m->mTextureCoords[0][i].x, m->mTextureCoords[0][i].y));
+        }
+        else
+        {
+            v = vertex3d_textured(vertex3d(m->mVertices[i].x,
+                                           m->mVertices[i].y,
+                                           m->mVertices[i].z),
+                                  vector2d(0, 0));
+        }
+        v.normal.x = m->mNormals[i].x;
+        v.normal.y = m->mNormals[i].y;
+        v.normal.z = m->mNormals[i].z;
+
+        vertexes.push_back(v);
+    }
+
+    for (unsigned int i = 0; i < m->mNumFaces; i++)
+    {
+        const aiFace& face = m->mFaces[i];
+        for (unsigned int j = 0; j < face.mNumIndices; j++)
+            indexes.push_back(base + face.mIndices[j]);
+    }
+}
+
+static void process_node(const aiNode*                   node,
+                         const aiScene*                  scene,
+                         std::vector<vertex3d_textured>& vertexes,
+                         std::vector<uint32_t>&          indexes)
+{
+    for (unsigned int i = 0; i < node->mNumMeshes; i++)
+        process_mesh(scene->mMeshes[node->mMeshes[i]], vertexes, indexes);
+
+    for (unsigned int i = 0; i < node->mNumChildren; i++)
+        process_node(node->mChildren[i], scene, vertexes, indexes);
+}
+
+void import_model(const char*                     path,
+                  std::vector<vertex3d_textured>& vertexes,
+                  std::vector<uint32_t>&          indexes)
+{
+    TRACE_ZONE("import_model");
+
+    Assimp::Importer import;
+    membuff          storage;
+    const asset_view file  = load_asset(path, storage);
+    const aiScene*   scene =
+        import.ReadFileFromMemory(file.data,
+                                  file.size,
+                                  aiProcess_Triangulate | aiProcess_FlipUVs);
+
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
+        !scene->mRootNode)
+    {
+        throw std::runtime_error("ERROR::ASSIMP::" +
+                                 std::string(import.GetErrorString()));
+    }
+
+    vertexes.clear();
+    indexes.clear();
+    process_node(scene->mRootNode, scene, vertexes, indexes);
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include "core/types.h"
+
+#include <cstdint>
+#include <vector>
+
+// Imports a model through Assimp, every mesh in the file merged into one
+// triangle list. Used by tools/mesh_baker, the game only links it when
+// built with TETRIS_IMPORT_MODELS.
+void import_model(const char*                     path,
+                  std::vector<vertex3d_textured>& vertexes,
+                  std::vector<uint32_t>&          indexes);
@@ -11,7 +11,7 @@ public:
     virtual void set_translate(float dx, float dy, float dz);
     virtual void set_translate(vector3d pos);
     virtual void set_scale(float scale_x, float scale_y, float scale_z);
-    virtual void uniform_link(uniform& uni){};
+    virtual void fill_uniform(uniform& uni) const {};
 
 protected:
     float alpha = 0.f;
@@ -13,7 +13,7 @@ primitive::primitive()
 {
 }
 
-void primitive::add_figure(const figure& fig)
+void primitive::add_figure(const figure_instance& fig)
 {
     figures.push_back(fig);
 }
@@ -22,7 +22,7 @@ void primitive::update()
 {
     vector3d pos = get_position();
     set_translate(pos);
-    for (figure& fig : figures)
+    for (figure_instance& fig : figures)
     {
         fig.set_translate(pos);
     }
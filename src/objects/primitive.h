@@ -1,4 +1,4 @@
-#include "figure.h"
+#include "figure_instance.h"
 
 class primitive : object, physics
 {
@@ -6,7 +6,7 @@ public:
     primitive(vector3d start_pos);
     primitive();
 
-    void add_figure(const figure& fig);
+    void add_figure(const figure_instance& fig);
 
     auto begin() const { return figures.begin(); };
     auto end() const { return figures.end(); };
@@ -14,5 +14,5 @@ public:
     void update();
 
 private:
-    std::vector<figure> figures;
+    std::vector<figure_instance> figures;
 };
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "core/asset_pack.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Packs every file under the given directories into one asset pack
+// (core/asset_pack.h). Run it from the repository root, assets are named by
+// their path relative to it, the way config refers to them.
+//
+// usage: asset_packer <output.pack> <directory>...
+//
+// Source art (.blend) is skipped. Convert textures and bake meshes first so
+// the .texc and .mesh files are packed with the rest.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+bool is_packed(const fs::path& path)
+{
+    return path.extension() != ".blend";
+}
+
+std::vector<char> read_file(const fs::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("can't read " + path.generic_string());
+    return std::vector<char>(std::istreambuf_iterator<char>(file),
+                             std::istreambuf_iterator<char>());
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: asset_packer <output.pack> <directory>..."
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        std::vector<std::string> names;
+        for (int i = 2; i < argc; i++)
+        {
+            for (const auto& item : fs::recursive_directory_iterator(argv[i]))
+            {
+                if (item.is_regular_file() && is_packed(item.path()))
+                    names.push_back(item.path().generic_string());
+            }
+        }
+        // Same pack for the same tree, whatever the directory order
+        std::sort(names.begin(), names.end());
+
+        std::vector<std::vector<char>> payloads;
+        size_t                         total = 0;
+        for (const std::string& name : names)
+        {
+            payloads.push_back(read_file(name));
+            total += payloads.back().size();
+        }
+
+        write_asset_pack(argv[1], names, payloads);
+        std::cout << argv[1] << ": " << names.size() << " assets, "
+                  << total / 1024 << " KiB of payload, "
+                  << fs::file_size(argv[1]) / 1024 << " KiB packed"
+                  << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+#include "core/audio_mix.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Mixes N voices of noise into a 48 kHz stereo bus the way audio_mixer does,
+// with no audio device: mix_add() per voice, the limiter and one conversion
+// to S16. The same mix done with plain loops checks the kernels and the
+// old path, S16 with a clip at every add, is timed for comparison.
+//
+// usage: audio_benchmark [iterations] [voices]
+
+namespace
+{
+constexpr uint32_t freq     = 48000;
+constexpr uint32_t channels = 2;
+constexpr uint32_t frames   = 1024; // One device callback
+
+template <class F>
+double best_ms(int iterations, F&& run)
+{
+    using clock = std::chrono::steady_clock;
+    double best = 1e30;
+    for (int i = 0; i < iterations; i++)
+    {
+        const auto start = clock::now();
+        run();
+        best = std::min(
+            best,
+            std::chrono::duration<double, std::milli>(clock::now() - start)
+                .count());
+    }
+    return best;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1000;
+    const int voices     = argc > 2 ? std::max(1, std::atoi(argv[2])) : 16;
+
+    const size_t samples = size_t(frames) * channels;
+
+    // Quiet enough that a few voices stay under the limiter threshold
+    std::mt19937                          random(99);
+    std::uniform_real_distribution<float> noise(-0.25f, 0.25f);
+    std::vector<std::vector<float>>       sources(voices);
+    std::vector<std::vector<int16_t>>     sources_s16(voices);
+    std::vector<float>                    gains(voices);
+    std::vector<float>                    pans(voices);
+    for (int v = 0; v < voices; v++)
+    {
+        sources[v].resize(samples);
+        sources_s16[v].resize(samples);
+        for (size_t i = 0; i < samples; i++)
+        {
+            sources[v][i]     = noise(random);
+            sources_s16[v][i] = static_cast<int16_t>(sources[v][i] * 32767);
+        }
+        gains[v] = 0.5f + 0.5f * v / voices;
+        pans[v]  = -1.f + 2.f * v / voices;
+    }
+
+    std::vector<float>   bus(samples);
+    std::vector<int16_t> out(samples);
+    audio_limiter        limiter(freq);
+    const double         bus_ms = best_ms(
+        iterations,
+        [&]()
+        {
+            std::fill(bus.begin(), bus.end(), 0.f);
+            for (int v = 0; v < voices; v++)
+                mix_add(bus.data(),
+                        sources[v].data(),
+                        frames,
+                        channels,
+                        gains[v],
+                        pans[v]);
+            limiter.process(bus.data(), frames, channels);
+            mix_convert(bus.data(), samples, sample_format::s16, out.data());
+        });
+
+    // Same bus with scalar loops, before the limiter
+    std::vector<float> reference(samples, 0.f);
+    for (int v = 0; v < voices; v++)
+    {
+        const float left  = gains[v] * std::min(1.f, 1.f - pans[v]);
+        const float right = gains[v] * std::min(1.f, 1.f + pans[v]);
+        for (size_t i = 0; i < samples; i++)
+            reference[i] += sources[v][i] * (i % 2 == 0 ? left : right);
+    }
+    std::fill(bus.begin(), bus.end(), 0.f);
+    for (int v = 0; v < voices; v++)
+        mix_add(
+            bus.data(), sources[v].data(), frames, channels, gains[v], pans[v]);
+    float error = 0.f;
+    for (size_t i = 0; i < samples; i++)
+        error = std::max(error, std::fabs(bus[i] - reference[i]));
+    if (error > 1e-5f)
+    {
+        std::cerr << "mix_add differs from the scalar mix by " << error
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<int16_t> clipped(samples);
+    const double         clip_ms = best_ms(
+        iterations,
+        [&]()
+        {
+            std::fill(clipped.begin(), clipped.end(), int16_t(0));
+            for (int v = 0; v < voices; v++)
+            {
+                const int volume = static_cast<int>(gains[v] * 128);
+                for (size_t i = 0; i < samples; i++)
+                {
+                    const int x = clipped[i] + sources_s16[v][i] * volume / 128;
+                    clipped[i]  = static_cast<int16_t>(
+                        std::clamp(x, -32768, 32767));
+                }
+            }
+        });
+
+    const double block_ms = 1000.0 * frames / freq;
+    std::cout << std::fixed << std::setprecision(4) << voices << " voices, "
+              << frames << " frames of " << channels << " channels at "
+              << freq << " Hz (" << block_ms << " ms)" << std::endl
+              << "float bus: " << bus_ms << " ms, "
+              << bus_ms * 1e6 / (double(voices) * frames)
+              << " ns per voice frame, " << 100.0 * bus_ms / block_ms
+              << "% of real time, limiter gain " << limiter.get_gain()
+              << std::endl
+              << "s16 clip per add: " << clip_ms << " ms, "
+              << clip_ms / std::max(bus_ms, 1e-9) << "x the float bus"
+              << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,359 @@
+#include "etc2.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace
+{
+// Intensity modifiers {a, b}, a selector picks +a, +b, -a or -b
+constexpr int etc_modifiers[8][2] = { { 2, 8 },   { 5, 17 },  { 9, 29 },
+                                      { 13, 42 }, { 18, 60 }, { 24, 80 },
+                                      { 33, 106 }, { 47, 183 } };
+
+constexpr int eac_modifiers[16][8] = {
+    { -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+    { -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 },
+    { -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+    { -2, -6, -8, -10, 1, 5, 7, 9 },  { -2, -5, -8, -10, 1, 4, 7, 9 },
+    { -2, -4, -8, -10, 1, 3, 7, 9 },  { -2, -5, -7, -10, 1, 4, 6, 9 },
+    { -3, -4, -7, -10, 2, 3, 6, 9 },  { -1, -2, -3, -10, 0, 1, 2, 9 },
+    { -4, -6, -8, -9, 3, 5, 7, 8 },   { -3, -5, -7, -9, 2, 4, 6, 8 }
+};
+
+int clamp255(int value)
+{
+    return std::min(std::max(value, 0), 255);
+}
+
+int selector_modifier(int table, int selector)
+{
+    const int magnitude = etc_modifiers[table][selector & 1];
+    return selector & 2 ? -magnitude : magnitude;
+}
+
+// Bits of pixel (x, y) in the selector planes, columns first
+int pixel_bit(int x, int y)
+{
+    return x * 4 + y;
+}
+
+bool in_second_subblock(int x, int y, bool flip)
+{
+    return flip ? y >= 2 : x >= 2;
+}
+
+struct subblock_fit
+{
+    int error = INT_MAX;
+    int table = 0;
+    int selectors[16]{}; // Indexed by pixel_bit
+};
+
+// Best intensity table and per pixel selectors for one half of the block
+void fit_subblock(const uint8_t pixels[64],
+                  bool          flip,
+                  int           subblock,
+                  const int     base[3],
+                  subblock_fit& fit)
+{
+    fit.error = INT_MAX;
+    for (int table = 0; table < 8; table++)
+    {
+        int error = 0;
+        int selectors[16]{};
+        for (int y = 0; y < 4; y++)
+        {
+            for (int x = 0; x < 4; x++)
+            {
+                if (in_second_subblock(x, y, flip) != (subblock == 1))
+                    continue;
+
+                const uint8_t* p          = pixels + (y * 4 + x) * 4;
+                int            best       = INT_MAX;
+                int            best_index = 0;
+                for (int selector = 0; selector < 4; selector++)
+                {
+                    const int m = selector_modifier(table, selector);
+                    int       e = 0;
+                    for (int c = 0; c < 3; c++)
+                    {
+                        const int d = clamp255(base[c] + m) - p[c];
+                        e += d * d;
+                    }
+                    if (e < best)
+                    {
+                        best       = e;
+                        best_index = selector;
+                    }
+                }
+                error += best;
+                selectors[pixel_bit(x, y)] = best_index;
+            }
+        }
+        if (error < fit.error)
+        {
+            fit.error = error;
+            fit.table = table;
+            std::copy(selectors, selectors + 16, fit.selectors);
+        }
+    }
+}
+
+void average_subblock(const uint8_t pixels[64],
+                      bool          flip,
+                      int           subblock,
+                      float         average[3])
+{
+    float sum[3] = { 0.f, 0.f, 0.f };
+    for (int y = 0; y < 4; y++)
+    {
+        for (int x = 0; x < 4; x++)
+        {
+            if (in_second_subblock(x, y, flip) != (subblock == 1))
+                continue;
+            for (int c = 0; c < 3; c++)
+                sum[c] += pixels[(y * 4 + x) * 4 + c];
+        }
+    }
+    for (int c = 0; c < 3; c++)
+        average[c] = sum[c] / 8.f;
+}
+
+int quantize(float value, int max)
+{
+    return static_cast<int>(std::lround(value * max / 255.f));
+}
+
+int expand4(int value)
+{
+    return (value << 4) | value;
+}
+
+int expand5(int value)
+{
+    return (value << 3) | (value >> 2);
+}
+
+void store_bits(uint64_t bits, uint8_t block[8])
+{
+    for (int i = 0; i < 8; i++)
+        block[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+}
+
+uint64_t load_bits(const uint8_t block[8])
+{
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; i++)
+        bits = (bits << 8) | block[i];
+    return bits;
+}
+} // namespace
+
+void encode_etc2_rgb_block(const uint8_t pixels[64], uint8_t block[8])
+{
+    uint64_t best_bits  = 0;
+    int      best_error = INT_MAX;
+
+    for (int flip = 0; flip < 2; flip++)
+    {
+        float average[2][3];
+        average_subblock(pixels, flip, 0, average[0]);
+        average_subblock(pixels, flip, 1, average[1]);
+
+        // Differential mode: 5 bit base plus a 3 bit signed delta, only
+        // valid while the delta fits, else ETC2 reads it as another mode
+        int  q5[2][3];
+        bool is_differential = true;
+        for (int c = 0; c < 3; c++)
+        {
+            q5[0][c]    = quantize(average[0][c], 31);
+            q5[1][c]    = quantize(average[1][c], 31);
+            const int d = q5[1][c] - q5[0][c];
+            is_differential &= d >= -4 && d <= 3;
+        }
+
+        for (int differential = 0; differential < 2; differential++)
+        {
+            if (differential && !is_differential)
+                continue;
+
+            int      base[2][3];
+            uint64_t bits = 0;
+            for (int c = 0; c < 3; c++)
+            {
+                const int shift = 56 - 8 * c;
+                if (differential)
+                {
+                    base[0][c]  = expand5(q5[0][c]);
+                    base[1][c]  = expand5(q5[1][c]);
+                    const int d = q5[1][c] - q5[0][c];
+                    bits |= uint64_t(q5[0][c]) << (shift + 3);
+                    bits |= uint64_t(d & 7) << shift;
+                }
+                else
+                {
+                    const int q0 = quantize(average[0][c], 15);
+                    const int q1 = quantize(average[1][c], 15);
+                    base[0][c]   = expand4(q0);
+                    base[1][c]   = expand4(q1);
+                    bits |= uint64_t(q0) << (shift + 4);
+                    bits |= uint64_t(q1) << shift;
+                }
+            }
+
+            subblock_fit fits[2];
+            fit_subblock(pixels, flip, 0, base[0], fits[0]);
+            fit_subblock(pixels, flip, 1, base[1], fits[1]);
+            const int error = fits[0].error + fits[1].error;
+            if (error >= best_error)
+                continue;
+
+            bits |= uint64_t(fits[0].table) << 37;
+            bits |= uint64_t(fits[1].table) << 34;
+            bits |= uint64_t(differential) << 33;
+            bits |= uint64_t(flip) << 32;
+            for (int y = 0; y < 4; y++)
+            {
+                for (int x = 0; x < 4; x++)
+                {
+                    const int bit = pixel_bit(x, y);
+                    const int selector =
+                        fits[in_second_subblock(x, y, flip)].selectors[bit];
+                    bits |= uint64_t(selector >> 1) << (16 + bit);
+                    bits |= uint64_t(selector & 1) << bit;
+                }
+            }
+            best_error = error;
+            best_bits  = bits;
+        }
+    }
+
+    store_bits(best_bits, block);
+}
+
+void decode_etc2_rgb_block(const uint8_t block[8], uint8_t pixels[64])
+{
+    const uint64_t bits         = load_bits(block);
+    const bool     differential = (bits >> 33) & 1;
+    const bool     flip         = (bits >> 32) & 1;
+    const int      tables[2]    = { int(bits >> 37) & 7, int(bits >> 34) & 7 };
+
+    int base[2][3];
+    for (int c = 0; c < 3; c++)
+    {
+        const int shift = 56 - 8 * c;
+        if (differential)
+        {
+            const int q0 = int(bits >> (shift + 3)) & 31;
+            int       d  = int(bits >> shift) & 7;
+            d            = d >= 4 ? d - 8 : d;
+            base[0][c]   = expand5(q0);
+            base[1][c]   = expand5((q0 + d) & 31);
+        }
+        else
+        {
+            base[0][c] = expand4(int(bits >> (shift + 4)) & 15);
+            base[1][c] = expand4(int(bits >> shift) & 15);
+        }
+    }
+
+    for (int y = 0; y < 4; y++)
+    {
+        for (int x = 0; x < 4; x++)
+        {
+            const int bit      = pixel_bit(x, y);
+            const int selector = int((bits >> (16 + bit)) & 1) << 1 |
+                                 int((bits >> bit) & 1);
+            const int subblock = in_second_subblock(x, y, flip);
+            const int m = selector_modifier(tables[subblock], selector);
+
+            uint8_t* p = pixels + (y * 4 + x) * 4;
+            for (int c = 0; c < 3; c++)
+                p[c] = static_cast<uint8_t>(clamp255(base[subblock][c] + m));
+            p[3] = 255;
+        }
+    }
+}
+
+void encode_eac_alpha_block(const uint8_t pixels[64], uint8_t block[8])
+{
+    int lo = 255;
+    int hi = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        lo = std::min<int>(lo, pixels[i * 4 + 3]);
+        hi = std::max<int>(hi, pixels[i * 4 + 3]);
+    }
+
+    int      best_error = INT_MAX;
+    uint64_t best_bits  = 0;
+
+    for (int table = 0; table < 16; table++)
+    {
+        const int* modifiers = eac_modifiers[table];
+        const int  span      = modifiers[7] - modifiers[3];
+        // Stretch the table over [lo, hi], neighbours cover rounding
+        const int multiplier = (hi - lo + span / 2) / span;
+        for (int mul = std::max(1, multiplier - 1);
+             mul <= std::min(15, multiplier + 1);
+             mul++)
+        {
+            const int center = lo - modifiers[3] * mul;
+            for (int base = clamp255(center - 1); base <= clamp255(center + 1);
+                 base++)
+            {
+                uint64_t bits = uint64_t(base) << 56 | uint64_t(mul) << 52 |
+                                uint64_t(table) << 48;
+                int error = 0;
+                for (int y = 0; y < 4; y++)
+                {
+                    for (int x = 0; x < 4; x++)
+                    {
+                        const int a    = pixels[(y * 4 + x) * 4 + 3];
+                        int       best = INT_MAX;
+                        int       index = 0;
+                        for (int i = 0; i < 8; i++)
+                        {
+                            const int d =
+                                clamp255(base + modifiers[i] * mul) - a;
+                            if (d * d < best)
+                            {
+                                best  = d * d;
+                                index = i;
+                            }
+                        }
+                        error += best;
+                        bits |= uint64_t(index) << (45 - 3 * pixel_bit(x, y));
+                    }
+                }
+                if (error < best_error)
+                {
+                    best_error = error;
+                    best_bits  = bits;
+                }
+            }
+        }
+    }
+
+    store_bits(best_bits, block);
+}
+
+void decode_eac_alpha_block(const uint8_t block[8], uint8_t pixels[64])
+{
+    const uint64_t bits       = load_bits(block);
+    const int      base       = int(bits >> 56) & 255;
+    const int      multiplier = int(bits >> 52) & 15;
+    const int*     modifiers  = eac_modifiers[int(bits >> 48) & 15];
+
+    for (int y = 0; y < 4; y++)
+    {
+        for (int x = 0; x < 4; x++)
+        {
+            const int index = int(bits >> (45 - 3 * pixel_bit(x, y))) & 7;
+            const int alpha = base + modifiers[index] * multiplier;
+            pixels[(y * 4 + x) * 4 + 3] = static_cast<uint8_t>(clamp255(alpha));
+        }
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+
+// ETC2 block codec for the texture converter. Color blocks are encoded in
+// the ETC1 compatible individual/differential modes, which every ETC2
+// decoder accepts. Blocks are 4x4 RGBA8 pixels, rows top to bottom.
+
+// 8 byte GL_COMPRESSED_RGB8_ETC2 block, alpha is ignored
+void encode_etc2_rgb_block(const uint8_t pixels[64], uint8_t block[8]);
+// 8 byte EAC alpha half of a GL_COMPRESSED_RGBA8_ETC2_EAC block
+void encode_eac_alpha_block(const uint8_t pixels[64], uint8_t block[8]);
+
+// Inverses, used to report the encoding error
+void decode_etc2_rgb_block(const uint8_t block[8], uint8_t pixels[64]);
+void decode_eac_alpha_block(const uint8_t block[8], uint8_t pixels[64]);
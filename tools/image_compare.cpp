@@ -0,0 +1,70 @@
+#include "core/png.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Compares a captured frame against a golden image.
+//
+// usage: image_compare <golden.png> <actual.png> [tolerance] [max_bad_pixels]
+//
+// A pixel is bad when any channel differs by more than tolerance (default 2,
+// software GL drivers don't round identically). Exits with 1 when the number
+// of bad pixels exceeds max_bad_pixels (default 0).
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: image_compare <golden.png> <actual.png> "
+                     "[tolerance] [max_bad_pixels]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const int    tolerance      = argc > 3 ? std::atoi(argv[3]) : 2;
+    const size_t max_bad_pixels = argc > 4 ? std::atoll(argv[4]) : 0;
+
+    std::vector<std::byte> golden;
+    std::vector<std::byte> actual;
+    unsigned long          golden_w = 0, golden_h = 0;
+    unsigned long          actual_w = 0, actual_h = 0;
+    try
+    {
+        get_pixels_from_png(argv[1], golden, golden_w, golden_h);
+        get_pixels_from_png(argv[2], actual, actual_w, actual_h);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (golden_w != actual_w || golden_h != actual_h)
+    {
+        std::cerr << "size mismatch: " << golden_w << "x" << golden_h
+                  << " vs " << actual_w << "x" << actual_h << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    size_t bad_pixels = 0;
+    int    max_diff   = 0;
+    for (size_t i = 0; i < golden.size(); i += 4)
+    {
+        int diff = 0;
+        for (size_t c = 0; c < 4; c++)
+            diff = std::max(diff,
+                            std::abs(std::to_integer<int>(golden[i + c]) -
+                                     std::to_integer<int>(actual[i + c])));
+        max_diff = std::max(max_diff, diff);
+        if (diff > tolerance)
+            bad_pixels++;
+    }
+
+    std::cout << argv[2] << ": " << bad_pixels << " bad pixels, max diff "
+              << max_diff << std::endl;
+
+    return bad_pixels > max_bad_pixels ? EXIT_FAILURE : EXIT_SUCCESS;
+}
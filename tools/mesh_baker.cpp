@@ -0,0 +1,93 @@
+#include "core/mesh_blob.h"
+#include "core/mesh_optimizer.h"
+#include "objects/mesh.h"
+#include "objects/model_import.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Imports models through Assimp, welds their vertexes, reorders triangles
+// for the post-transform cache and vertexes for fetch locality, and writes
+// the result as a mesh blob (core/mesh_blob.h) in vertex3d_packed format
+// when the uvs allow it. Prints the ACMR before and after.
+//
+// usage: mesh_baker <model.obj>...
+//
+// Each model.obj is written as model.mesh next to it, the game loads only
+// that file.
+
+namespace
+{
+// Typical post-transform FIFO sizes of mobile and desktop GPUs
+constexpr size_t cache_sizes[] = { 16, 32 };
+
+void print_acmr(const char* label, const std::vector<uint32_t>& indexes)
+{
+    std::cout << "  " << label << " ACMR";
+    for (size_t size : cache_sizes)
+        std::cout << " " << get_acmr(indexes, size) << " (" << size << ")";
+    std::cout << std::endl;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: mesh_baker <model.obj>..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    for (int i = 1; i < argc; i++)
+    {
+        const char*       input  = argv[i];
+        const std::string output = get_mesh_blob_path(input);
+        try
+        {
+            std::vector<vertex3d_textured> vertexes;
+            std::vector<uint32_t>          indexes;
+            import_model(input, vertexes, indexes);
+            const size_t imported_vertexes = vertexes.size();
+
+            std::cout << output << ": " << indexes.size() / 3
+                      << " triangles" << std::endl;
+            print_acmr("imported", indexes);
+
+            weld_vertexes(vertexes, indexes);
+            optimize_vertex_cache(indexes, vertexes.size());
+            optimize_vertex_fetch(vertexes, indexes);
+
+            print_acmr("baked   ", indexes);
+            std::cout << "  vertexes " << imported_vertexes << " -> "
+                      << vertexes.size() << std::endl;
+
+            mesh      baked(vertexes, indexes);
+            mesh_blob blob;
+            if (baked.pack_vertexes())
+            {
+                blob.format          = mesh_blob::vertex_format::packed;
+                blob.position_scale  = baked.get_position_scale();
+                blob.packed_vertexes = baked.get_packed_vertexes();
+            }
+            else
+            {
+                std::cout << "  uv outside [0, 1], keeping float vertexes"
+                          << std::endl;
+                blob.vertexes = vertexes;
+            }
+            blob.indexes = indexes;
+            write_mesh_blob(output.c_str(), blob);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << input << ": " << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
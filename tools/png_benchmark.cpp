@@ -0,0 +1,131 @@
+#include "core/picopng.hxx"
+#include "core/png.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Decodes png files with picopng and with decode_png (core/png.h), checks
+// that both give the same pixels and reports the best time of each.
+//
+// usage: png_benchmark [iterations] [file.png...]
+//
+// Without files every png in res/textures is used, run it from the
+// repository root.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+std::vector<std::byte> read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("can't read " + path);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+    std::vector<std::byte> result(bytes.size());
+    std::copy(bytes.begin(),
+              bytes.end(),
+              reinterpret_cast<char*>(result.data()));
+    return result;
+}
+
+template <class F>
+double best_ms(int iterations, F&& run)
+{
+    using clock = std::chrono::steady_clock;
+    double best = 1e30;
+    for (int i = 0; i < iterations; i++)
+    {
+        const auto start = clock::now();
+        run();
+        best = std::min(
+            best,
+            std::chrono::duration<double, std::milli>(clock::now() - start)
+                .count());
+    }
+    return best;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10;
+
+    std::vector<std::string> paths(argv + std::min(argc, 2), argv + argc);
+    if (paths.empty())
+    {
+        for (const auto& item : fs::directory_iterator("res/textures"))
+        {
+            if (item.path().extension() == ".png")
+                paths.push_back(item.path().generic_string());
+        }
+        std::sort(paths.begin(), paths.end());
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    double total_picopng = 0;
+    double total_decode  = 0;
+    try
+    {
+        for (const std::string& path : paths)
+        {
+            const std::vector<std::byte> file = read_file(path);
+
+            png_info info;
+            if (!read_png_info(file.data(), file.size(), info))
+                throw std::runtime_error("not a png: " + path);
+
+            std::vector<std::byte> reference;
+            unsigned long          w = 0;
+            unsigned long          h = 0;
+            const double           picopng_ms = best_ms(
+                iterations,
+                [&]()
+                {
+                    if (decodePNG(reference, w, h, file.data(), file.size()))
+                        throw std::runtime_error("picopng failed: " + path);
+                });
+
+            std::vector<std::byte> pixels(size_t(info.width) * info.height *
+                                          4);
+            const double           decode_ms = best_ms(
+                iterations,
+                [&]()
+                {
+                    decode_png(
+                        file.data(), file.size(), pixels.data(), pixels.size());
+                });
+
+            if (pixels != reference)
+                throw std::runtime_error("pixels differ: " + path);
+
+            total_picopng += picopng_ms;
+            total_decode += decode_ms;
+            std::cout << path << " " << info.width << "x" << info.height
+                      << " color type " << int(info.color_type)
+                      << ": picopng " << picopng_ms << " ms, decode_png "
+                      << decode_ms << " ms, " << picopng_ms / decode_ms
+                      << "x" << std::endl;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "total: picopng " << total_picopng << " ms, decode_png "
+              << total_decode << " ms, "
+              << total_picopng / std::max(total_decode, 1e-9) << "x"
+              << std::endl;
+    return EXIT_SUCCESS;
+}
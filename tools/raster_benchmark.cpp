@@ -0,0 +1,125 @@
+#include "engine/engine_software.h"
+#include "imgui/imgui.h"
+#include "objects/figure_instance.h"
+#include "objects/model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Renders the tetris board with a grid of cubes through engine_software and
+// reports throughput for several render thread counts.
+//
+// usage: raster_benchmark [frames] [cubes] [output.png]
+
+int main(int argc, char* argv[])
+{
+    const int   frames = argc > 1 ? std::atoi(argv[1]) : 100;
+    const int   cubes  = argc > 2 ? std::atoi(argv[2]) : 125;
+    const char* output = argc > 3 ? argv[3] : "raster_benchmark.png";
+
+    config cfg;
+
+    std::shared_ptr<figure> figure_board = load_figure(cfg.model_board);
+    std::shared_ptr<figure> figure_cube  = load_figure(cfg.model_cube);
+    figure_instance         board(figure_board);
+    figure_instance         cube(figure_cube);
+
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> thread_counts = { 1, 2, 4, 8, hardware };
+    std::sort(thread_counts.begin(), thread_counts.end());
+    thread_counts.erase(
+        std::unique(thread_counts.begin(), thread_counts.end()),
+        thread_counts.end());
+
+    std::cout << "resolution " << cfg.width << "x" << cfg.height << ", "
+              << frames << " frames, " << cubes << " cubes" << std::endl;
+
+    for (unsigned threads : thread_counts)
+    {
+        cfg.software_render_threads = threads;
+
+        engine_software renderer;
+        renderer.initialize(cfg);
+
+        std::shared_ptr<texture> texture_board =
+            renderer.load_texture(1, cfg.texture_board);
+        std::shared_ptr<texture> texture_block =
+            renderer.load_texture(2, cfg.texture_block_1);
+
+        vertex_buffer<vertex3d_textured> board_vertexes(
+            figure_board->get_vertexes().data(),
+            figure_board->get_vertexes().size());
+        index_buffer board_indexes(figure_board->get_indexes().data(),
+                                   figure_board->get_indexes().size());
+        vertex_buffer<vertex3d_textured> cube_vertexes(
+            figure_cube->get_vertexes().data(),
+            figure_cube->get_vertexes().size());
+        index_buffer cube_indexes(figure_cube->get_indexes().data(),
+                                  figure_cube->get_indexes().size());
+
+        uniform uniforms;
+        uniforms.width              = cfg.width;
+        uniforms.height             = cfg.height;
+        uniforms.translate_y_camera = -0.6f;
+        uniforms.translate_z_camera = 1.4f;
+
+        size_t triangles = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            ImGui::NewFrame();
+            ImGui::Begin("raster_benchmark");
+            ImGui::Text("frame %d", frame);
+            ImGui::End();
+            ImGui::Render();
+
+            board.fill_uniform(uniforms);
+            renderer.set_uniform(uniforms);
+            renderer.render_triangles(&board_vertexes,
+                                      &board_indexes,
+                                      texture_board.get(),
+                                      0,
+                                      board_indexes.size());
+
+            cube.set_scale(8. / 5., 8. / 5., 8. / 5.);
+            for (int i = 0; i < cubes; i++)
+            {
+                cube.set_translate(-0.5 + (i % 5 + 0.5) / 5.,
+                                   (i / 25 + 0.5) / 5.,
+                                   -0.5 + (i / 5 % 5 + 0.5) / 5.);
+                cube.fill_uniform(uniforms);
+                renderer.set_uniform(uniforms);
+                renderer.render_triangles(&cube_vertexes,
+                                          &cube_indexes,
+                                          texture_block.get(),
+                                          0,
+                                          cube_indexes.size());
+            }
+
+            renderer.swap_buffers();
+            triangles += renderer.get_triangles_drawn();
+        }
+        const double seconds = std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+
+        std::cout << "threads " << threads << ": " << frames / seconds
+                  << " fps, " << triangles / seconds / 1e6 << " Mtri/s"
+                  << std::endl;
+
+        if (threads == thread_counts.back())
+            renderer.save_frame(output);
+
+        texture_board.reset();
+        texture_block.reset();
+        renderer.uninitialize();
+    }
+
+    return EXIT_SUCCESS;
+}
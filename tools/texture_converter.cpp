@@ -0,0 +1,254 @@
+#include "core/png.h"
+#include "core/texture_container.h"
+#include "core/thread_pool.h"
+#include "etc2.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Converts png textures into texture containers (core/texture_container.h)
+// with a full mip chain in ETC2 and RGBA8, and reports the memory and
+// sampling bandwidth against the plain RGBA8 upload.
+//
+// usage: texture_converter <texture.png>...
+//
+// Each texture.png is written as texture.texc next to it, texture_opengl
+// prefers that file when it exists.
+
+namespace
+{
+using level = texture_container::level;
+
+level downsample(const level& src)
+{
+    level dst;
+    dst.width  = std::max(1u, src.width / 2);
+    dst.height = std::max(1u, src.height / 2);
+    dst.data.resize(size_t(dst.width) * dst.height * 4);
+
+    auto in  = reinterpret_cast<const uint8_t*>(src.data.data());
+    auto out = reinterpret_cast<uint8_t*>(dst.data.data());
+    for (uint32_t y = 0; y < dst.height; y++)
+    {
+        const uint32_t y0 = std::min(y * 2, src.height - 1);
+        const uint32_t y1 = std::min(y * 2 + 1, src.height - 1);
+        for (uint32_t x = 0; x < dst.width; x++)
+        {
+            const uint32_t x0 = std::min(x * 2, src.width - 1);
+            const uint32_t x1 = std::min(x * 2 + 1, src.width - 1);
+            for (int c = 0; c < 4; c++)
+            {
+                const int sum = in[(y0 * src.width + x0) * 4 + c] +
+                                in[(y0 * src.width + x1) * 4 + c] +
+                                in[(y1 * src.width + x0) * 4 + c] +
+                                in[(y1 * src.width + x1) * 4 + c];
+                out[(y * dst.width + x) * 4 + c] =
+                    static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+    return dst;
+}
+
+// Encodes one level, block rows go to the pool. Edge blocks repeat the
+// last row and column.
+level compress(const level&              src,
+               texture_container::format format,
+               thread_pool&              pool)
+{
+    const uint32_t blocks_x = (src.width + 3) / 4;
+    const uint32_t blocks_y = (src.height + 3) / 4;
+    const size_t   block_size =
+        format == texture_container::format::etc2_rgba8 ? 16 : 8;
+
+    level dst;
+    dst.width  = src.width;
+    dst.height = src.height;
+    dst.data.resize(get_texture_level_size(format, src.width, src.height));
+
+    auto in  = reinterpret_cast<const uint8_t*>(src.data.data());
+    auto out = reinterpret_cast<uint8_t*>(dst.data.data());
+    pool.parallel_for(
+        blocks_y,
+        [&](size_t by)
+        {
+            uint8_t pixels[64];
+            for (uint32_t bx = 0; bx < blocks_x; bx++)
+            {
+                for (uint32_t y = 0; y < 4; y++)
+                {
+                    const uint32_t sy =
+                        std::min<uint32_t>(by * 4 + y, src.height - 1);
+                    for (uint32_t x = 0; x < 4; x++)
+                    {
+                        const uint32_t sx =
+                            std::min(bx * 4 + x, src.width - 1);
+                        std::memcpy(pixels + (y * 4 + x) * 4,
+                                    in + (size_t(sy) * src.width + sx) * 4,
+                                    4);
+                    }
+                }
+
+                uint8_t* block = out + (by * blocks_x + bx) * block_size;
+                if (block_size == 16)
+                {
+                    encode_eac_alpha_block(pixels, block);
+                    block += 8;
+                }
+                encode_etc2_rgb_block(pixels, block);
+            }
+        });
+    return dst;
+}
+
+// PSNR of the decoded level against the source over all four channels
+double measure_psnr(const level&              src,
+                    const level&              compressed,
+                    texture_container::format format)
+{
+    const uint32_t blocks_x   = (src.width + 3) / 4;
+    const size_t   block_size =
+        format == texture_container::format::etc2_rgba8 ? 16 : 8;
+
+    auto   in     = reinterpret_cast<const uint8_t*>(src.data.data());
+    auto   blocks = reinterpret_cast<const uint8_t*>(compressed.data.data());
+    double sum    = 0.0;
+    for (uint32_t y = 0; y < src.height; y++)
+    {
+        for (uint32_t x = 0; x < src.width; x++)
+        {
+            const uint8_t* block =
+                blocks + ((y / 4) * blocks_x + x / 4) * block_size;
+            uint8_t pixels[64];
+            if (block_size == 16)
+            {
+                decode_etc2_rgb_block(block + 8, pixels);
+                decode_eac_alpha_block(block, pixels);
+            }
+            else
+            {
+                decode_etc2_rgb_block(block, pixels);
+            }
+
+            const uint8_t* decoded = pixels + ((y % 4) * 4 + x % 4) * 4;
+            const uint8_t* source  = in + (size_t(y) * src.width + x) * 4;
+            for (int c = 0; c < 4; c++)
+            {
+                const double d = double(decoded[c]) - source[c];
+                sum += d * d;
+            }
+        }
+    }
+    const double mse = sum / (double(src.width) * src.height * 4);
+    return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+size_t chain_size(const texture_container& chain)
+{
+    size_t size = 0;
+    for (const level& l : chain.levels)
+        size += l.data.size();
+    return size;
+}
+
+double mib(size_t bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: texture_converter <texture.png>..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    thread_pool pool;
+
+    size_t total_plain      = 0;
+    size_t total_compressed = 0;
+
+    std::cout << std::fixed << std::setprecision(2);
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string input = argv[i];
+        const std::string output = get_texture_container_path(argv[i]);
+
+        texture_container rgba;
+        texture_container compressed;
+        try
+        {
+            unsigned long width  = 0;
+            unsigned long height = 0;
+            level         base;
+            get_pixels_from_png(input.c_str(), base.data, width, height);
+            base.width  = static_cast<uint32_t>(width);
+            base.height = static_cast<uint32_t>(height);
+
+            rgba.chain_format = texture_container::format::rgba8;
+            rgba.levels.push_back(std::move(base));
+            while (rgba.levels.back().width > 1 ||
+                   rgba.levels.back().height > 1)
+            {
+                rgba.levels.push_back(downsample(rgba.levels.back()));
+            }
+
+            // EAC alpha only when something is not opaque
+            const std::vector<std::byte>& pixels = rgba.levels[0].data;
+            bool is_opaque = true;
+            for (size_t p = 3; p < pixels.size() && is_opaque; p += 4)
+                is_opaque = pixels[p] == std::byte{ 255 };
+            compressed.chain_format =
+                is_opaque ? texture_container::format::etc2_rgb8
+                          : texture_container::format::etc2_rgba8;
+
+            for (const level& l : rgba.levels)
+                compressed.levels.push_back(
+                    compress(l, compressed.chain_format, pool));
+
+            write_texture_container(output.c_str(), compressed, rgba);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << input << ": " << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        const level& base = rgba.levels[0];
+        const size_t plain =
+            get_texture_level_size(rgba.chain_format, base.width, base.height);
+        const size_t compressed_size = chain_size(compressed);
+        const bool   has_alpha =
+            compressed.chain_format == texture_container::format::etc2_rgba8;
+
+        total_plain += plain;
+        total_compressed += compressed_size;
+
+        std::cout << output << ": " << base.width << "x" << base.height << ", "
+                  << rgba.levels.size() << " levels, "
+                  << (has_alpha ? "etc2_rgba8" : "etc2_rgb8") << std::endl
+                  << "  rgba8 " << mib(plain) << " MiB, rgba8 + mips "
+                  << mib(chain_size(rgba)) << " MiB, etc2 + mips "
+                  << mib(compressed_size) << " MiB ("
+                  << double(plain) / compressed_size << "x smaller)"
+                  << std::endl
+                  << "  sampling 32 -> " << (has_alpha ? 8 : 4)
+                  << " bits/texel, PSNR "
+                  << measure_psnr(
+                         base, compressed.levels[0], compressed.chain_format)
+                  << " dB" << std::endl;
+    }
+
+    std::cout << "total: rgba8 " << mib(total_plain) << " MiB -> etc2 + mips "
+              << mib(total_compressed) << " MiB" << std::endl;
+
+    return EXIT_SUCCESS;
+}